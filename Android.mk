@@ -35,12 +35,17 @@ LOCAL_SRC_FILES := \
     ast_cpp.cpp \
     ast_java.cpp \
     code_writer.cpp \
+    dep_graph.cpp \
+    dispatch_table.cpp \
     generate_cpp.cpp \
     generate_java.cpp \
     generate_java_binder.cpp \
     import_resolver.cpp \
     io_delegate.cpp \
     options.cpp \
+    size_report.cpp \
+    stats.cpp \
+    trace.cpp \
     type_cpp.cpp \
     type_java.cpp \
     type_namespace.cpp \
@@ -81,15 +86,26 @@ LOCAL_CFLAGS := -g -DUNIT_TEST -Wall -Werror
 # Tragically, the code is riddled with unused parameters.
 LOCAL_CLANG_CFLAGS := -Wno-unused-parameter
 LOCAL_SRC_FILES := \
+    aidl_language_unittest.cpp \
     ast_cpp_unittest.cpp \
     ast_java_unittest.cpp \
+    dep_graph_unittest.cpp \
+    dispatch_table_unittest.cpp \
     generate_cpp_unittest.cpp \
     options_unittest.cpp \
+    resolved_interface_unittest.cpp \
+    size_report_unittest.cpp \
+    stats_unittest.cpp \
     test_main.cpp \
+    tests/class_loaders_test_data.cpp \
     tests/end_to_end_tests.cpp \
     tests/example_interface_test_data.cpp \
     tests/fake_io_delegate.cpp \
+    tests/primitive_lists_test_data.cpp \
+    tests/scale_tests.cpp \
+    tests/synthetic_corpus.cpp \
     tests/test_util.cpp \
+    trace_unittest.cpp \
     type_cpp_unittest.cpp \
     type_java_unittest.cpp \
 
@@ -105,6 +121,30 @@ LOCAL_STATIC_LIBRARIES := \
 LOCAL_LDLIBS_linux := -lrt
 
 include $(BUILD_HOST_NATIVE_TEST)
+
+# Benchmarks
+include $(CLEAR_VARS)
+LOCAL_MODULE := aidl_benchmarks
+
+LOCAL_CFLAGS := -Wall -Werror
+LOCAL_CLANG_CFLAGS := -Wno-unused-parameter
+LOCAL_SRC_FILES := \
+    tests/aidl_benchmarks.cpp \
+    tests/fake_io_delegate.cpp \
+    tests/synthetic_corpus.cpp \
+    tests/test_util.cpp \
+
+LOCAL_SHARED_LIBRARIES := \
+    libchrome-host \
+
+LOCAL_STATIC_LIBRARIES := \
+    libaidl-common \
+    $(aidl_static_libraries) \
+    libgoogle-benchmark \
+
+LOCAL_LDLIBS_linux := -lrt
+
+include $(BUILD_HOST_EXECUTABLE)
 endif # HOST_OS == linux
 
 endif # No TARGET_BUILD_APPS or TARGET_BUILD_PDK
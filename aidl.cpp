@@ -16,7 +16,10 @@
 
 #include "aidl.h"
 
+#include <algorithm>
+#include <atomic>
 #include <fcntl.h>
+#include <functional>
 #include <iostream>
 #include <map>
 #include <stdio.h>
@@ -26,20 +29,31 @@
 #include <sys/stat.h>
 #include <unistd.h>
 
+#ifndef _WIN32
+#include <thread>
+#endif
+
 #ifdef _WIN32
 #include <io.h>
 #include <direct.h>
 #include <sys/stat.h>
 #endif
 
+#include <base/strings.h>
 
 #include "aidl_language.h"
+#include "code_writer.h"
+#include "dep_graph.h"
 #include "generate_cpp.h"
 #include "generate_java.h"
 #include "import_resolver.h"
 #include "logging.h"
 #include "options.h"
 #include "os.h"
+#include "resolved_interface.h"
+#include "size_report.h"
+#include "stats.h"
+#include "trace.h"
 #include "type_cpp.h"
 #include "type_java.h"
 #include "type_namespace.h"
@@ -66,10 +80,12 @@ namespace {
 const int kMinUserSetMethodId = 0;
 const int kMaxUserSetMethodId = 16777214;
 
-bool check_filename(const std::string& filename,
-                    const std::string& package,
-                    const std::string& name,
-                    unsigned line) {
+// Returns whether |filename| is where a type |name| in |package| should be
+// declared, and sets |out_expected| to the relative path it should have.
+bool matches_filename(const std::string& filename,
+                      const std::string& package,
+                      const std::string& name,
+                      string* out_expected) {
     const char* p;
     string expected;
     string fn;
@@ -134,54 +150,72 @@ bool check_filename(const std::string& filename,
 #endif
     }
 
-    if (!valid) {
+    if (out_expected) {
+        *out_expected = expected;
+    }
+    return valid;
+}
+
+bool check_filename(const std::string& filename,
+                    const std::string& package,
+                    const std::string& name,
+                    unsigned line) {
+    string expected;
+    if (!matches_filename(filename, package, name, &expected)) {
         fprintf(stderr, "%s:%d interface %s should be declared in a file"
                 " called %s.\n",
                 filename.c_str(), line, name.c_str(), expected.c_str());
+        return false;
     }
-
-    return valid;
+    return true;
 }
 
-bool check_filenames(const std::string& filename, const AidlDocumentItem* items) {
-  if (! items)
+// Checks that one of the types declared in |document| is named after
+// |filename|.  The rest may be named freely.
+bool check_filenames(const std::string& filename,
+                     const AidlDocument& document) {
+  if (document.IsEmpty())
     return true;
 
-  if (items->item_type == INTERFACE_TYPE_BINDER) {
-    const AidlInterface* c = reinterpret_cast<const AidlInterface*>(items);
-    return check_filename(filename, c->GetPackage(), c->GetName(), c->GetLine());
+  for (const auto& interface : document.GetInterfaces()) {
+    if (matches_filename(filename, interface->GetPackage(),
+                         interface->GetName(), nullptr))
+      return true;
+  }
+  for (const auto& parcelable : document.GetParcelables()) {
+    if (matches_filename(filename, parcelable->GetPackage(),
+                         parcelable->GetName(), nullptr))
+      return true;
   }
 
-  bool success = true;
-
-  for (const AidlParcelable* p = reinterpret_cast<const AidlParcelable*>(items);
-       p; p = p->next)
-    success &= check_filename(filename, p->GetPackage(), p->GetName(),
-                              p->GetLine());
-
-  return success;
+  // Complain about one declaration, as if it were the only one.
+  if (!document.GetInterfaces().empty()) {
+    const AidlInterface& c = *document.GetInterfaces().front();
+    return check_filename(filename, c.GetPackage(), c.GetName(), c.GetLine());
+  }
+  const AidlParcelable& p = *document.GetParcelables().front();
+  return check_filename(filename, p.GetPackage(), p.GetName(), p.GetLine());
 }
 
 bool gather_types(const std::string& filename,
-                  const AidlDocumentItem* all_items,
+                  const AidlDocument& document,
                   TypeNamespace* types) {
   bool success = true;
 
-  if (! all_items)
-    return true;
-
-  if (all_items->item_type == INTERFACE_TYPE_BINDER)
-    return types->AddBinderType(reinterpret_cast<const AidlInterface *>(all_items), filename);
-
-  for (const AidlParcelable* item =
-       reinterpret_cast<const AidlParcelable *>(all_items);
-       item; item = item->next) {
-    success &= types->AddParcelableType(item, filename);
+  for (const auto& interface : document.GetInterfaces()) {
+    success &= types->AddBinderType(interface.get(), filename);
+  }
+  for (const auto& parcelable : document.GetParcelables()) {
+    success &= types->AddParcelableType(parcelable.get(), filename);
   }
 
   return success;
 }
 
+}  // namespace
+
+namespace internals {
+
 int check_types(const string& filename,
                 const AidlInterface* c,
                 TypeNamespace* types) {
@@ -189,18 +223,53 @@ int check_types(const string& filename,
 
   // Has to be a pointer due to deleting copy constructor. No idea why.
   map<string, const AidlMethod*> method_names;
+  bool has_batched_methods = false;
   for (const auto& m : c->GetMethods()) {
-    if (!types->AddContainerType(m->GetType().GetName()) ||
+    if (!types->AddContainerType(m->GetType()) ||
         !types->IsValidReturnType(m->GetType(), filename)) {
       err = 1;  // return type is invalid
     }
 
     int index = 1;
     for (const auto& arg : m->GetArguments()) {
-      if (!types->AddContainerType(arg->GetType().GetName()) ||
+      if (!types->AddContainerType(arg->GetType()) ||
           !types->IsValidArg(*arg, index, filename)) {
         err = 1;
       }
+      if (arg->IsLazy() &&
+          (arg->IsOut() || arg->GetType().IsArray())) {
+        cerr << filename << ":" << arg->GetLine()
+             << " @Lazy argument " << arg->GetName()
+             << " must be a single in parcelable." << endl;
+        err = 1;
+      } else if (arg->IsLazy() && !types->CanBeLazy(arg->GetType())) {
+        cerr << filename << ":" << arg->GetLine()
+             << " @Lazy argument " << arg->GetName() << " of type "
+             << arg->GetType().ToString() << " cannot be read on demand."
+             << endl;
+        err = 1;
+      }
+    }
+
+    if (m->IsBatched()) {
+      // Batched calls are queued by the proxy and sent later in one
+      // transaction, so nothing can come back to the caller.
+      bool has_out_args = false;
+      for (const auto& arg : m->GetArguments()) {
+        has_out_args |= arg->IsOut();
+      }
+      if (!m->IsOneway() && !c->IsOneway()) {
+        cerr << filename << ":" << m->GetLine()
+             << " @Batched method " << m->GetName() << " must be oneway."
+             << endl;
+        err = 1;
+      } else if (m->GetType().GetName() != "void" || has_out_args) {
+        cerr << filename << ":" << m->GetLine()
+             << " @Batched method " << m->GetName()
+             << " cannot return values or have out parameters." << endl;
+        err = 1;
+      }
+      has_batched_methods = true;
     }
 
     auto it = method_names.find(m->GetName());
@@ -215,17 +284,33 @@ int check_types(const string& filename,
       err = 1;
     }
   }
+
+  if (has_batched_methods) {
+    for (const auto& m : c->GetMethods()) {
+      if (m->HasId() && m->GetId() == kMaxUserSetMethodId) {
+        cerr << filename << ":" << m->GetLine()
+             << " id " << kMaxUserSetMethodId << " of method " << m->GetName()
+             << " is reserved for batched calls." << endl;
+        err = 1;
+      }
+    }
+  }
   return err;
 }
 
+}  // namespace internals
+
+namespace {
+
+// Writes the make dependency file of |options|.  Besides the output
+// file |options| names, |other_outputs| are written for the input file's
+// other interfaces.
 void generate_dep_file(const JavaOptions& options,
-                       const AidlDocumentItem* items,
-                       const std::vector<std::unique_ptr<AidlImport>>& imports) {
-    /* we open the file in binary mode to ensure that the same output is
-     * generated on all platforms !!
-     */
-    FILE* to = NULL;
+                       const vector<string>& other_outputs,
+                       const std::vector<std::unique_ptr<AidlImport>>& imports,
+                       const IoDelegate& io_delegate) {
     string fileName;
+    trace::ScopedTrace trace("write_dep_file");
 
     if (options.auto_dep_file_) {
             fileName = options.output_file_name_ + ".d";
@@ -241,48 +326,106 @@ void generate_dep_file(const JavaOptions& options,
     else
         output_file_name = options.output_file_name_;
 
-    to = fopen(fileName.c_str(), "wb");
-
-    if (to == NULL) {
+    CodeWriterPtr writer = io_delegate.GetCodeWriter(fileName);
+    if (!writer) {
         cerr << "Could not open " << fileName << endl;
         return;
     }
 
-    if (items->item_type == INTERFACE_TYPE_BINDER) {
-        fprintf(to, "%s: \\\n", output_file_name.c_str());
-    } else {
-        // parcelable: there's no output file.
-        fprintf(to, " : \\\n");
+    writer->Write("%s", output_file_name.c_str());
+    for (const string& other_output : other_outputs) {
+        writer->Write(" %s", other_output.c_str());
+    }
+    writer->Write(": \\\n");
+    // Imports we never had to read (unused, or satisfied by a preprocessed
+    // file) have no filename.
+    vector<string> import_files;
+    for (const auto& import : imports) {
+        if (! import->GetFilename().empty()) {
+            import_files.push_back(import->GetFilename());
+        }
     }
-    fprintf(to, "  %s %s\n", options.input_file_name_.c_str(), imports.empty() ? "" : "\\");
+
+    writer->Write("  %s %s\n", options.input_file_name_.c_str(),
+                  import_files.empty() ? "" : "\\");
 
     bool first = true;
-    for (const auto& import : imports) {
+    for (const string& import_file : import_files) {
         if (! first) {
-          fprintf(to, " \\\n");
+          writer->Write(" \\\n");
         }
         first = false;
-
-        if (! import->GetFilename().empty()) {
-            fprintf(to, "  %s", import->GetFilename().c_str());
-        }
+        writer->Write("  %s", import_file.c_str());
     }
 
-    fprintf(to, first ? "\n" : "\n\n");
+    writer->Write(first ? "\n" : "\n\n");
 
     // Output "<input_aidl_file>: " so make won't fail if the input .aidl file
     // has been deleted, moved or renamed in incremental build.
-    fprintf(to, "%s :\n", options.input_file_name_.c_str());
+    writer->Write("%s :\n", options.input_file_name_.c_str());
 
     // Output "<imported_file>: " so make won't fail if the imported file has
     // been deleted, moved or renamed in incremental build.
-    for (const auto& import : imports) {
-        if (! import->GetFilename().empty()) {
-            fprintf(to, "%s :\n", import->GetFilename().c_str());
-        }
+    for (const string& import_file : import_files) {
+        writer->Write("%s :\n", import_file.c_str());
     }
+}
 
-    fclose(to);
+// The files C++ generation writes for the interface |options| names.
+vector<string> cpp_output_file_names(const CppOptions& options) {
+  return {
+      options.ClientCppFileName(),
+      options.ClientHeaderFileName(),
+      options.ServerCppFileName(),
+      options.ServerHeaderFileName(),
+      options.InterfaceCppFileName(),
+      options.InterfaceHeaderFileName(),
+  };
+}
+
+bool write_cpp_dep_file(const CppOptions& options,
+                        const vector<string>& outputs,
+                        const vector<unique_ptr<AidlImport>>& imports,
+                        const IoDelegate& io_delegate) {
+  const string dep_file_name = options.DependencyFilePath();
+  if (dep_file_name.empty()) {
+    return true;  // nothing to do
+  }
+  trace::ScopedTrace trace("write_dep_file", dep_file_name);
+  CodeWriterPtr writer = io_delegate.GetCodeWriter(dep_file_name);
+  if (!writer) {
+    cerr << "Could not open dependency file: " << dep_file_name << endl;
+    return false;
+  }
+
+  vector<string> source_aidl = {options.InputFileName()};
+  for (const auto& import : imports) {
+    if (!import->GetFilename().empty()) {
+      source_aidl.push_back(import->GetFilename());
+    }
+  }
+
+  // All the generated files depend on exactly the same set of inputs.
+  bool first = true;
+  for (const string& output : outputs) {
+    writer->Write("%s%s", (first) ? "" : " ", output.c_str());
+    first = false;
+  }
+  writer->Write(": \\\n");
+  for (size_t i = 0; i < source_aidl.size(); ++i) {
+    writer->Write("  %s%s\n", source_aidl[i].c_str(),
+                  (i + 1 < source_aidl.size()) ? " \\" : "");
+  }
+  writer->Write("\n");
+
+  // Output "<input_aidl_file>: " so make won't fail if the input .aidl file
+  // has been deleted, moved or renamed in incremental build.  Likewise for
+  // each of the imported files.
+  for (const string& file : source_aidl) {
+    writer->Write("%s :\n", file.c_str());
+  }
+
+  return true;
 }
 
 string generate_outputFileName2(const JavaOptions& options,
@@ -314,105 +457,97 @@ string generate_outputFileName2(const JavaOptions& options,
 }
 
 string generate_outputFileName(const JavaOptions& options,
-                               const AidlDocumentItem* items) {
-    // items has already been checked to have only one interface.
-    if (items->item_type == INTERFACE_TYPE_BINDER) {
-        const AidlInterface* type = reinterpret_cast<const AidlInterface*>(items);
-
-        return generate_outputFileName2(options, type->GetName(), type->GetPackage());
-    } else if (items->item_type == USER_DATA_TYPE) {
-        const AidlParcelable* type = reinterpret_cast<const AidlParcelable*>(items);
-
-        return generate_outputFileName2(options, type->GetName(), type->GetPackage());
-    }
-
-    // I don't think we can come here, but safer than returning NULL.
-    string result;
-    return result;
+                               const AidlInterface& interface) {
+    return generate_outputFileName2(options, interface.GetName(),
+                                    interface.GetPackage());
 }
 
-
-void check_outputFilePath(const string& path) {
-    size_t len = path.length();
-    for (size_t i=0; i<len ; i++) {
-        if (path[i] == OS_PATH_SEPARATOR) {
-            string p = path.substr(0, i);
-            if (access(path.data(), F_OK) != 0) {
-#ifdef _WIN32
-                _mkdir(p.data());
-#else
-                mkdir(p.data(), S_IRUSR|S_IWUSR|S_IXUSR|S_IRGRP|S_IXGRP);
-#endif
-            }
-        }
+// The Java file to generate for |interface|.  The output file named on the
+// command line is for the interface the input file is named after; the
+// input's other interfaces are written next to it.
+string java_output_file_name(const JavaOptions& options,
+                             const AidlInterface& interface) {
+    const bool primary = matches_filename(options.input_file_name_,
+                                          interface.GetPackage(),
+                                          interface.GetName(), nullptr);
+    if (primary && options.output_file_name_.length() > 0) {
+        return options.output_file_name_;
     }
+    if (options.output_base_folder_.length() > 0) {
+        return generate_outputFileName(options, interface);
+    }
+    if (options.output_file_name_.length() == 0) {
+        return "";
+    }
+    const size_t pos = options.output_file_name_.rfind(OS_PATH_SEPARATOR);
+    const string folder = (pos == string::npos) ?
+        "" : options.output_file_name_.substr(0, pos + 1);
+    return folder + interface.GetName() + ".java";
 }
 
 
-int parse_preprocessed_file(const string& filename, TypeNamespace* types) {
-    FILE* f = fopen(filename.c_str(), "rb");
-    if (f == NULL) {
+int parse_preprocessed_file(const IoDelegate& io_delegate,
+                            const string& filename,
+                            const vector<TypeNamespace*>& namespaces) {
+    trace::ScopedTrace trace("parse_preprocessed_file", filename);
+    unique_ptr<string> contents = io_delegate.GetFileContents(filename);
+    if (!contents) {
         fprintf(stderr, "aidl: can't open preprocessed file: %s\n",
                 filename.c_str());
         return 1;
     }
+    stats::Increment(stats::FILES_READ);
 
     int lineno = 1;
-    char line[1024];
-    char type[1024];
-    char fullname[1024];
-    while (fgets(line, sizeof(line), f)) {
+    for (const string& line : android::base::Split(*contents, "\n")) {
         // skip comments and empty lines
-        if (!line[0] || strncmp(line, "//", 2) == 0) {
+        if (line.empty() || line.compare(0, 2, "//") == 0) {
           continue;
         }
 
-        sscanf(line, "%s %[^; \r\n\t];", type, fullname);
+        vector<char> type(line.length() + 1, '\0');
+        vector<char> fullname(line.length() + 1, '\0');
+        sscanf(line.c_str(), "%s %[^; \r\n\t];", type.data(), fullname.data());
 
-        char* packagename;
-        char* classname = strrchr(fullname, '.');
+        const char* packagename;
+        char* classname = strrchr(fullname.data(), '.');
         if (classname != NULL) {
             *classname = '\0';
             classname++;
-            packagename = fullname;
+            packagename = fullname.data();
         } else {
-            classname = fullname;
-            packagename = NULL;
+            classname = fullname.data();
+            packagename = "";
         }
 
         //printf("%s:%d:...%s...%s...%s...\n", filename.c_str(), lineno,
         //        type, packagename, classname);
-        AidlDocumentItem* doc;
+        AidlDocument doc;
 
-        if (0 == strcmp("parcelable", type)) {
-            doc = new AidlParcelable(classname, lineno, packagename);
+        if (0 == strcmp("parcelable", type.data())) {
+            doc.AddParcelable(
+                new AidlParcelable(classname, lineno, packagename));
         }
-        else if (0 == strcmp("interface", type)) {
+        else if (0 == strcmp("interface", type.data())) {
             auto temp = new std::vector<std::unique_ptr<AidlMethod>>();
-            doc = new AidlInterface(classname, lineno, "", false, temp,
-                                    packagename ?: "");
+            doc.AddInterface(new AidlInterface(classname, lineno, "", false,
+                                               temp, packagename));
         }
         else {
             fprintf(stderr, "%s:%d: bad type in line: %s\n",
-                    filename.c_str(), lineno, line);
-            fclose(f);
+                    filename.c_str(), lineno, line.c_str());
             return 1;
         }
-        if (!gather_types(filename.c_str(), doc, types)) {
-            fprintf(stderr, "Failed to gather types for preprocessed aidl.\n");
-            fclose(f);
-            return 1;
+        for (TypeNamespace* types : namespaces) {
+            if (!gather_types(filename.c_str(), doc, types)) {
+                fprintf(stderr,
+                        "Failed to gather types for preprocessed aidl.\n");
+                return 1;
+            }
         }
         lineno++;
     }
 
-    if (!feof(f)) {
-        fprintf(stderr, "%s:%d: error reading file, line to long.\n",
-                filename.c_str(), lineno);
-        return 1;
-    }
-
-    fclose(f);
     return 0;
 }
 
@@ -470,6 +605,180 @@ int check_and_assign_method_ids(const char * filename,
     return 0;
 }
 
+// Adds |name| to |names|.  A nested name like "Outer.Inner" also refers
+// to Outer, since that is what gets imported.
+void add_referenced_name(const string& name, set<string>* names) {
+  for (size_t pos = name.find('.'); pos != string::npos;
+       pos = name.find('.', pos + 1)) {
+    names->insert(name.substr(0, pos));
+  }
+  names->insert(name);
+}
+
+// Adds the names |type| refers to, e.g. "Map<K,V>" refers to Map, K and V.
+void add_referenced_names(const AidlType& type, set<string>* names) {
+  add_referenced_name(type.GetBaseName(), names);
+  for (const string& parameter : type.GetTypeParameters()) {
+    add_referenced_name(parameter, names);
+  }
+}
+
+// Collects every type name that appears in a method signature of an
+// interface in |document|.
+set<string> referenced_type_names(const AidlDocument& document) {
+  set<string> names;
+  for (const auto& c : document.GetInterfaces()) {
+    for (const auto& m : c->GetMethods()) {
+      add_referenced_names(m->GetType(), &names);
+      for (const auto& arg : m->GetArguments()) {
+        add_referenced_names(arg->GetType(), &names);
+      }
+    }
+  }
+  return names;
+}
+
+// Adds the names of the declared types |type| uses, as written.  Container
+// classes are built in, so only their type parameters are added.
+void add_signature_type_names(const AidlType& type, set<string>* names) {
+  if (!type.IsGeneric()) {
+    names->insert(type.GetName());
+  }
+  for (const string& parameter : type.GetTypeParameters()) {
+    names->insert(parameter);
+  }
+}
+
+// Collects the declared types used by the interfaces in |document|.
+set<string> signature_type_names(const AidlDocument& document) {
+  set<string> names;
+  for (const auto& c : document.GetInterfaces()) {
+    for (const auto& m : c->GetMethods()) {
+      add_signature_type_names(m->GetType(), &names);
+      for (const auto& arg : m->GetArguments()) {
+        add_signature_type_names(arg->GetType(), &names);
+      }
+    }
+  }
+  return names;
+}
+
+// Returns whether |document| declares |name|, either by its canonical name
+// or by its name within the package.
+bool declares_type(const AidlDocument& document, const string& name) {
+  for (const auto& c : document.GetInterfaces()) {
+    if (c->GetName() == name || c->GetCanonicalName() == name) {
+      return true;
+    }
+  }
+  for (const auto& p : document.GetParcelables()) {
+    if (p->GetName() == name ||
+        (!p->GetPackage().empty() &&
+         p->GetPackage() + "." + p->GetName() == name)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// Maps the canonical name and the name within the package of every type
+// |document| declares to |import_index|, unless another import already
+// declares it.
+void add_declared_names(const AidlDocument& document, size_t import_index,
+                        map<string, size_t>* declaring_import) {
+  for (const auto& c : document.GetInterfaces()) {
+    declaring_import->emplace(c->GetName(), import_index);
+    declaring_import->emplace(c->GetCanonicalName(), import_index);
+  }
+  for (const auto& p : document.GetParcelables()) {
+    declaring_import->emplace(p->GetName(), import_index);
+    if (!p->GetPackage().empty()) {
+      declaring_import->emplace(p->GetPackage() + "." + p->GetName(),
+                                import_index);
+    }
+  }
+}
+
+// An import is used if a signature names it either fully qualified or by
+// any dotted suffix, e.g. "Outer.Inner" or "Inner" for "p.Outer.Inner".
+bool is_import_used(const AidlImport& import, const set<string>& names) {
+  const string& needed = import.GetNeededClass();
+  if (names.count(needed) != 0) {
+    return true;
+  }
+  for (size_t pos = needed.find('.'); pos != string::npos;
+       pos = needed.find('.', pos + 1)) {
+    if (names.count(needed.substr(pos + 1)) != 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// Runs |work(i)| for every i in [0, count) across a few threads, and
+// returns once all of it is done.
+void run_in_parallel(size_t count, const std::function<void(size_t)>& work) {
+#ifdef _WIN32
+  for (size_t i = 0; i < count; ++i) {
+    work(i);
+  }
+#else
+  const size_t kMaxThreads = 8;
+  const size_t num_threads = std::min<size_t>(
+      {count, kMaxThreads, std::max(1u, std::thread::hardware_concurrency())});
+  std::atomic<size_t> next{0};
+  auto worker = [&]() {
+    for (size_t i = next++; i < count; i = next++) {
+      work(i);
+    }
+  };
+  vector<std::thread> threads;
+  for (size_t i = 1; i < num_threads; ++i) {
+    threads.emplace_back(worker);
+  }
+  worker();
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+#endif
+}
+
+struct LoadedImport {
+  bool used = false;
+  // Whether each namespace already knows the class, e.g. because it was
+  // declared by a preprocessed file.
+  vector<bool> known_to;
+  bool known = false;  // known to every namespace
+  string path;
+  bool parsed = false;
+  unique_ptr<AidlDocument> document;
+  string diagnostics;
+};
+
+// Resolve, read and parse |import| into |result|.  This is safe to call
+// for several imports at once; nothing is printed.
+void load_import(const AidlImport& import,
+                 const ImportResolver& import_resolver,
+                 const IoDelegate& io_delegate,
+                 LoadedImport* result) {
+  {
+    trace::ScopedTrace trace("resolve_import", import.GetNeededClass());
+    result->path = import_resolver.FindImportFile(import.GetNeededClass());
+  }
+  if (result->path.empty()) {
+    return;
+  }
+
+  Parser p{io_delegate};
+  p.SetDiscardComments(true);
+  p.SetSkimBodies(true);
+  p.SetDiagnosticsBuffer(&result->diagnostics);
+  result->parsed = p.ParseFile(result->path);
+  if (result->parsed) {
+    result->document.reset(p.GetDocument());
+  }
+}
+
 }  // namespace
 
 namespace internals {
@@ -479,15 +788,28 @@ int load_and_validate_aidl(const std::vector<std::string> preprocessed_files,
                            const std::string& input_file_name,
                            const IoDelegate& io_delegate,
                            TypeNamespace* types,
-                           AidlInterface** returned_interface,
+                           std::vector<std::unique_ptr<AidlInterface>>* returned_interfaces,
+                           std::vector<std::unique_ptr<AidlImport>>* returned_imports) {
+  return load_and_validate_aidl(preprocessed_files, import_paths,
+                                input_file_name, io_delegate,
+                                vector<TypeNamespace*>{types},
+                                returned_interfaces, returned_imports);
+}
+
+int load_and_validate_aidl(const std::vector<std::string> preprocessed_files,
+                           const std::vector<std::string> import_paths,
+                           const std::string& input_file_name,
+                           const IoDelegate& io_delegate,
+                           const std::vector<TypeNamespace*>& namespaces,
+                           std::vector<std::unique_ptr<AidlInterface>>* returned_interfaces,
                            std::vector<std::unique_ptr<AidlImport>>* returned_imports) {
   int err = 0;
 
-  std::map<AidlImport*,std::unique_ptr<AidlDocumentItem>> docs;
+  std::map<AidlImport*,std::unique_ptr<AidlDocument>> docs;
 
   // import the preprocessed file
   for (const string& s : preprocessed_files) {
-    err |= parse_preprocessed_file(s, types);
+    err |= parse_preprocessed_file(io_delegate, s, namespaces);
   }
   if (err != 0) {
     return err;
@@ -499,76 +821,190 @@ int load_and_validate_aidl(const std::vector<std::string> preprocessed_files,
     return 1;
   }
 
-  AidlDocumentItem* parsed_doc = p.GetDocument();
-  // We could in theory declare parcelables in the same file as the interface.
-  // In practice, those parcelables would have to have the same name as
-  // the interface, since this was originally written to support Java, with its
-  // packages and names that correspond to file system structure.
-  // Since we can't have two distinct classes with the same name and package,
-  // we can't actually declare parcelables in the same file.
-  if (parsed_doc == nullptr ||
-      parsed_doc->item_type != INTERFACE_TYPE_BINDER) {
-    cerr << "aidl expects exactly one interface per input file";
+  // The input may declare any number of interfaces and parcelables, and
+  // code is generated for every interface.  One of the declared types must
+  // be named after the file.
+  unique_ptr<AidlDocument> document(p.GetDocument());
+  if (document == nullptr || document->GetInterfaces().empty()) {
+    cerr << "aidl expects at least one interface per input file" << endl;
     return 1;
   }
-  AidlInterface* interface = reinterpret_cast<AidlInterface*>(parsed_doc);
-  if (!check_filename(input_file_name.c_str(), interface->GetPackage(),
-                      interface->GetName(), interface->GetLine()))
+  const auto& interfaces = document->GetInterfaces();
+  if (!check_filenames(input_file_name, *document))
     err |= 1;
 
-  // parse the imports of the input file
+  // parse the imports of the input file, skipping any that no method
+  // signature refers to.  Those are never read, and never show up in the
+  // dependency file.  The rest are resolved and parsed concurrently, then
+  // reported on in the order they were declared.
   ImportResolver import_resolver{io_delegate, import_paths};
-  for (auto& import : p.GetImports()) {
-    if (types->HasType(import->GetNeededClass())) {
-      // There are places in the Android tree where an import doesn't resolve,
-      // but we'll pick the type up through the preprocessed types.
-      // This seems like an error, but legacy support demands we support it...
+  const set<string> referenced_names = referenced_type_names(*document);
+  const auto& imports = p.GetImports();
+  vector<LoadedImport> loaded(imports.size());
+  auto mark_used = [&](size_t i) {
+    loaded[i].used = true;
+    // There are places in the Android tree where an import doesn't resolve,
+    // but we'll pick the type up through the preprocessed types.
+    // This seems like an error, but legacy support demands we support it...
+    loaded[i].known = true;
+    loaded[i].known_to.clear();
+    for (const TypeNamespace* types : namespaces) {
+      const bool known = types->HasType(imports[i]->GetNeededClass());
+      loaded[i].known_to.push_back(known);
+      loaded[i].known &= known;
+    }
+    return !loaded[i].known;
+  };
+  vector<size_t> to_load;
+  for (size_t i = 0; i < imports.size(); ++i) {
+    loaded[i].known_to.assign(namespaces.size(), false);
+    if (is_import_used(*imports[i], referenced_names) && mark_used(i)) {
+      to_load.push_back(i);
+    }
+  }
+  run_in_parallel(to_load.size(), [&](size_t i) {
+    load_import(*imports[to_load[i]], import_resolver, io_delegate,
+                &loaded[to_load[i]]);
+  });
+
+  // A file can declare more than the type it is named after, so a type a
+  // signature uses may be declared by an import that no signature names.
+  // Map each such type to the import whose file declares it, reading the
+  // unused imports to find out, and use only those imports.
+  set<string> undeclared;
+  for (const string& name : signature_type_names(*document)) {
+    if (namespaces.front()->HasType(name) || declares_type(*document, name)) {
       continue;
     }
-    string import_path = import_resolver.FindImportFile(import->GetNeededClass());
-    if (import_path.empty()) {
+    set<string> name_and_outers;
+    add_referenced_name(name, &name_and_outers);
+    bool declared = false;
+    for (size_t i = 0; i < imports.size() && !declared; ++i) {
+      declared = loaded[i].used &&
+          (is_import_used(*imports[i], name_and_outers) ||
+           (loaded[i].document && declares_type(*loaded[i].document, name)));
+    }
+    if (!declared) {
+      undeclared.insert(name);
+    }
+  }
+  if (!undeclared.empty()) {
+    vector<size_t> unused;
+    for (size_t i = 0; i < imports.size(); ++i) {
+      if (!loaded[i].used) {
+        unused.push_back(i);
+      }
+    }
+    run_in_parallel(unused.size(), [&](size_t i) {
+      load_import(*imports[unused[i]], import_resolver, io_delegate,
+                  &loaded[unused[i]]);
+    });
+    map<string, size_t> declaring_import;
+    for (size_t i : unused) {
+      if (loaded[i].document) {
+        add_declared_names(*loaded[i].document, i, &declaring_import);
+      }
+    }
+    set<size_t> needed;
+    for (const string& name : undeclared) {
+      auto it = declaring_import.find(name);
+      if (it != declaring_import.end()) {
+        needed.insert(it->second);
+      }
+    }
+    for (size_t i : unused) {
+      if (needed.count(i) != 0) {
+        mark_used(i);
+      } else {
+        loaded[i] = LoadedImport();
+        loaded[i].known_to.assign(namespaces.size(), false);
+      }
+    }
+  }
+
+  for (size_t i = 0; i < imports.size(); ++i) {
+    AidlImport* import = imports[i].get();
+    LoadedImport& result = loaded[i];
+    if (!result.used) {
+      cerr << import->GetFileFrom() << ":" << import->GetLine()
+           << ": warning: unused import " << import->GetNeededClass() << endl;
+      continue;
+    }
+    if (result.known) {
+      stats::Increment(stats::IMPORT_CACHE_HITS);
+      continue;
+    }
+    stats::Increment(stats::IMPORT_CACHE_MISSES);
+    if (result.path.empty()) {
       cerr << import->GetFileFrom() << ":" << import->GetLine()
            << ": couldn't find import for class "
            << import->GetNeededClass() << endl;
       err |= 1;
       continue;
     }
-    import->SetFilename(import_path);
+    import->SetFilename(result.path);
+    stats::Increment(stats::IMPORTS_RESOLVED);
 
-    Parser p{io_delegate};
-    if (!p.ParseFile(import->GetFilename())) {
+    io_delegate.ReportDiagnostics(result.diagnostics);
+    if (!result.parsed) {
       cerr << "error while parsing import for class "
            << import->GetNeededClass() << endl;
       err |= 1;
       continue;
     }
 
-    AidlDocumentItem* document = p.GetDocument();
-    if (!check_filenames(import->GetFilename(), document))
+    if (result.document &&
+        !check_filenames(import->GetFilename(), *result.document))
       err |= 1;
-    docs[import.get()] = std::unique_ptr<AidlDocumentItem>(document);
+    docs[import] = std::move(result.document);
   }
   if (err != 0) {
     return err;
   }
 
   // gather the types that have been declared
-  if (!gather_types(input_file_name.c_str(), parsed_doc, types)) {
-    err |= 1;
-  }
-  for (const auto& import : p.GetImports()) {
-    if (!gather_types(import->GetFilename(), docs[import.get()].get(), types)) {
-      err |= 1;
+  {
+    trace::ScopedTrace trace("gather_types");
+    for (size_t n = 0; n < namespaces.size(); ++n) {
+      if (!gather_types(input_file_name.c_str(), *document, namespaces[n])) {
+        err |= 1;
+      }
+      for (size_t i = 0; i < imports.size(); ++i) {
+        if (loaded[i].known_to[n]) {
+          continue;
+        }
+        auto it = docs.find(imports[i].get());
+        if (it == docs.end() || !it->second) {
+          continue;
+        }
+        if (!gather_types(imports[i]->GetFilename(), *it->second,
+                          namespaces[n])) {
+          err |= 1;
+        }
+      }
     }
   }
 
-  // check the referenced types in parsed_doc to make sure we've imported them
-  err |= check_types(input_file_name, interface, types);
-
+  // check the referenced types in every interface in the input to make
+  // sure we've imported them.  Most errors are the same in every namespace,
+  // so stop at the first one that reports any rather than repeating them.
+  {
+    trace::ScopedTrace trace("check_types", input_file_name);
+    for (TypeNamespace* types : namespaces) {
+      for (const auto& c : interfaces) {
+        err |= check_types(input_file_name, c.get(), types);
+      }
+      if (err != 0) {
+        break;
+      }
+    }
+  }
 
   // assign method ids and validate.
-  err |= check_and_assign_method_ids(input_file_name.c_str(),
-                                     interface->GetMethods());
+  for (const auto& c : interfaces) {
+    err |= check_and_assign_method_ids(input_file_name.c_str(),
+                                       c->GetMethods());
+  }
 
   // after this, there shouldn't be any more errors because of the
   // input.
@@ -576,10 +1012,16 @@ int load_and_validate_aidl(const std::vector<std::string> preprocessed_files,
     return err;
   }
 
-  if (returned_interface)
-      *returned_interface = interface;
-  else
-      delete interface;
+  if (returned_interfaces) {
+    document->ReleaseInterfaces(returned_interfaces);
+    // the interface named after the file first
+    std::stable_partition(
+        returned_interfaces->begin(), returned_interfaces->end(),
+        [&input_file_name](const unique_ptr<AidlInterface>& c) {
+          return matches_filename(input_file_name, c->GetPackage(),
+                                  c->GetName(), nullptr);
+        });
+  }
 
   if (returned_imports)
     p.ReleaseImports(returned_imports);
@@ -589,9 +1031,124 @@ int load_and_validate_aidl(const std::vector<std::string> preprocessed_files,
 
 } // namespace internals
 
+namespace {
+
+int generate_cpp_outputs(const CppOptions& options,
+                         const vector<unique_ptr<AidlInterface>>& interfaces,
+                         const vector<unique_ptr<AidlImport>>& imports,
+                         const cpp::TypeNamespace& types,
+                         const IoDelegate& io_delegate) {
+  for (const auto& interface : interfaces) {
+    for (const auto& method : interface->GetMethods()) {
+      if (method->IsBatched()) {
+        cerr << options.InputFileName() << ":" << method->GetLine()
+             << " @Batched methods are only supported in Java." << endl;
+        return 1;
+      }
+    }
+  }
+
+  // Each interface's files are named after it.
+  vector<unique_ptr<CppOptions>> interface_options;
+  vector<string> outputs;
+  for (const auto& interface : interfaces) {
+    interface_options.push_back(options.ForInterface(interface->GetName()));
+    for (const string& output :
+         cpp_output_file_names(*interface_options.back())) {
+      outputs.push_back(output);
+    }
+  }
+
+  if (!write_cpp_dep_file(options, outputs, imports, io_delegate)) {
+    return 1;
+  }
+
+  for (size_t i = 0; i < interfaces.size(); ++i) {
+    ResolvedInterface<cpp::Type> resolved;
+    if (!ResolveInterface(*interfaces[i], types, &resolved)) {
+      return 1;
+    }
+    if (!cpp::GenerateCpp(*interface_options[i], resolved, io_delegate)) {
+      return 1;
+    }
+  }
+  return 0;
+}
+
+int generate_java_output(const JavaOptions& options,
+                         const AidlInterface& interface,
+                         const string& output_file_name,
+                         bool write_size_report,
+                         java::JavaTypeNamespace* types,
+                         const IoDelegate& io_delegate) {
+  // make sure the folders of the output file all exists
+  io_delegate.CreatePathForFile(output_file_name);
+
+  ResolvedInterface<java::Type> resolved;
+  if (!ResolveInterface(interface, *types, &resolved)) {
+    return 1;
+  }
+
+  if (write_size_report && !options.size_report_file_name_.empty() &&
+      !java::WriteSizeReport(options.size_report_file_name_, resolved,
+                             io_delegate)) {
+    return 1;
+  }
+
+  return generate_java(output_file_name, options.input_file_name_.c_str(),
+                       resolved, types, io_delegate,
+                       options.instrument_transactions_);
+}
+
+int generate_java_outputs(const JavaOptions& options,
+                          const vector<unique_ptr<AidlInterface>>& interfaces,
+                          const vector<unique_ptr<AidlImport>>& imports,
+                          const vector<string>& cpp_outputs,
+                          java::JavaTypeNamespace* types,
+                          const IoDelegate& io_delegate) {
+  vector<string> output_file_names;
+  vector<bool> is_primary;
+  for (const auto& interface : interfaces) {
+    output_file_names.push_back(java_output_file_name(options, *interface));
+    is_primary.push_back(matches_filename(options.input_file_name_,
+                                          interface->GetPackage(),
+                                          interface->GetName(), nullptr));
+  }
+
+  // if we were asked to, generate a make dependency file
+  // unless it's a parcelable *and* it's supposed to fail on parcelable
+  if (options.auto_dep_file_ || options.dep_file_name_ != "") {
+    // make sure the folders of the output file all exists
+    io_delegate.CreatePathForFile(output_file_names.front());
+    vector<string> other_outputs;
+    for (size_t i = 0; i < interfaces.size(); ++i) {
+      if (!is_primary[i]) {
+        other_outputs.push_back(output_file_names[i]);
+      }
+    }
+    other_outputs.insert(other_outputs.end(), cpp_outputs.begin(),
+                         cpp_outputs.end());
+    generate_dep_file(options, other_outputs, imports, io_delegate);
+  }
+
+  // The size report covers the interface named after the input file.
+  for (size_t i = 0; i < interfaces.size(); ++i) {
+    int err = generate_java_output(options, *interfaces[i],
+                                   output_file_names[i], is_primary[i], types,
+                                   io_delegate);
+    if (err != 0) {
+      return err;
+    }
+  }
+  return 0;
+}
+
+}  // namespace
+
 int compile_aidl_to_cpp(const CppOptions& options,
                         const IoDelegate& io_delegate) {
-  AidlInterface* interface = nullptr;
+  trace::ScopedTrace trace("compile_aidl_to_cpp", options.InputFileName());
+  std::vector<std::unique_ptr<AidlInterface>> interfaces;
   std::vector<std::unique_ptr<AidlImport>> imports;
   unique_ptr<cpp::TypeNamespace> types(new cpp::TypeNamespace());
   int err = internals::load_and_validate_aidl(
@@ -600,20 +1157,20 @@ int compile_aidl_to_cpp(const CppOptions& options,
       options.InputFileName(),
       io_delegate,
       types.get(),
-      &interface,
+      &interfaces,
       &imports);
   if (err != 0) {
     return err;
   }
 
-  // TODO(wiley) b/23600457 generate a dependency file if requested with -b
-
-  return (cpp::GenerateCpp(options, *types, *interface)) ? 0 : 1;
+  return generate_cpp_outputs(options, interfaces, imports, *types,
+                              io_delegate);
 }
 
 int compile_aidl_to_java(const JavaOptions& options,
                          const IoDelegate& io_delegate) {
-  AidlInterface* interface = nullptr;
+  trace::ScopedTrace trace("compile_aidl_to_java", options.input_file_name_);
+  std::vector<std::unique_ptr<AidlInterface>> interfaces;
   std::vector<std::unique_ptr<AidlImport>> imports;
   unique_ptr<java::JavaTypeNamespace> types(new java::JavaTypeNamespace());
   int err = internals::load_and_validate_aidl(
@@ -622,35 +1179,60 @@ int compile_aidl_to_java(const JavaOptions& options,
       options.input_file_name_,
       io_delegate,
       types.get(),
-      &interface,
+      &interfaces,
       &imports);
   if (err != 0) {
     return err;
   }
-  AidlDocumentItem* parsed_doc = reinterpret_cast<AidlDocumentItem*>(interface);
 
-  string output_file_name = options.output_file_name_;
-  // if needed, generate the output file name from the base folder
-  if (output_file_name.length() == 0 &&
-      options.output_base_folder_.length() > 0) {
-    output_file_name = generate_outputFileName(options, parsed_doc);
-  }
+  return generate_java_outputs(options, interfaces, imports,
+                               vector<string>{},  // no C++ outputs
+                               types.get(), io_delegate);
+}
 
-  // if we were asked to, generate a make dependency file
-  // unless it's a parcelable *and* it's supposed to fail on parcelable
-  if (options.auto_dep_file_ || options.dep_file_name_ != "") {
-    // make sure the folders of the output file all exists
-    check_outputFilePath(output_file_name);
-    generate_dep_file(options, parsed_doc, imports);
+int compile_aidl_to_java_and_cpp(const JavaOptions& options,
+                                 const IoDelegate& io_delegate) {
+  trace::ScopedTrace trace("compile_aidl_to_java_and_cpp",
+                           options.input_file_name_);
+  unique_ptr<CppOptions> cpp_options = CppOptions::ForJava(options);
+  if (!cpp_options) {
+    return 1;
   }
 
-  // make sure the folders of the output file all exists
-  check_outputFilePath(output_file_name);
-
-  err = generate_java(output_file_name, options.input_file_name_.c_str(),
-                      interface, types.get());
+  // Parse, resolve imports and validate once, registering the declared
+  // types with both backends.
+  std::vector<std::unique_ptr<AidlInterface>> interfaces;
+  std::vector<std::unique_ptr<AidlImport>> imports;
+  unique_ptr<java::JavaTypeNamespace> java_types(
+      new java::JavaTypeNamespace());
+  unique_ptr<cpp::TypeNamespace> cpp_types(new cpp::TypeNamespace());
+  int err = internals::load_and_validate_aidl(
+      options.preprocessed_files_,
+      options.import_paths_,
+      options.input_file_name_,
+      io_delegate,
+      vector<TypeNamespace*>{java_types.get(), cpp_types.get()},
+      &interfaces,
+      &imports);
+  if (err != 0) {
+    return err;
+  }
 
-  return err;
+  // One dependency file covers the outputs of both languages.
+  vector<string> cpp_outputs;
+  for (const auto& interface : interfaces) {
+    for (const string& output : cpp_output_file_names(
+             *cpp_options->ForInterface(interface->GetName()))) {
+      cpp_outputs.push_back(output);
+    }
+  }
+  err = generate_java_outputs(options, interfaces, imports, cpp_outputs,
+                              java_types.get(), io_delegate);
+  if (err != 0) {
+    return err;
+  }
+  return generate_cpp_outputs(*cpp_options, interfaces, imports, *cpp_types,
+                              io_delegate);
 }
 
 int preprocess_aidl(const JavaOptions& options,
@@ -661,31 +1243,31 @@ int preprocess_aidl(const JavaOptions& options,
     int N = options.files_to_preprocess_.size();
     for (int i=0; i<N; i++) {
         Parser p{io_delegate};
+        p.SetDiscardComments(true);
+        p.SetSkimBodies(true);
         if (!p.ParseFile(options.files_to_preprocess_[i]))
           return 1;
-        AidlDocumentItem* doc = p.GetDocument();
-        string line;
-        if (doc->item_type == USER_DATA_TYPE) {
-            AidlParcelable* parcelable = reinterpret_cast<AidlParcelable*>(doc);
-
-            line = "parcelable ";
-
+        unique_ptr<AidlDocument> doc(p.GetDocument());
+        for (const auto& parcelable : doc->GetParcelables()) {
+            string line = "parcelable ";
             if (! parcelable->GetPackage().empty()) {
                 line += parcelable->GetPackage();
                 line += '.';
             }
             line += parcelable->GetName();
-        } else {
-            line = "interface ";
-            AidlInterface* iface = reinterpret_cast<AidlInterface*>(doc);
+            line += ";\n";
+            lines.push_back(line);
+        }
+        for (const auto& iface : doc->GetInterfaces()) {
+            string line = "interface ";
             if (!iface->GetPackage().empty()) {
                 line += iface->GetPackage();
                 line += '.';
             }
             line += iface->GetName();
+            line += ";\n";
+            lines.push_back(line);
         }
-        line += ";\n";
-        lines.push_back(line);
     }
 
     // write preprocessed file
@@ -719,5 +1301,45 @@ int preprocess_aidl(const JavaOptions& options,
     return 0;
 }
 
+int write_dep_graph(const JavaOptions& options,
+                    const IoDelegate& io_delegate) {
+  DependencyGraph graph;
+  int err = 0;
+  for (const string& file : options.files_to_index_) {
+    if (!graph.AddFile(file, io_delegate)) {
+      err = 1;
+    }
+  }
+  if (err != 0) {
+    return err;
+  }
+
+  CodeWriterPtr writer = io_delegate.GetCodeWriter(options.output_file_name_);
+  if (!writer || !graph.Write(writer.get())) {
+    fprintf(stderr, "aidl: error writing to file %s\n",
+            options.output_file_name_.c_str());
+    return 1;
+  }
+  return 0;
+}
+
+int query_dep_graph(const JavaOptions& options,
+                    const IoDelegate& io_delegate) {
+  DependencyGraph graph;
+  if (!graph.Read(options.input_file_name_, io_delegate)) {
+    return 1;
+  }
+
+  const vector<string> results =
+      (options.task == JavaOptions::QUERY_DEP_GRAPH_IMPORTS)
+          ? graph.ImportsOf(options.dep_graph_query_)
+          : graph.TransitiveUsersOf(options.dep_graph_query_);
+  CodeWriterPtr writer = io_delegate.GetCodeWriter("-");
+  for (const string& result : results) {
+    writer->Write("%s\n", result.c_str());
+  }
+  return 0;
+}
+
 }  // namespace android
 }  // namespace aidl
@@ -29,8 +29,14 @@ int compile_aidl_to_cpp(const CppOptions& options,
                         const IoDelegate& io_delegate);
 int compile_aidl_to_java(const JavaOptions& options,
                          const IoDelegate& io_delegate);
+int compile_aidl_to_java_and_cpp(const JavaOptions& options,
+                                 const IoDelegate& io_delegate);
 int preprocess_aidl(const JavaOptions& options,
                     const IoDelegate& io_delegate);
+int write_dep_graph(const JavaOptions& options,
+                    const IoDelegate& io_delegate);
+int query_dep_graph(const JavaOptions& options,
+                    const IoDelegate& io_delegate);
 
 namespace internals {
 
@@ -39,9 +45,27 @@ int load_and_validate_aidl(const std::vector<std::string> preprocessed_files,
                            const std::string& input_file_name,
                            const IoDelegate& io_delegate,
                            TypeNamespace* types,
-                           AidlInterface** returned_interface,
+                           std::vector<std::unique_ptr<AidlInterface>>* returned_interfaces,
                            std::vector<std::unique_ptr<AidlImport>>* returned_imports);
 
+// As above, but validates the input once against several namespaces, e.g.
+// one per backend, so that each can generate code from
+// |returned_interfaces|.  Those are every interface the input declares, the
+// one named after the file first.
+int load_and_validate_aidl(const std::vector<std::string> preprocessed_files,
+                           const std::vector<std::string> import_paths,
+                           const std::string& input_file_name,
+                           const IoDelegate& io_delegate,
+                           const std::vector<TypeNamespace*>& namespaces,
+                           std::vector<std::unique_ptr<AidlInterface>>* returned_interfaces,
+                           std::vector<std::unique_ptr<AidlImport>>* returned_imports);
+
+// Check that every type referenced by |c| is known to |types|.
+// Returns 0 on success.
+int check_types(const std::string& filename,
+                const AidlInterface* c,
+                TypeNamespace* types);
+
 } // namespace internals
 
 }  // namespace android
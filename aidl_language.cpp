@@ -1,13 +1,17 @@
 #include "aidl_language.h"
 
 #include <iostream>
+#include <stdarg.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <string>
 
+#include <base/stringprintf.h>
+
 #include "aidl_language_y.hpp"
-#include "logging.h"
+#include "stats.h"
+#include "trace.h"
 
 #ifdef _WIN32
 int isatty(int  fd)
@@ -18,13 +22,13 @@ int isatty(int  fd)
 
 using android::aidl::IoDelegate;
 using std::cerr;
-using std::endl;
 using std::string;
 using std::unique_ptr;
 
 void yylex_init(void **);
 void yylex_destroy(void *);
 void yyset_in(FILE *f, void *);
+void yyset_extra(Parser*, void *);
 int yyparse(Parser*);
 YY_BUFFER_STATE yy_scan_buffer(char *, size_t, void *);
 void yy_delete_buffer(YY_BUFFER_STATE, void *);
@@ -36,10 +40,23 @@ AidlToken::AidlToken(const std::string& text, const std::string& comments)
 AidlType::AidlType(const std::string& name, unsigned line,
                    const std::string& comments, bool is_array)
     : name_(name),
+      base_name_(name),
       line_(line),
       is_array_(is_array),
       comments_(comments) {}
 
+AidlType::AidlType(const std::string& base_name,
+                   std::vector<std::string>* type_parameters, unsigned line,
+                   const std::string& comments)
+    : name_(base_name + "<" + android::base::Join(*type_parameters, ',') + ">"),
+      base_name_(base_name),
+      type_parameters_(std::move(*type_parameters)),
+      line_(line),
+      is_array_(false),
+      comments_(comments) {
+  delete type_parameters;
+}
+
 string AidlType::ToString() const {
   return name_ + (is_array_ ? "[]" : "");
 }
@@ -111,6 +128,7 @@ AidlMethod::AidlMethod(bool oneway, AidlType* type, std::string name,
 Parser::Parser(const IoDelegate& io_delegate)
     : io_delegate_(io_delegate) {
   yylex_init(&scanner_);
+  yyset_extra(this, scanner_);
 }
 
 AidlParcelable::AidlParcelable(AidlQualifiedName* name, unsigned line,
@@ -141,6 +159,15 @@ AidlInterface::AidlInterface(const std::string& name, unsigned line,
   delete methods;
 }
 
+uint64_t AidlInterface::GetDescriptorHash() const {
+  uint64_t hash = 0xcbf29ce484222325ULL;
+  for (char c : GetCanonicalName()) {
+    hash ^= static_cast<uint8_t>(c);
+    hash *= 0x100000001b3ULL;
+  }
+  return hash;
+}
+
 AidlQualifiedName::AidlQualifiedName(std::string term,
                                      std::string comments)
     : terms_({term}),
@@ -166,10 +193,12 @@ Parser::~Parser() {
 }
 
 bool Parser::ParseFile(const string& filename) {
+  android::aidl::trace::ScopedTrace trace("ParseFile", filename);
   // Make sure we can read the file first, before trashing previous state.
   unique_ptr<string> new_buffer = io_delegate_.GetFileContents(filename);
   if (!new_buffer) {
-    LOG(ERROR) << "Error while opening file for parsing: '" << filename << "'";
+    PrintError("Error while opening file for parsing: '%s'\n",
+               filename.c_str());
     return false;
   }
 
@@ -180,6 +209,9 @@ bool Parser::ParseFile(const string& filename) {
   }
 
   raw_buffer_ = std::move(new_buffer);
+  android::aidl::stats::Increment(android::aidl::stats::FILES_READ);
+  android::aidl::stats::Increment(android::aidl::stats::BYTES_LEXED,
+                                  raw_buffer_->length());
   // We're going to scan this buffer in place, and yacc demands we put two
   // nulls at the end.
   raw_buffer_->append(2u, '\0');
@@ -196,10 +228,23 @@ bool Parser::ParseFile(const string& filename) {
 }
 
 void Parser::ReportError(const string& err, unsigned line) {
-  cerr << filename_ << ":" << line << ": " << err << endl;
+  PrintError("%s:%u: %s\n", filename_.c_str(), line, err.c_str());
   error_ = 1;
 }
 
+void Parser::PrintError(const char* format, ...) {
+  string message;
+  va_list ap;
+  va_start(ap, format);
+  android::base::StringAppendV(&message, format, ap);
+  va_end(ap);
+  if (diagnostics_) {
+    diagnostics_->append(message);
+  } else {
+    cerr << message;
+  }
+}
+
 void Parser::AddImport(AidlQualifiedName* name, unsigned line) {
   imports_.emplace_back(new AidlImport(this->FileName(),
                                        name->GetDotName(), line));
@@ -1,6 +1,7 @@
 #ifndef AIDL_AIDL_LANGUAGE_H_
 #define AIDL_AIDL_LANGUAGE_H_
 
+#include <cstdint>
 #include <memory>
 #include <string>
 #include <vector>
@@ -40,9 +41,21 @@ class AidlType : public AidlNode {
  public:
   AidlType(const std::string& name, unsigned line,
            const std::string& comments, bool is_array);
+  // A generic type such as List<String>.  Takes ownership of
+  // |type_parameters|.
+  AidlType(const std::string& base_name,
+           std::vector<std::string>* type_parameters, unsigned line,
+           const std::string& comments);
   virtual ~AidlType() = default;
 
+  // The full name, including any type parameters, e.g. "List<String>".
   const std::string& GetName() const { return name_; }
+  // The name without type parameters, e.g. "List".
+  const std::string& GetBaseName() const { return base_name_; }
+  bool IsGeneric() const { return !type_parameters_.empty(); }
+  const std::vector<std::string>& GetTypeParameters() const {
+    return type_parameters_;
+  }
   unsigned GetLine() const { return line_; }
   bool IsArray() const { return is_array_; }
   const std::string& GetComments() const { return comments_; }
@@ -51,6 +64,8 @@ class AidlType : public AidlNode {
 
  private:
   std::string name_;
+  std::string base_name_;
+  std::vector<std::string> type_parameters_;
   unsigned line_;
   bool is_array_;
   std::string comments_;
@@ -71,8 +86,11 @@ class AidlArgument : public AidlNode {
   bool IsOut() const { return direction_ & OUT_DIR; }
   bool IsIn() const { return direction_ & IN_DIR; }
   bool DirectionWasSpecified() const { return direction_specified_; }
+  // @Lazy parcelables are only unmarshalled by the stub if it uses them.
+  bool IsLazy() const { return lazy_; }
+  void SetLazy() { lazy_ = true; }
 
-  std::string GetName() const { return name_; }
+  const std::string& GetName() const { return name_; }
   int GetLine() const { return line_; }
   const AidlType& GetType() const { return *type_; }
 
@@ -82,6 +100,7 @@ class AidlArgument : public AidlNode {
   std::unique_ptr<AidlType> type_;
   Direction direction_;
   bool direction_specified_;
+  bool lazy_ = false;
   std::string name_;
   unsigned line_;
 
@@ -101,6 +120,15 @@ class AidlMethod {
   const std::string& GetComments() const { return comments_; }
   const AidlType& GetType() const { return *type_; }
   bool IsOneway() const { return oneway_; }
+  // Calls to @Batched methods may be queued by the proxy and sent together
+  // in one transaction.
+  bool IsBatched() const { return batched_; }
+  void SetBatched() { batched_ = true; }
+  // Annotations come before the rest of the method, so the comments ahead
+  // of them belong to the method too.
+  void PrependComments(const std::string& comments) {
+    comments_ = comments + comments_;
+  }
   const std::string& GetName() const { return name_; }
   unsigned GetLine() const { return line_; }
   bool HasId() const { return has_id_; }
@@ -122,6 +150,7 @@ class AidlMethod {
 
  private:
   bool oneway_;
+  bool batched_ = false;
   std::string comments_;
   std::unique_ptr<AidlType> type_;
   std::string name_;
@@ -181,7 +210,6 @@ class AidlParcelable : public AidlDocumentItem {
   unsigned GetLine() const { return line_; }
   const std::string& GetPackage() const { return package_; }
 
-  AidlParcelable* next = nullptr;
  private:
   std::string name_;
   unsigned line_;
@@ -207,17 +235,77 @@ class AidlInterface : public AidlDocumentItem {
   const std::string& GetPackage() const { return package_; }
   std::string GetCanonicalName() const { return package_ + "." + name_; }
 
+  // @CompactInterfaceToken interfaces send GetDescriptorHash() with each
+  // transaction in place of the full interface descriptor.
+  bool HasCompactToken() const { return compact_token_; }
+  void SetCompactToken() { compact_token_ = true; }
+  // A 64-bit FNV-1a hash of the canonical name, the same for every backend
+  // and every build.
+  uint64_t GetDescriptorHash() const;
+
+  // Annotations come before the rest of the interface, so the comments
+  // ahead of them belong to the interface too.
+  void PrependComments(const std::string& comments) {
+    comments_ = comments + comments_;
+  }
+
  private:
   std::string name_;
   std::string comments_;
   unsigned line_;
   bool oneway_;
+  bool compact_token_ = false;
   std::vector<std::unique_ptr<AidlMethod>> methods_;
   std::string package_;
 
   DISALLOW_COPY_AND_ASSIGN(AidlInterface);
 };
 
+// Everything declared in one .aidl file.  A file may declare any number of
+// interfaces and parcelables, but one of them (the primary type) must be
+// named after the file so that imports can find it.
+class AidlDocument : public AidlNode {
+ public:
+  AidlDocument() = default;
+  virtual ~AidlDocument() = default;
+
+  // Takes ownership of |interface|.
+  void AddInterface(AidlInterface* interface) {
+    interfaces_.emplace_back(interface);
+  }
+  // Takes ownership of |parcelable|.
+  void AddParcelable(AidlParcelable* parcelable) {
+    parcelables_.emplace_back(parcelable);
+  }
+
+  const std::vector<std::unique_ptr<AidlInterface>>& GetInterfaces() const {
+    return interfaces_;
+  }
+  const std::vector<std::unique_ptr<AidlParcelable>>& GetParcelables() const {
+    return parcelables_;
+  }
+  bool IsEmpty() const { return interfaces_.empty() && parcelables_.empty(); }
+
+  // Removes the interface at |index| from the document and hands ownership
+  // of it to the caller.
+  AidlInterface* ReleaseInterface(size_t index) {
+    AidlInterface* interface = interfaces_[index].release();
+    interfaces_.erase(interfaces_.begin() + index);
+    return interface;
+  }
+  // Hands ownership of every interface in the document to the caller.
+  void ReleaseInterfaces(std::vector<std::unique_ptr<AidlInterface>>* ret) {
+    *ret = std::move(interfaces_);
+    interfaces_.clear();
+  }
+
+ private:
+  std::vector<std::unique_ptr<AidlInterface>> interfaces_;
+  std::vector<std::unique_ptr<AidlParcelable>> parcelables_;
+
+  DISALLOW_COPY_AND_ASSIGN(AidlDocument);
+};
+
 class AidlImport : public AidlNode {
  public:
   AidlImport(const std::string& from, const std::string& needed_class,
@@ -248,14 +336,31 @@ class Parser {
   // Parse contents of file |filename|.
   bool ParseFile(const std::string& filename);
 
+  // Skip over comments without saving them on the tokens, for documents
+  // whose comments will never be emitted (e.g. imports).
+  void SetDiscardComments(bool discard) { discard_comments_ = discard; }
+  bool DiscardsComments() const { return discard_comments_; }
+
+  // Skip interface bodies by brace matching, so that interfaces come back
+  // with their name and package but no methods.  Callers that need the
+  // methods must parse the file again without skimming.
+  void SetSkimBodies(bool skim) { skim_bodies_ = skim; }
+  bool SkimsBodies() const { return skim_bodies_; }
+
   void ReportError(const std::string& err, unsigned line);
+  // Print a diagnostic in the usual printf sense.
+  void PrintError(const char* format, ...);
+
+  // Collect diagnostics in |buffer| rather than printing them, so that
+  // parsers running concurrently can be reported in a stable order.
+  void SetDiagnosticsBuffer(std::string* buffer) { diagnostics_ = buffer; }
 
   bool FoundNoErrors() const { return error_ == 0; }
   const std::string& FileName() const { return filename_; }
   const std::string& Package() const { return package_; }
   void* Scanner() const { return scanner_; }
 
-  void SetDocument(AidlDocumentItem* items) { document_ = items; };
+  void SetDocument(AidlDocument* document) { document_ = document; };
 
   void AddImport(AidlQualifiedName* name, unsigned line);
   void SetPackage(AidlQualifiedName* name) {
@@ -263,7 +368,8 @@ class Parser {
     delete name;
   }
 
-  AidlDocumentItem* GetDocument() const { return document_; }
+  // The caller takes ownership of the returned document.
+  AidlDocument* GetDocument() const { return document_; }
   const std::vector<std::unique_ptr<AidlImport>>& GetImports() { return imports_; }
 
   void ReleaseImports(std::vector<std::unique_ptr<AidlImport>>* ret) {
@@ -274,10 +380,13 @@ class Parser {
  private:
   const android::aidl::IoDelegate& io_delegate_;
   int error_ = 0;
+  bool discard_comments_ = false;
+  bool skim_bodies_ = false;
+  std::string* diagnostics_ = nullptr;
   std::string filename_;
   std::string package_;
   void* scanner_ = nullptr;
-  AidlDocumentItem* document_ = nullptr;
+  AidlDocument* document_ = nullptr;
   std::vector<std::unique_ptr<AidlImport>> imports_;
   std::unique_ptr<std::string> raw_buffer_;
   YY_BUFFER_STATE buffer_;
@@ -0,0 +1,224 @@
+/*
+ * Copyright (C) 2015, The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "aidl_language.h"
+#include "tests/fake_io_delegate.h"
+
+using android::aidl::test::FakeIoDelegate;
+using std::string;
+using std::unique_ptr;
+
+namespace android {
+namespace aidl {
+namespace {
+
+const char kPath[] = "p/IFoo.aidl";
+const char kContents[] =
+R"(package p;
+/** Interface docs. */
+interface IFoo {
+  // Method docs.
+  /* More docs. */
+  void f(int a);
+})";
+
+}  // namespace
+
+class AidlLanguageTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    io_delegate_.SetFileContents(kPath, kContents);
+  }
+
+  // Parses kContents and returns the single interface it declares.
+  AidlInterface* Parse(Parser* p) {
+    if (!p->ParseFile(kPath)) {
+      return nullptr;
+    }
+    document_.reset(p->GetDocument());
+    if (!document_ || document_->GetInterfaces().size() != 1u) {
+      return nullptr;
+    }
+    return document_->GetInterfaces().front().get();
+  }
+
+  FakeIoDelegate io_delegate_;
+  unique_ptr<AidlDocument> document_;
+};
+
+TEST_F(AidlLanguageTest, KeepsCommentsByDefault) {
+  Parser p{io_delegate_};
+  AidlInterface* interface = Parse(&p);
+  ASSERT_NE(interface, nullptr);
+  EXPECT_EQ("/** Interface docs. */", interface->GetComments());
+  ASSERT_EQ(1u, interface->GetMethods().size());
+  EXPECT_EQ("// Method docs.\n/* More docs. */",
+            interface->GetMethods()[0]->GetComments());
+}
+
+TEST_F(AidlLanguageTest, DiscardsComments) {
+  Parser p{io_delegate_};
+  p.SetDiscardComments(true);
+  AidlInterface* interface = Parse(&p);
+  ASSERT_NE(interface, nullptr);
+  EXPECT_EQ("", interface->GetComments());
+  ASSERT_EQ(1u, interface->GetMethods().size());
+  EXPECT_EQ("", interface->GetMethods()[0]->GetComments());
+  EXPECT_EQ("f", interface->GetMethods()[0]->GetName());
+}
+
+TEST_F(AidlLanguageTest, SkimsInterfaceBodies) {
+  io_delegate_.SetFileContents(kPath,
+R"(package p;
+import p.IBar;
+oneway interface IFoo {
+  /* A stray } in a comment. */
+  void f(in Map<String, String> m);  // And a { here.
+  %%{
+  Another } here.
+}%%
+  void g(IBar bar) = 4;
+})");
+  Parser p{io_delegate_};
+  p.SetSkimBodies(true);
+  AidlInterface* interface = Parse(&p);
+  ASSERT_NE(interface, nullptr);
+  EXPECT_EQ("IFoo", interface->GetName());
+  EXPECT_EQ("p", interface->GetPackage());
+  EXPECT_TRUE(interface->IsOneway());
+  EXPECT_TRUE(interface->GetMethods().empty());
+  ASSERT_EQ(1u, p.GetImports().size());
+  EXPECT_EQ("p.IBar", p.GetImports()[0]->GetNeededClass());
+}
+
+TEST_F(AidlLanguageTest, KeepsTypeParameters) {
+  io_delegate_.SetFileContents(kPath,
+R"(package p;
+interface IFoo {
+  List<String> f(in Map<p.Key, Value> m, in int[] a);
+})");
+  Parser p{io_delegate_};
+  AidlInterface* interface = Parse(&p);
+  ASSERT_NE(interface, nullptr);
+  ASSERT_EQ(1u, interface->GetMethods().size());
+  const AidlMethod& method = *interface->GetMethods()[0];
+
+  const AidlType& return_type = method.GetType();
+  EXPECT_EQ("List<String>", return_type.GetName());
+  EXPECT_EQ("List", return_type.GetBaseName());
+  EXPECT_TRUE(return_type.IsGeneric());
+  EXPECT_EQ((std::vector<string>{"String"}),
+            return_type.GetTypeParameters());
+
+  ASSERT_EQ(2u, method.GetArguments().size());
+  const AidlType& map_type = method.GetArguments()[0]->GetType();
+  EXPECT_EQ("Map<p.Key,Value>", map_type.GetName());
+  EXPECT_EQ("Map", map_type.GetBaseName());
+  EXPECT_EQ((std::vector<string>{"p.Key", "Value"}),
+            map_type.GetTypeParameters());
+
+  const AidlType& array_type = method.GetArguments()[1]->GetType();
+  EXPECT_EQ("int", array_type.GetBaseName());
+  EXPECT_FALSE(array_type.IsGeneric());
+  EXPECT_TRUE(array_type.IsArray());
+}
+
+TEST_F(AidlLanguageTest, ParsesSeveralDeclarations) {
+  io_delegate_.SetFileContents(kPath,
+R"(package p;
+parcelable A;
+interface IFoo {
+  void f(in A a);
+}
+parcelable B;
+oneway interface IBar {
+  void g();
+})");
+  Parser p{io_delegate_};
+  ASSERT_TRUE(p.ParseFile(kPath));
+  unique_ptr<AidlDocument> document(p.GetDocument());
+  ASSERT_NE(document, nullptr);
+
+  ASSERT_EQ(2u, document->GetInterfaces().size());
+  EXPECT_EQ("IFoo", document->GetInterfaces()[0]->GetName());
+  EXPECT_EQ(1u, document->GetInterfaces()[0]->GetMethods().size());
+  EXPECT_EQ("IBar", document->GetInterfaces()[1]->GetName());
+  EXPECT_TRUE(document->GetInterfaces()[1]->IsOneway());
+  ASSERT_EQ(2u, document->GetParcelables().size());
+  EXPECT_EQ("A", document->GetParcelables()[0]->GetName());
+  EXPECT_EQ("p", document->GetParcelables()[1]->GetPackage());
+
+  unique_ptr<AidlInterface> foo(document->ReleaseInterface(0));
+  EXPECT_EQ("IFoo", foo->GetName());
+  ASSERT_EQ(1u, document->GetInterfaces().size());
+  EXPECT_EQ("IBar", document->GetInterfaces()[0]->GetName());
+
+  std::vector<unique_ptr<AidlInterface>> rest;
+  document->ReleaseInterfaces(&rest);
+  ASSERT_EQ(1u, rest.size());
+  EXPECT_EQ("IBar", rest[0]->GetName());
+  EXPECT_TRUE(document->GetInterfaces().empty());
+}
+
+TEST_F(AidlLanguageTest, ParsesAnnotations) {
+  io_delegate_.SetFileContents(kPath,
+R"(package p;
+interface IFoo {
+  /** Docs. */
+  @Batched oneway void f(int a);
+  void g(@Lazy in A a, int b);
+})");
+  Parser p{io_delegate_};
+  AidlInterface* interface = Parse(&p);
+  ASSERT_NE(interface, nullptr);
+  ASSERT_EQ(2u, interface->GetMethods().size());
+  EXPECT_TRUE(interface->GetMethods()[0]->IsBatched());
+  EXPECT_TRUE(interface->GetMethods()[0]->IsOneway());
+  EXPECT_EQ("/** Docs. */", interface->GetMethods()[0]->GetComments());
+  EXPECT_FALSE(interface->GetMethods()[1]->IsBatched());
+  ASSERT_EQ(2u, interface->GetMethods()[1]->GetArguments().size());
+  EXPECT_TRUE(interface->GetMethods()[1]->GetArguments()[0]->IsLazy());
+  EXPECT_TRUE(interface->GetMethods()[1]->GetArguments()[0]->IsIn());
+  EXPECT_FALSE(interface->GetMethods()[1]->GetArguments()[1]->IsLazy());
+}
+
+TEST_F(AidlLanguageTest, RejectsUnknownAnnotations) {
+  io_delegate_.SetFileContents(kPath,
+R"(package p;
+interface IFoo {
+  @Nope oneway void f(int a);
+})");
+  Parser p{io_delegate_};
+  EXPECT_FALSE(p.ParseFile(kPath));
+}
+
+TEST_F(AidlLanguageTest, BuffersReadErrors) {
+  Parser p{io_delegate_};
+  string diagnostics;
+  p.SetDiagnosticsBuffer(&diagnostics);
+  EXPECT_FALSE(p.ParseFile("p/IMissing.aidl"));
+  EXPECT_EQ("Error while opening file for parsing: 'p/IMissing.aidl'\n",
+            diagnostics);
+}
+
+}  // namespace aidl
+}  // namespace android
@@ -20,8 +20,8 @@ int yylex(yy::parser::semantic_type *, yy::parser::location_type *, void *);
 %union {
     AidlToken* token;
     int integer;
-    std::string *str;
     AidlType* type;
+    std::vector<std::string>* type_params;
     AidlArgument* arg;
     AidlArgument::Direction direction;
     std::vector<std::unique_ptr<AidlArgument>>* arg_list;
@@ -30,15 +30,17 @@ int yylex(yy::parser::semantic_type *, yy::parser::location_type *, void *);
     AidlQualifiedName* qname;
     AidlInterface* interface_obj;
     AidlParcelable* user_data;
+    AidlDocument* document;
 }
 
-%token<token> IDENTIFIER INTERFACE ONEWAY
+%token<token> IDENTIFIER INTERFACE ONEWAY ANNOTATION
 %token<integer> IDVALUE
 
 %token '(' ')' ',' '=' '[' ']' '<' '>' '.' '{' '}' ';'
 %token IN OUT INOUT PACKAGE IMPORT PARCELABLE
 
-%type<user_data> parcelable_decl parcelable_decls
+%type<user_data> parcelable_decl
+%type<document> decls
 %type<methods> methods
 %type<interface_obj> interface_decl
 %type<method> method_decl
@@ -46,15 +48,13 @@ int yylex(yy::parser::semantic_type *, yy::parser::location_type *, void *);
 %type<arg_list> arg_list
 %type<arg> arg
 %type<direction> direction
-%type<str> generic_list
+%type<type_params> generic_list
 %type<qname> qualified_name
 
 %type<token> error
 %%
 document
- : package imports parcelable_decls
-  { ps->SetDocument($3); }
- | package imports interface_decl
+ : package imports decls
   { ps->SetDocument($3); };
 
 package
@@ -80,19 +80,21 @@ qualified_name
     $$->AddTerm($3->GetText());
   };
 
-parcelable_decls
+decls
  :
-  { $$ = NULL; }
- | parcelable_decls parcelable_decl {
-   $$ = $1;
-   AidlParcelable **pos = &$$;
-   while (*pos)
-     pos = &(*pos)->next;
-   if ($2)
-     *pos = $2;
-  }
- | parcelable_decls error {
-    fprintf(stderr, "%s:%d: syntax error don't know what to do with \"%s\"\n",
+  { $$ = new AidlDocument(); }
+ | decls parcelable_decl {
+    $$ = $1;
+    if ($2)
+      $$->AddParcelable($2);
+  }
+ | decls interface_decl {
+    $$ = $1;
+    if ($2)
+      $$->AddInterface($2);
+  }
+ | decls error {
+    ps->PrintError("%s:%d: syntax error don't know what to do with \"%s\"\n",
             ps->FileName().c_str(),
             @2.begin.line, $2->GetText().c_str());
     $$ = $1;
@@ -103,12 +105,12 @@ parcelable_decl
     $$ = new AidlParcelable($2, @2.begin.line, ps->Package());
   }
  | PARCELABLE ';' {
-    fprintf(stderr, "%s:%d syntax error in parcelable declaration. Expected type name.\n",
+    ps->PrintError("%s:%d syntax error in parcelable declaration. Expected type name.\n",
             ps->FileName().c_str(), @1.begin.line);
     $$ = NULL;
   }
  | PARCELABLE error ';' {
-    fprintf(stderr, "%s:%d syntax error in parcelable declaration. Expected type name, saw \"%s\".\n",
+    ps->PrintError("%s:%d syntax error in parcelable declaration. Expected type name, saw \"%s\".\n",
             ps->FileName().c_str(), @2.begin.line, $2->GetText().c_str());
     $$ = NULL;
   };
@@ -128,18 +130,30 @@ interface_decl
     delete $3;
   }
  | INTERFACE error '{' methods '}' {
-    fprintf(stderr, "%s:%d: syntax error in interface declaration.  Expected type name, saw \"%s\"\n",
+    ps->PrintError("%s:%d: syntax error in interface declaration.  Expected type name, saw \"%s\"\n",
             ps->FileName().c_str(), @2.begin.line, $2->GetText().c_str());
     $$ = NULL;
     delete $1;
     delete $2;
   }
  | INTERFACE error '}' {
-    fprintf(stderr, "%s:%d: syntax error in interface declaration.  Expected type name, saw \"%s\"\n",
+    ps->PrintError("%s:%d: syntax error in interface declaration.  Expected type name, saw \"%s\"\n",
             ps->FileName().c_str(), @2.begin.line, $2->GetText().c_str());
     $$ = NULL;
     delete $1;
     delete $2;
+  }
+ | ANNOTATION interface_decl {
+    $$ = $2;
+    if ($1->GetText() != "CompactInterfaceToken") {
+      ps->ReportError("unknown annotation @" + $1->GetText(), @1.begin.line);
+    } else if ($$) {
+      $$->SetCompactToken();
+    }
+    if ($$) {
+      $$->PrependComments($1->GetComments());
+    }
+    delete $1;
   };
 
 methods
@@ -148,8 +162,8 @@ methods
  | methods method_decl
   { $1->push_back(std::unique_ptr<AidlMethod>($2)); }
  | methods error ';' {
-    fprintf(stderr, "%s:%d: syntax error before ';' "
-                    "(expected method declaration)\n",
+    ps->PrintError("%s:%d: syntax error before ';' "
+                   "(expected method declaration)\n",
             ps->FileName().c_str(), @3.begin.line);
     $$ = $1;
   };
@@ -176,6 +190,16 @@ method_decl
                         $1->GetComments(), $8);
     delete $1;
     delete $3;
+  }
+ | ANNOTATION method_decl {
+    $$ = $2;
+    if ($1->GetText() == "Batched") {
+      $$->SetBatched();
+    } else {
+      ps->ReportError("unknown annotation @" + $1->GetText(), @1.begin.line);
+    }
+    $$->PrependComments($1->GetComments());
+    delete $1;
   };
 
 arg_list
@@ -190,7 +214,7 @@ arg_list
     $$->push_back(std::unique_ptr<AidlArgument>($3));
   }
  | error {
-    fprintf(stderr, "%s:%d: syntax error in parameter list\n",
+    ps->PrintError("%s:%d: syntax error in parameter list\n",
             ps->FileName().c_str(), @1.begin.line);
     $$ = new std::vector<std::unique_ptr<AidlArgument>>();
   };
@@ -204,6 +228,15 @@ arg
     $$ = new AidlArgument($1, $2->GetText(), @2.begin.line);
     delete $2;
   };
+ | ANNOTATION arg {
+    $$ = $2;
+    if ($1->GetText() == "Lazy") {
+      $$->SetLazy();
+    } else {
+      ps->ReportError("unknown annotation @" + $1->GetText(), @1.begin.line);
+    }
+    delete $1;
+  };
 
 type
  : qualified_name {
@@ -217,20 +250,20 @@ type
     delete $1;
   }
  | qualified_name '<' generic_list '>' {
-    $$ = new AidlType($1->GetDotName() + "<" + *$3 + ">", @1.begin.line,
-                      $1->GetComments(), false);
+    $$ = new AidlType($1->GetDotName(), $3, @1.begin.line,
+                      $1->GetComments());
     delete $1;
-    delete $3;
   };
 
 generic_list
  : qualified_name {
-    $$ = new std::string($1->GetDotName());
+    $$ = new std::vector<std::string>();
+    $$->push_back($1->GetDotName());
     delete $1;
   }
  | generic_list ',' qualified_name {
-    $$ = new std::string(*$1 + "," + $3->GetDotName());
-    delete $1;
+    $$ = $1;
+    $$->push_back($3->GetDotName());
     delete $3;
   };
 
@@ -16,10 +16,9 @@
 
 #include "ast_cpp.h"
 
-#include <algorithm>
-
 #include "code_writer.h"
 #include "logging.h"
+#include "stats.h"
 
 using std::string;
 using std::unique_ptr;
@@ -29,6 +28,20 @@ namespace android {
 namespace aidl {
 namespace cpp {
 
+AstNode::AstNode() {
+  stats::Increment(stats::AST_NODES);
+}
+
+GeneratedDeclarations::GeneratedDeclarations(size_t count, Generator generate)
+    : count_(count),
+      generate_(generate) {}
+
+void GeneratedDeclarations::Write(CodeWriter* to) const {
+  for (size_t i = 0; i < count_; ++i) {
+    generate_(i)->Write(to);
+  }
+}
+
 ClassDecl::ClassDecl(const std::string& name, const std::string& parent)
     : name_(name),
       parent_(parent) {}
@@ -257,29 +270,50 @@ SwitchStatement::SwitchStatement(const std::string& expression)
     : switch_expression_(expression) {}
 
 StatementBlock* SwitchStatement::AddCase(const string& value_expression) {
-  auto it = std::find(case_values_.begin(), case_values_.end(), value_expression);
-  if (it != case_values_.end()) {
+  if (!seen_case_values_.insert(value_expression).second) {
     LOG(ERROR) << "internal error: duplicate switch case labels";
     return nullptr;
   }
   StatementBlock* ret = new StatementBlock();
-  case_values_.push_back(value_expression);
-  case_logic_.push_back(unique_ptr<StatementBlock>{ret});
+  cases_.emplace_back();
+  cases_.back().value = value_expression;
+  cases_.back().logic.reset(ret);
   return ret;
 }
 
+void SwitchStatement::AddCases(size_t count, CaseGenerator generate) {
+  cases_.emplace_back();
+  cases_.back().count = count;
+  cases_.back().generate = generate;
+}
+
+namespace {
+
+void WriteCase(CodeWriter* to, const string& case_value,
+               const StatementBlock& statements) {
+  if (case_value.empty()) {
+    to->Write("default:\n");
+  } else {
+    to->Write("case %s:\n", case_value.c_str());
+  }
+  statements.Write(to);
+  to->Write("break;\n");
+}
+
+}  // namespace
+
 void SwitchStatement::Write(CodeWriter* to) const {
   to->Write("switch (%s) {\n", switch_expression_.c_str());
-  for (size_t i = 0; i < case_values_.size(); ++i) {
-    const string& case_value = case_values_[i];
-    const unique_ptr<StatementBlock>& statements = case_logic_[i];
-    if (case_value.empty()) {
-      to->Write("default:\n");
-    } else {
-      to->Write("case %s:\n", case_value.c_str());
+  for (const Case& c : cases_) {
+    if (!c.generate) {
+      WriteCase(to, c.value, *c.logic);
+      continue;
+    }
+    for (size_t i = 0; i < c.count; ++i) {
+      StatementBlock statements;
+      const string case_value = c.generate(i, &statements);
+      WriteCase(to, case_value, statements);
     }
-    statements->Write(to);
-    to->Write("break;\n");
   }
   to->Write("}\n");
 }
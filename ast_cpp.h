@@ -17,8 +17,10 @@
 #ifndef AIDL_AST_CPP_H_
 #define AIDL_AST_CPP_H_
 
+#include <functional>
 #include <memory>
 #include <string>
+#include <unordered_set>
 #include <vector>
 
 #include <base/macros.h>
@@ -35,7 +37,7 @@ namespace cpp {
 
 class AstNode {
  public:
-  AstNode() = default;
+  AstNode();
   virtual ~AstNode() = default;
   virtual void Write(CodeWriter* to) const = 0;
 };  // class AstNode
@@ -49,6 +51,28 @@ class Declaration : public AstNode {
   DISALLOW_COPY_AND_ASSIGN(Declaration);
 };  // class Declaration
 
+// A run of declarations that are only built while they are written, one at
+// a time, so that each is freed before the next one is built.  This keeps
+// the memory needed for an interface with thousands of methods down to
+// that of a single method.
+class GeneratedDeclarations : public Declaration {
+ public:
+  // Builds the declaration at |index|.  Called once per index for every
+  // Write().
+  using Generator = std::function<std::unique_ptr<Declaration>(size_t index)>;
+
+  GeneratedDeclarations(size_t count, Generator generate);
+  virtual ~GeneratedDeclarations() = default;
+
+  void Write(CodeWriter* to) const override;
+
+ private:
+  const size_t count_;
+  const Generator generate_;
+
+  DISALLOW_COPY_AND_ASSIGN(GeneratedDeclarations);
+};  // class GeneratedDeclarations
+
 class ClassDecl : public Declaration {
  public:
   ClassDecl(const std::string& name,
@@ -232,6 +256,11 @@ class MethodImpl : public Declaration {
 
 class SwitchStatement : public AstNode {
  public:
+  // Fills in |body| with the code for the case at |index| and returns the
+  // case's value expression.
+  using CaseGenerator =
+      std::function<std::string(size_t index, StatementBlock* body)>;
+
   explicit SwitchStatement(const std::string& expression);
   virtual ~SwitchStatement() = default;
 
@@ -241,12 +270,26 @@ class SwitchStatement : public AstNode {
   // Returns nullptr on duplicate value expressions (by strcmp, not value
   // equivalence).
   StatementBlock* AddCase(const std::string& value_expression);
+  // Add |count| cases that are only built while the switch is written, one
+  // at a time, as for GeneratedDeclarations.  Their values are not checked
+  // for duplicates, so |generate| must produce distinct ones.
+  void AddCases(size_t count, CaseGenerator generate);
   void Write(CodeWriter* to) const override;
 
  private:
+  // A single case, or a run of |count| generated cases if |generate| is
+  // set.
+  struct Case {
+    std::string value;
+    std::unique_ptr<StatementBlock> logic;
+    size_t count = 0;
+    CaseGenerator generate;
+  };
+
   const std::string switch_expression_;
-  std::vector<std::string> case_values_;
-  std::vector<std::unique_ptr<StatementBlock>> case_logic_;
+  std::vector<Case> cases_;
+  // The values of the cases added with AddCase(), for checking duplicates.
+  std::unordered_set<std::string> seen_case_values_;
 
   DISALLOW_COPY_AND_ASSIGN(SwitchStatement);
 };  // class SwitchStatement
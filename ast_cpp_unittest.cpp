@@ -81,6 +81,26 @@ break;
 }
 )";
 
+const char kExpectedGeneratedSwitchOutput[] =
+R"(switch (var) {
+case 0:
+{
+zero;
+}
+break;
+case 1:
+{
+one;
+}
+break;
+default:
+{
+other;
+}
+break;
+}
+)";
+
 const char kExpectedMethodImplOutput[] =
 R"(return_type ClassName::MethodName(arg 1, arg 2, arg 3) const {
 foo;
@@ -209,6 +229,29 @@ TEST_F(AstCppTests, GeneratesSwitchStatement) {
   CompareGeneratedCode(s, kExpectedSwitchOutput);
 }
 
+TEST_F(AstCppTests, GeneratesSwitchCasesWhileWriting) {
+  const vector<string> bodies{"zero", "one"};
+  size_t generated = 0;
+  SwitchStatement s("var");
+  s.AddCases(bodies.size(), [&](size_t i, StatementBlock* b) {
+    ++generated;
+    b->AddLiteral(bodies[i]);
+    return std::to_string(i);
+  });
+  s.AddCase("")->AddLiteral("other");
+  EXPECT_EQ(0u, generated);
+  CompareGeneratedCode(s, kExpectedGeneratedSwitchOutput);
+  EXPECT_EQ(bodies.size(), generated);
+}
+
+TEST_F(AstCppTests, GeneratesDeclarationsWhileWriting) {
+  GeneratedDeclarations decls(2, [](size_t i) {
+    return unique_ptr<Declaration>{
+        new MethodDecl{"void", "Method" + std::to_string(i), ArgList{}}};
+  });
+  CompareGeneratedCode(decls, "void Method0();\nvoid Method1();\n");
+}
+
 TEST_F(AstCppTests, GeneratesMethodImpl) {
   MethodImpl m{"return_type", "ClassName", "MethodName",
                ArgList{{"arg 1", "arg 2", "arg 3"}},
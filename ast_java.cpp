@@ -17,6 +17,7 @@
 #include "ast_java.h"
 
 #include "code_writer.h"
+#include "stats.h"
 #include "type_java.h"
 
 namespace android {
@@ -53,6 +54,14 @@ WriteModifiers(CodeWriter* to, int mod, int mask)
     if (m & ABSTRACT) {
         to->Write("abstract ");
     }
+
+    if (m & VOLATILE) {
+        to->Write("volatile ");
+    }
+
+    if (m & SYNCHRONIZED) {
+        to->Write("synchronized ");
+    }
 }
 
 void
@@ -67,6 +76,30 @@ WriteArgumentList(CodeWriter* to, const vector<Expression*>& arguments)
     }
 }
 
+static thread_local NodeScope* g_current_scope = nullptr;
+
+AstNode::AstNode()
+{
+    stats::Increment(stats::AST_NODES);
+    if (g_current_scope != nullptr) {
+        g_current_scope->m_nodes.push_back(this);
+    }
+}
+
+NodeScope::NodeScope()
+    :m_enclosing(g_current_scope)
+{
+    g_current_scope = this;
+}
+
+NodeScope::~NodeScope()
+{
+    g_current_scope = m_enclosing;
+    for (AstNode* node : m_nodes) {
+        delete node;
+    }
+}
+
 Field::Field(int m, Variable* v)
     :ClassElement(),
      modifiers(m),
@@ -86,9 +119,9 @@ Field::Write(CodeWriter* to) const
     if (this->comment.length() != 0) {
         to->Write("%s\n", this->comment.c_str());
     }
-    WriteModifiers(to, this->modifiers, SCOPE_MASK | STATIC | FINAL | OVERRIDE);
-    to->Write("%s %s", this->variable->type->QualifiedName().c_str(),
-            this->variable->name.c_str());
+    WriteModifiers(to, this->modifiers,
+            SCOPE_MASK | STATIC | FINAL | VOLATILE | OVERRIDE);
+    this->variable->WriteDeclaration(to);
     if (this->value.length() != 0) {
         to->Write(" = %s", this->value.c_str());
     }
@@ -446,6 +479,26 @@ IfStatement::Write(CodeWriter* to) const
     }
 }
 
+void
+WhileStatement::Write(CodeWriter* to) const
+{
+    to->Write("while (");
+    this->expression->Write(to);
+    to->Write(") ");
+    this->statements->Write(to);
+}
+
+void
+ForEachStatement::Write(CodeWriter* to) const
+{
+    to->Write("for (");
+    this->variable->WriteDeclaration(to);
+    to->Write(" : ");
+    this->collection->Write(to);
+    to->Write(") ");
+    this->statements->Write(to);
+}
+
 ReturnStatement::ReturnStatement(Expression* e)
     :expression(e)
 {
@@ -459,6 +512,19 @@ ReturnStatement::Write(CodeWriter* to) const
     to->Write(";\n");
 }
 
+ThrowStatement::ThrowStatement(Expression* e)
+    :expression(e)
+{
+}
+
+void
+ThrowStatement::Write(CodeWriter* to) const
+{
+    to->Write("throw ");
+    this->expression->Write(to);
+    to->Write(";\n");
+}
+
 void
 TryStatement::Write(CodeWriter* to) const
 {
@@ -491,6 +557,10 @@ FinallyStatement::Write(CodeWriter* to) const
     this->statements->Write(to);
 }
 
+Case::Case()
+{
+}
+
 Case::Case(const string& c)
 {
     cases.push_back(c);
@@ -515,6 +585,22 @@ Case::Write(CodeWriter* to) const
     statements->Write(to);
 }
 
+GeneratedCases::GeneratedCases(size_t n,
+                               std::function<Case*(size_t index)> g)
+    :count(n),
+     generate(g)
+{
+}
+
+void
+GeneratedCases::Write(CodeWriter* to) const
+{
+    for (size_t i=0; i<count; i++) {
+        NodeScope scope;
+        generate(i)->Write(to);
+    }
+}
+
 SwitchStatement::SwitchStatement(Expression* e)
     :expression(e)
 {
@@ -568,7 +654,8 @@ Method::Write(CodeWriter* to) const
         to->Write("%s\n", this->comment.c_str());
     }
 
-    WriteModifiers(to, this->modifiers, SCOPE_MASK | STATIC | ABSTRACT | FINAL | OVERRIDE);
+    WriteModifiers(to, this->modifiers,
+            SCOPE_MASK | STATIC | ABSTRACT | FINAL | SYNCHRONIZED | OVERRIDE);
 
     if (this->returnType != NULL) {
         string dim;
@@ -609,6 +696,28 @@ Method::Write(CodeWriter* to) const
     }
 }
 
+GeneratedElements::GeneratedElements(
+        size_t n, std::function<ClassElement*(size_t index)> g)
+    :count(n),
+     generate(g)
+{
+}
+
+void
+GeneratedElements::GatherTypes(set<const Type*>* types) const
+{
+    types->insert(this->signatureTypes.begin(), this->signatureTypes.end());
+}
+
+void
+GeneratedElements::Write(CodeWriter* to) const
+{
+    for (size_t i=0; i<count; i++) {
+        NodeScope scope;
+        generate(i)->Write(to);
+    }
+}
+
 void
 Class::GatherTypes(set<const Type*>* types) const
 {
@@ -667,7 +776,8 @@ Class::Write(CodeWriter* to) const
             to->Write(" extends");
         }
         for (i=0; i<N; i++) {
-            to->Write(" %s", this->interfaces[i]->QualifiedName().c_str());
+            to->Write("%s %s", i == 0 ? "" : ",",
+                      this->interfaces[i]->QualifiedName().c_str());
         }
     }
 
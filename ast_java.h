@@ -17,12 +17,15 @@
 #ifndef AIDL_AST_JAVA_H_
 #define AIDL_AST_JAVA_H_
 
+#include <functional>
 #include <string>
 #include <vector>
 #include <set>
 #include <stdarg.h>
 #include <stdio.h>
 
+#include <base/macros.h>
+
 using std::set;
 using std::string;
 using std::vector;
@@ -37,6 +40,8 @@ enum {
     STATIC          = 0x00000010,
     FINAL           = 0x00000020,
     ABSTRACT        = 0x00000040,
+    VOLATILE        = 0x00000080,
+    SYNCHRONIZED    = 0x00000200,
 
     OVERRIDE        = 0x00000100,
 
@@ -58,7 +63,31 @@ class Type;
 // Write the modifiers that are set in both mod and mask
 void WriteModifiers(CodeWriter* to, int mod, int mask);
 
-struct ClassElement
+// Nodes don't own each other, and are normally never freed.  While a
+// NodeScope is alive, though, it owns every node created on its thread and
+// deletes them when it goes out of scope.
+struct AstNode
+{
+    AstNode();
+    virtual ~AstNode() = default;
+};
+
+class NodeScope
+{
+public:
+    NodeScope();
+    ~NodeScope();
+
+private:
+    friend struct AstNode;
+
+    NodeScope* m_enclosing;
+    vector<AstNode*> m_nodes;
+
+    DISALLOW_COPY_AND_ASSIGN(NodeScope);
+};
+
+struct ClassElement : public AstNode
 {
     ClassElement() = default;
     virtual ~ClassElement() = default;
@@ -67,8 +96,9 @@ struct ClassElement
     virtual void Write(CodeWriter* to) const = 0;
 };
 
-struct Expression
+struct Expression : public AstNode
 {
+    Expression() = default;
     virtual ~Expression() = default;
     virtual void Write(CodeWriter* to) const = 0;
 };
@@ -136,8 +166,9 @@ struct Field : public ClassElement
     void Write(CodeWriter* to) const override;
 };
 
-struct Statement
+struct Statement : public AstNode
 {
+    Statement() = default;
     virtual ~Statement() = default;
     virtual void Write(CodeWriter* to) const = 0;
 };
@@ -277,6 +308,27 @@ struct IfStatement : public Statement
     void Write(CodeWriter* to) const override;
 };
 
+struct WhileStatement : public Statement
+{
+    Expression* expression = nullptr;
+    StatementBlock* statements = new StatementBlock;
+
+    WhileStatement() = default;
+    virtual ~WhileStatement() = default;
+    void Write(CodeWriter* to) const override;
+};
+
+struct ForEachStatement : public Statement
+{
+    Variable* variable = nullptr;
+    Expression* collection = nullptr;
+    StatementBlock* statements = new StatementBlock;
+
+    ForEachStatement() = default;
+    virtual ~ForEachStatement() = default;
+    void Write(CodeWriter* to) const override;
+};
+
 struct ReturnStatement : public Statement
 {
     Expression* expression;
@@ -286,6 +338,15 @@ struct ReturnStatement : public Statement
     void Write(CodeWriter* to) const override;
 };
 
+struct ThrowStatement : public Statement
+{
+    Expression* expression;
+
+    ThrowStatement(Expression* expression);
+    virtual ~ThrowStatement() = default;
+    void Write(CodeWriter* to) const override;
+};
+
 struct TryStatement : public Statement
 {
     StatementBlock* statements = new StatementBlock;
@@ -314,17 +375,30 @@ struct FinallyStatement : public Statement
     void Write(CodeWriter* to) const override;
 };
 
-struct Case
+struct Case : public AstNode
 {
     vector<string> cases;
     StatementBlock* statements = new StatementBlock;
 
-    Case() = default;
+    Case();
     Case(const string& c);
     virtual ~Case() = default;
     virtual void Write(CodeWriter* to) const;
 };
 
+// A run of cases that are only built while the switch is written, one at a
+// time.  Each case, and every node created while building it, is freed
+// before the next one is built.
+struct GeneratedCases : public Case
+{
+    size_t count;
+    std::function<Case*(size_t index)> generate;
+
+    GeneratedCases(size_t count, std::function<Case*(size_t index)> generate);
+    virtual ~GeneratedCases() = default;
+    void Write(CodeWriter* to) const override;
+};
+
 struct SwitchStatement : public Statement
 {
     Expression* expression;
@@ -360,6 +434,24 @@ struct Method : public ClassElement
     void Write(CodeWriter* to) const override;
 };
 
+// The same as GeneratedCases, for the elements of a class.  GatherTypes
+// reports signatureTypes rather than generating the elements again, so
+// generate is only ever called by Write.
+struct GeneratedElements : public ClassElement
+{
+    size_t count;
+    std::function<ClassElement*(size_t index)> generate;
+    // The types the generated elements' signatures name.
+    vector<const Type*> signatureTypes;
+
+    GeneratedElements(size_t count,
+                      std::function<ClassElement*(size_t index)> generate);
+    virtual ~GeneratedElements() = default;
+
+    void GatherTypes(set<const Type*>* types) const override;
+    void Write(CodeWriter* to) const override;
+};
+
 struct Class : public ClassElement
 {
     enum {
@@ -34,6 +34,28 @@ final class TestClass extends SuperClass
 }
 )";
 
+const char kExpectedGeneratedClassOutput[] =
+R"(class TestClass
+{
+int m0;
+int m1;
+int m2;
+}
+)";
+
+// Records its own deletion.
+struct TrackedExpression : public LiteralExpression
+{
+    explicit TrackedExpression(bool* deleted)
+        :LiteralExpression("tracked"),
+         deleted(deleted)
+    {
+    }
+    ~TrackedExpression() override { *deleted = true; }
+
+    bool* deleted;
+};
+
 }  // namespace
 
 TEST(AstJavaTests, GeneratesClass) {
@@ -53,6 +75,53 @@ TEST(AstJavaTests, GeneratesClass) {
   EXPECT_EQ(string(kExpectedClassOutput), actual_output);
 }
 
+TEST(AstJavaTests, GeneratesElementsWhileWriting) {
+  JavaTypeNamespace types;
+  Type class_type(&types, "TestClass", Type::GENERATED, false, false);
+  Class a_class;
+  a_class.what = Class::CLASS;
+  a_class.type = &class_type;
+  vector<bool> written(3);
+  GeneratedElements* fields = new GeneratedElements(3,
+      [&types, &written](size_t i) {
+        written[i] = true;
+        return new Field(PACKAGE_PRIVATE,
+                         new Variable(types.IntType(),
+                                      "m" + std::to_string(i)));
+      });
+  fields->signatureTypes = {types.IntType()};
+  a_class.elements.push_back(fields);
+  EXPECT_EQ(vector<bool>(3), written);
+
+  // Gathering types does not generate the elements.
+  set<const Type*> gathered;
+  a_class.GatherTypes(&gathered);
+  EXPECT_EQ((set<const Type*>{&class_type, types.IntType()}), gathered);
+  EXPECT_EQ(vector<bool>(3), written);
+
+  string actual_output;
+  CodeWriterPtr writer = GetStringWriter(&actual_output);
+  a_class.Write(writer.get());
+  EXPECT_EQ(string(kExpectedGeneratedClassOutput), actual_output);
+  EXPECT_EQ(vector<bool>(3, true), written);
+}
+
+TEST(AstJavaTests, NodeScopeFreesNodes) {
+  bool outer_deleted = false;
+  bool inner_deleted = false;
+  {
+    NodeScope outer;
+    new TrackedExpression(&outer_deleted);
+    {
+      NodeScope inner;
+      new TrackedExpression(&inner_deleted);
+    }
+    EXPECT_TRUE(inner_deleted);
+    EXPECT_FALSE(outer_deleted);
+  }
+  EXPECT_TRUE(outer_deleted);
+}
+
 }  // namespace java
 }  // namespace aidl
 }  // namespace android
@@ -21,6 +21,8 @@
 
 #include <base/stringprintf.h>
 
+#include "stats.h"
+
 using std::cerr;
 using std::endl;
 
@@ -57,12 +59,15 @@ class FileCodeWriter : public CodeWriter {
   }
 
   bool Write(const char* format, ...) override {
-    bool success;
     va_list ap;
     va_start(ap, format);
-    success = vfprintf(output_, format, ap) >= 0;
+    int written = vfprintf(output_, format, ap);
     va_end(ap);
-    return success;
+    if (written < 0) {
+      return false;
+    }
+    stats::Increment(stats::BYTES_WRITTEN, written);
+    return true;
   }
 
  private:
@@ -0,0 +1,227 @@
+/*
+ * Copyright (C) 2015, The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "dep_graph.h"
+
+#include <iostream>
+#include <memory>
+#include <set>
+
+#include <base/strings.h>
+
+#include "aidl_language.h"
+
+using android::base::Split;
+using std::cerr;
+using std::endl;
+using std::set;
+using std::string;
+using std::unique_ptr;
+using std::vector;
+
+namespace android {
+namespace aidl {
+namespace {
+
+// The index is line oriented.  Each file record starts with
+//   f <path>
+// and is followed by one line per declared class and per imported class:
+//   d <canonical class name>
+//   i <canonical class name>
+const char kIndexHeader[] = "// aidl dependency graph v1\n";
+
+string CanonicalName(const string& package, const string& name) {
+  if (package.empty()) {
+    return name;
+  }
+  return package + "." + name;
+}
+
+}  // namespace
+
+bool DependencyGraph::AddFile(const string& filename,
+                              const IoDelegate& io_delegate) {
+  Parser p{io_delegate};
+  p.SetDiscardComments(true);
+  p.SetSkimBodies(true);
+  if (!p.ParseFile(filename)) {
+    return false;
+  }
+
+  Node node;
+  node.filename = filename;
+  unique_ptr<AidlDocument> doc(p.GetDocument());
+  for (const auto& iface : doc->GetInterfaces()) {
+    node.declared_classes.push_back(
+        CanonicalName(iface->GetPackage(), iface->GetName()));
+  }
+  for (const auto& item : doc->GetParcelables()) {
+    node.declared_classes.push_back(
+        CanonicalName(item->GetPackage(), item->GetName()));
+  }
+  for (const auto& import : p.GetImports()) {
+    node.imported_classes.push_back(import->GetNeededClass());
+  }
+
+  AddNode(std::move(node));
+  return true;
+}
+
+bool DependencyGraph::Write(CodeWriter* writer) const {
+  bool success = writer->Write(kIndexHeader);
+  for (const Node& node : nodes_) {
+    success &= writer->Write("f %s\n", node.filename.c_str());
+    for (const string& name : node.declared_classes) {
+      success &= writer->Write("d %s\n", name.c_str());
+    }
+    for (const string& name : node.imported_classes) {
+      success &= writer->Write("i %s\n", name.c_str());
+    }
+  }
+  return success;
+}
+
+bool DependencyGraph::Read(const string& filename,
+                           const IoDelegate& io_delegate) {
+  nodes_.clear();
+  nodes_by_file_.clear();
+  nodes_by_class_.clear();
+  importers_.clear();
+
+  unique_ptr<string> contents = io_delegate.GetFileContents(filename);
+  if (!contents) {
+    cerr << "aidl: can't open dependency graph: " << filename << endl;
+    return false;
+  }
+
+  bool have_node = false;
+  Node node;
+  unsigned line_number = 0;
+  for (const string& line : Split(*contents, "\n")) {
+    ++line_number;
+    if (line.empty() || line.compare(0, 2, "//") == 0) {
+      continue;
+    }
+    if (line.length() < 3 || line[1] != ' ' ||
+        (line[0] != 'f' && !have_node)) {
+      cerr << filename << ":" << line_number
+           << ": malformed dependency graph entry: " << line << endl;
+      return false;
+    }
+    const string value = line.substr(2);
+    switch (line[0]) {
+      case 'f':
+        if (have_node) {
+          AddNode(std::move(node));
+          node = Node();
+        }
+        node.filename = value;
+        have_node = true;
+        break;
+      case 'd':
+        node.declared_classes.push_back(value);
+        break;
+      case 'i':
+        node.imported_classes.push_back(value);
+        break;
+      default:
+        cerr << filename << ":" << line_number
+             << ": malformed dependency graph entry: " << line << endl;
+        return false;
+    }
+  }
+  if (have_node) {
+    AddNode(std::move(node));
+  }
+  return true;
+}
+
+vector<string> DependencyGraph::ImportsOf(const string& name) const {
+  int index = FindNode(name);
+  if (index < 0) {
+    return {};
+  }
+  return nodes_[index].imported_classes;
+}
+
+vector<string> DependencyGraph::TransitiveUsersOf(const string& name) const {
+  int start = FindNode(name);
+  // Even when |name| isn't declared by an indexed file (e.g. it comes from
+  // a preprocessed SDK file), we still know who imports it directly.
+  vector<string> pending_classes;
+  if (start < 0) {
+    pending_classes.push_back(name);
+  } else {
+    pending_classes = nodes_[start].declared_classes;
+  }
+
+  set<size_t> users;
+  set<string> visited_classes;
+  while (!pending_classes.empty()) {
+    string current = pending_classes.back();
+    pending_classes.pop_back();
+    if (!visited_classes.insert(current).second) {
+      continue;
+    }
+    auto it = importers_.find(current);
+    if (it == importers_.end()) {
+      continue;
+    }
+    for (size_t user : it->second) {
+      if (!users.insert(user).second) {
+        continue;
+      }
+      for (const string& declared : nodes_[user].declared_classes) {
+        pending_classes.push_back(declared);
+      }
+    }
+  }
+
+  set<string> files;
+  for (size_t user : users) {
+    if (static_cast<int>(user) != start) {
+      files.insert(nodes_[user].filename);
+    }
+  }
+  return vector<string>(files.begin(), files.end());
+}
+
+void DependencyGraph::AddNode(Node node) {
+  const size_t index = nodes_.size();
+  nodes_by_file_[node.filename] = index;
+  for (const string& name : node.declared_classes) {
+    nodes_by_class_[name] = index;
+  }
+  for (const string& name : node.imported_classes) {
+    importers_[name].push_back(index);
+  }
+  nodes_.push_back(std::move(node));
+}
+
+int DependencyGraph::FindNode(const string& name) const {
+  auto it = nodes_by_class_.find(name);
+  if (it != nodes_by_class_.end()) {
+    return it->second;
+  }
+  it = nodes_by_file_.find(name);
+  if (it != nodes_by_file_.end()) {
+    return it->second;
+  }
+  return -1;
+}
+
+}  // namespace aidl
+}  // namespace android
@@ -0,0 +1,80 @@
+/*
+ * Copyright (C) 2015, The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef AIDL_DEP_GRAPH_H_
+#define AIDL_DEP_GRAPH_H_
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include <base/macros.h>
+
+#include "code_writer.h"
+#include "io_delegate.h"
+
+namespace android {
+namespace aidl {
+
+// Records which classes each .aidl file declares and which classes it
+// imports, so that build tooling can work out which files are affected by a
+// change without running the compiler over the whole tree.
+class DependencyGraph {
+ public:
+  DependencyGraph() = default;
+  ~DependencyGraph() = default;
+
+  // Parse |filename| and record its declared types and imports.
+  // Returns false if the file could not be parsed.
+  bool AddFile(const std::string& filename, const IoDelegate& io_delegate);
+
+  // Serialize the graph in the index format understood by Read().
+  bool Write(CodeWriter* writer) const;
+  // Replace the contents of this graph with the index at |filename|.
+  bool Read(const std::string& filename, const IoDelegate& io_delegate);
+
+  // |name| may be either a canonical class name or an indexed file path.
+  // Returns the canonical names of the classes imported by the file
+  // declaring |name|.
+  std::vector<std::string> ImportsOf(const std::string& name) const;
+  // Returns the paths of all indexed files that directly or transitively
+  // import the file declaring |name|, sorted by path.
+  std::vector<std::string> TransitiveUsersOf(const std::string& name) const;
+
+ private:
+  struct Node {
+    std::string filename;
+    std::vector<std::string> declared_classes;
+    std::vector<std::string> imported_classes;
+  };
+
+  void AddNode(Node node);
+  // Returns the index of the node for |name|, or -1 if we don't know it.
+  int FindNode(const std::string& name) const;
+
+  std::vector<Node> nodes_;
+  std::map<std::string, size_t> nodes_by_file_;
+  std::map<std::string, size_t> nodes_by_class_;
+  // Maps a canonical class name to the nodes that import it.
+  std::map<std::string, std::vector<size_t>> importers_;
+
+  DISALLOW_COPY_AND_ASSIGN(DependencyGraph);
+};
+
+}  // namespace aidl
+}  // namespace android
+
+#endif  // AIDL_DEP_GRAPH_H_
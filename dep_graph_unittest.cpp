@@ -0,0 +1,109 @@
+/*
+ * Copyright (C) 2015, The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "dep_graph.h"
+#include "tests/fake_io_delegate.h"
+
+using android::aidl::test::FakeIoDelegate;
+using std::string;
+using std::vector;
+
+namespace android {
+namespace aidl {
+namespace {
+
+const char kFooPath[] = "p/IFoo.aidl";
+const char kFooContents[] =
+R"(package p;
+import p.IBar;
+import p.Data;
+interface IFoo { void f(IBar bar, in Data d); })";
+
+const char kBarPath[] = "p/IBar.aidl";
+const char kBarContents[] =
+R"(package p;
+import p.Data;
+interface IBar { void g(in Data d); })";
+
+const char kDataPath[] = "p/Data.aidl";
+const char kDataContents[] = "package p;\nparcelable Data;\n";
+
+const char kExpectedIndex[] =
+R"(// aidl dependency graph v1
+f p/IFoo.aidl
+d p.IFoo
+i p.IBar
+i p.Data
+f p/IBar.aidl
+d p.IBar
+i p.Data
+f p/Data.aidl
+d p.Data
+)";
+
+}  // namespace
+
+class DependencyGraphTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    io_delegate_.SetFileContents(kFooPath, kFooContents);
+    io_delegate_.SetFileContents(kBarPath, kBarContents);
+    io_delegate_.SetFileContents(kDataPath, kDataContents);
+    ASSERT_TRUE(graph_.AddFile(kFooPath, io_delegate_));
+    ASSERT_TRUE(graph_.AddFile(kBarPath, io_delegate_));
+    ASSERT_TRUE(graph_.AddFile(kDataPath, io_delegate_));
+  }
+
+  FakeIoDelegate io_delegate_;
+  DependencyGraph graph_;
+};
+
+TEST_F(DependencyGraphTest, WritesIndex) {
+  string index;
+  ASSERT_TRUE(graph_.Write(GetStringWriter(&index).get()));
+  EXPECT_EQ(kExpectedIndex, index);
+}
+
+TEST_F(DependencyGraphTest, AnswersForwardQueries) {
+  EXPECT_EQ((vector<string>{"p.IBar", "p.Data"}), graph_.ImportsOf("p.IFoo"));
+  EXPECT_EQ((vector<string>{"p.Data"}), graph_.ImportsOf(kBarPath));
+  EXPECT_TRUE(graph_.ImportsOf("p.Data").empty());
+  EXPECT_TRUE(graph_.ImportsOf("p.Unknown").empty());
+}
+
+TEST_F(DependencyGraphTest, AnswersReverseQueries) {
+  EXPECT_EQ((vector<string>{kBarPath, kFooPath}),
+            graph_.TransitiveUsersOf("p.Data"));
+  EXPECT_EQ((vector<string>{kFooPath}), graph_.TransitiveUsersOf(kBarPath));
+  EXPECT_TRUE(graph_.TransitiveUsersOf("p.IFoo").empty());
+}
+
+TEST_F(DependencyGraphTest, ReadsBackIndex) {
+  io_delegate_.SetFileContents("graph", kExpectedIndex);
+  DependencyGraph graph;
+  ASSERT_TRUE(graph.Read("graph", io_delegate_));
+  EXPECT_EQ((vector<string>{"p.IBar", "p.Data"}), graph.ImportsOf("p.IFoo"));
+  EXPECT_EQ((vector<string>{kBarPath, kFooPath}),
+            graph.TransitiveUsersOf(kDataPath));
+}
+
+}  // namespace aidl
+}  // namespace android
@@ -0,0 +1,122 @@
+/*
+ * Copyright (C) 2015, The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "dispatch_table.h"
+
+#include <algorithm>
+
+#include "trace.h"
+
+using std::vector;
+
+namespace android {
+namespace aidl {
+namespace {
+
+// Fewer codes than this are cheap to search however they are spread.
+const size_t kMinDispatchTableCodes = 4;
+// Codes spread over more than this many values per code are too sparse for
+// javac or a C++ compiler to make a jump table of a switch on them.
+const uint32_t kMaxCodeSpreadPerCode = 4;
+// Each table tried is this fraction bigger than the last.
+const uint32_t kModulusGrowthDivisor = 8;
+
+// Hash, displace and compress: the codes are put in buckets, and the
+// buckets, biggest first, are each given the first displacement that moves
+// all their codes to free slots.
+bool TryBuildDispatchTable(const vector<uint32_t>& codes, uint32_t modulus,
+                           DispatchTable* table) {
+  const size_t num_buckets = codes.size();
+  vector<vector<uint32_t>> buckets(num_buckets);
+  for (uint32_t code : codes) {
+    buckets[code % num_buckets].push_back(code);
+  }
+  vector<size_t> order(num_buckets);
+  for (size_t i = 0; i < num_buckets; ++i) {
+    order[i] = i;
+  }
+  std::stable_sort(order.begin(), order.end(), [&buckets](size_t a, size_t b) {
+    return buckets[a].size() > buckets[b].size();
+  });
+
+  table->modulus = modulus;
+  table->displacements.assign(num_buckets, 0);
+  table->codes.assign(modulus, 0);
+  vector<uint32_t> slots;
+  for (size_t bucket : order) {
+    const vector<uint32_t>& bucket_codes = buckets[bucket];
+    if (bucket_codes.empty()) {
+      break;
+    }
+    bool placed = false;
+    for (uint32_t displacement = 0; displacement < modulus && !placed;
+         ++displacement) {
+      slots.clear();
+      placed = true;
+      for (uint32_t code : bucket_codes) {
+        const uint32_t slot = (code % modulus + displacement) % modulus;
+        if (table->codes[slot] != 0 ||
+            std::find(slots.begin(), slots.end(), slot) != slots.end()) {
+          placed = false;
+          break;
+        }
+        slots.push_back(slot);
+      }
+      if (placed) {
+        table->displacements[bucket] = displacement;
+        for (size_t i = 0; i < slots.size(); ++i) {
+          table->codes[slots[i]] = bucket_codes[i];
+        }
+      }
+    }
+    if (!placed) {
+      return false;
+    }
+  }
+  return true;
+}
+
+}  // namespace
+
+bool BuildDispatchTable(const vector<uint32_t>& codes,
+                        DispatchTable* table) {
+  if (codes.size() < kMinDispatchTableCodes) {
+    return false;
+  }
+  const auto range = std::minmax_element(codes.begin(), codes.end());
+  const uint64_t spread = *range.second - *range.first;
+  if (spread < uint64_t{kMaxCodeSpreadPerCode} * codes.size()) {
+    return false;
+  }
+
+  trace::ScopedTrace trace("BuildDispatchTable");
+  // Slots to spare make the table quicker to build, but a bigger table to
+  // switch on.  A table with twice the slots needed is still dense.  Each
+  // attempt can take time quadratic in the number of codes, so the table
+  // grows geometrically, and only a few sizes are tried before giving up
+  // and switching on the codes.
+  const uint32_t count = codes.size();
+  for (uint32_t modulus = count + count / 4; modulus <= 2 * count;
+       modulus += std::max<uint32_t>(modulus / kModulusGrowthDivisor, 1)) {
+    if (TryBuildDispatchTable(codes, modulus, table)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+}  // namespace aidl
+}  // namespace android
@@ -0,0 +1,79 @@
+/*
+ * Copyright (C) 2015, The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef AIDL_DISPATCH_TABLE_H_
+#define AIDL_DISPATCH_TABLE_H_
+
+#include <cstdint>
+#include <vector>
+
+#include "resolved_interface.h"
+
+namespace android {
+namespace aidl {
+
+// A minimal perfect hash from the transaction codes of an interface to
+// slots in [0, modulus), so that a server can switch on the slot instead of
+// the code.  Compilers turn a switch over a few scattered codes into a
+// binary search, but a switch over dense slots into a jump table.
+//
+// The slot of |code| is
+//     (code % modulus + displacements[code % displacements.size()]) % modulus
+// and |code| is one of the interface's only if codes[slot] == code.
+struct DispatchTable {
+  uint32_t modulus = 0;
+  std::vector<uint32_t> displacements;
+  // The code hashed to each slot, or 0 for unused slots.  No transaction
+  // code is 0.
+  std::vector<uint32_t> codes;
+
+  uint32_t SlotOf(uint32_t code) const {
+    return (code % modulus +
+            displacements[code % displacements.size()]) % modulus;
+  }
+};
+
+// The transaction code of the method with |id|,
+// IBinder::FIRST_CALL_TRANSACTION + id.
+inline uint32_t TransactionCode(int id) { return 1 + id; }
+
+// Sets |table| for the methods of |interface| and returns true if their
+// transaction codes are too sparse for a switch on them to be a jump table,
+// and a table could be built.  Otherwise returns false, and the codes should
+// be switched on directly.
+template <typename TypeT>
+bool BuildDispatchTable(const ResolvedInterface<TypeT>& interface,
+                        DispatchTable* table);
+
+// As above, for a list of distinct, nonzero codes.
+bool BuildDispatchTable(const std::vector<uint32_t>& codes,
+                        DispatchTable* table);
+
+template <typename TypeT>
+bool BuildDispatchTable(const ResolvedInterface<TypeT>& interface,
+                        DispatchTable* table) {
+  std::vector<uint32_t> codes;
+  codes.reserve(interface.methods.size());
+  for (const auto& method : interface.methods) {
+    codes.push_back(TransactionCode(method.id));
+  }
+  return BuildDispatchTable(codes, table);
+}
+
+}  // namespace aidl
+}  // namespace android
+
+#endif  // AIDL_DISPATCH_TABLE_H_
@@ -0,0 +1,74 @@
+/*
+ * Copyright (C) 2015, The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <set>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "dispatch_table.h"
+
+using std::set;
+using std::vector;
+
+namespace android {
+namespace aidl {
+
+TEST(DispatchTableTest, LeavesDenseCodesAlone) {
+  DispatchTable table;
+  EXPECT_FALSE(BuildDispatchTable(vector<uint32_t>{1, 2, 3, 4, 5, 6, 7, 8},
+                                  &table));
+  EXPECT_FALSE(BuildDispatchTable(vector<uint32_t>{1, 5, 9, 13, 17},
+                                  &table));
+  // Too few codes to be worth it, however sparse.
+  EXPECT_FALSE(BuildDispatchTable(vector<uint32_t>{1, 1000, 50000}, &table));
+}
+
+TEST(DispatchTableTest, MapsSparseCodesToDistinctSlots) {
+  vector<uint32_t> codes;
+  for (uint32_t i = 0; i < 300; ++i) {
+    codes.push_back(1 + i * 7919 + (i * i) % 13);
+  }
+  codes.push_back(0x00fffffe);
+  DispatchTable table;
+  ASSERT_TRUE(BuildDispatchTable(codes, &table));
+  EXPECT_LE(table.modulus, 2 * codes.size());
+  EXPECT_EQ(table.modulus, table.codes.size());
+  set<uint32_t> slots;
+  for (uint32_t code : codes) {
+    const uint32_t slot = table.SlotOf(code);
+    ASSERT_LT(slot, table.modulus);
+    EXPECT_EQ(code, table.codes[slot]);
+    slots.insert(slot);
+  }
+  EXPECT_EQ(codes.size(), slots.size());
+  // Codes not in the table land on a slot holding some other code, or none.
+  EXPECT_NE(2u, table.codes[table.SlotOf(2)]);
+}
+
+TEST(DispatchTableTest, IsDeterministic) {
+  const vector<uint32_t> codes{1, 1001, 50001, 100000, 7, 65536};
+  DispatchTable first, second;
+  ASSERT_TRUE(BuildDispatchTable(codes, &first));
+  ASSERT_TRUE(BuildDispatchTable(codes, &second));
+  EXPECT_EQ(first.modulus, second.modulus);
+  EXPECT_EQ(first.displacements, second.displacements);
+  EXPECT_EQ(first.codes, second.codes);
+}
+
+}  // namespace aidl
+}  // namespace android
@@ -17,6 +17,7 @@
 #include "generate_cpp.h"
 
 #include <cctype>
+#include <cinttypes>
 #include <cstring>
 #include <memory>
 #include <random>
@@ -28,7 +29,9 @@
 #include "aidl_language.h"
 #include "ast_cpp.h"
 #include "code_writer.h"
+#include "dispatch_table.h"
 #include "logging.h"
+#include "trace.h"
 
 using android::base::StringPrintf;
 using android::base::Join;
@@ -59,42 +62,47 @@ string UpperCase(const std::string& s) {
   return result;
 }
 
-string BuildVarName(const AidlArgument& a) {
+// The token @CompactInterfaceToken interfaces send in place of their
+// descriptor, as Java proxies and stubs do.
+string DescriptorHashLiteral(const AidlInterface& interface) {
+  return StringPrintf("static_cast<int64_t>(0x%016" PRIx64 "ULL)",
+                      interface.GetDescriptorHash());
+}
+
+string BuildVarName(const ResolvedArgument<Type>& a) {
   string prefix = "out_";
-  if (a.GetDirection() & AidlArgument::IN_DIR) {
+  if (a.IsIn()) {
     prefix = "in_";
   }
   return prefix + a.GetName();
 }
 
-ArgList BuildArgList(const TypeNamespace& types,
-                     const AidlMethod& method,
+ArgList BuildArgList(const ResolvedMethod<Type>& method,
                      bool for_declaration) {
   // Build up the argument list for the server method call.
   vector<string> method_arguments;
-  for (const unique_ptr<AidlArgument>& a : method.GetArguments()) {
+  for (const ResolvedArgument<Type>& a : method.arguments) {
     string literal;
     if (for_declaration) {
       // Method declarations need types, pointers to out params, and variable
       // names that match the .aidl specification.
-      const Type* type = types.Find(a->GetType().GetName());
       literal = StringPrintf(
-          "%s%s %s", type->CppType().c_str(),
-          (a->IsOut()) ? "*" : "",
-          a->GetName().c_str());
+          "%s%s %s", a.type.type->CppType().c_str(),
+          (a.IsOut()) ? "*" : "",
+          a.GetName().c_str());
     } else {
-      if (a->IsOut()) { literal = "&"; }
-      literal += BuildVarName(*a);
+      if (a.IsOut()) { literal = "&"; }
+      literal += BuildVarName(a);
     }
     method_arguments.push_back(literal);
   }
 
-  const Type* return_type = types.Find(method.GetType().GetName());
-  if (return_type != types.VoidType()) {
+  if (!method.returns_void) {
     string literal;
     if (for_declaration) {
       literal = StringPrintf(
-          "%s* %s", return_type->CppType().c_str(), kReturnVarName);
+          "%s* %s", method.return_type.type->CppType().c_str(),
+          kReturnVarName);
     } else {
       literal = string{"&"} + kReturnVarName;
     }
@@ -104,8 +112,7 @@ ArgList BuildArgList(const TypeNamespace& types,
   return ArgList(method_arguments);
 }
 
-unique_ptr<Declaration> BuildMethodDecl(const AidlMethod& method,
-                                        const TypeNamespace& types,
+unique_ptr<Declaration> BuildMethodDecl(const ResolvedMethod<Type>& method,
                                         bool for_interface) {
   uint32_t modifiers = 0;
   if (for_interface) {
@@ -118,7 +125,7 @@ unique_ptr<Declaration> BuildMethodDecl(const AidlMethod& method,
   return unique_ptr<Declaration>{
       new MethodDecl{kAndroidStatusLiteral,
                      method.GetName(),
-                     BuildArgList(types, method, true /* for method decl */),
+                     BuildArgList(method, true /* for method decl */),
                      modifiers}};
 }
 
@@ -135,13 +142,9 @@ unique_ptr<CppNamespace> NestInNamespaces(
   return NPtr{new N{"android", NPtr{new N{"generated", std::move(decls)}}}};
 }
 
-bool DeclareLocalVariable(const TypeNamespace& types, const AidlArgument& a,
+void DeclareLocalVariable(const ResolvedArgument<Type>& a,
                           StatementBlock* b) {
-  const Type* cpp_type = types.Find(a.GetType().GetName());
-  if (!cpp_type) { return false; }
-
-  b->AddLiteral(cpp_type->CppType() + " " + BuildVarName(a));
-  return true;
+  b->AddLiteral(a.type.type->CppType() + " " + BuildVarName(a));
 }
 
 enum class ClassNames { BASE, CLIENT, SERVER, INTERFACE };
@@ -189,14 +192,14 @@ string BuildHeaderGuard(const AidlInterface& interface,
   return ret;
 }
 
-unique_ptr<Declaration> DefineClientTransaction(const TypeNamespace& types,
-                                                const AidlInterface& interface,
-                                                const AidlMethod& method) {
+unique_ptr<Declaration> DefineClientTransaction(
+    const AidlInterface& interface,
+    const ResolvedMethod<Type>& method) {
   const string i_name = ClassName(interface, ClassNames::INTERFACE);
   const string bp_name = ClassName(interface, ClassNames::CLIENT);
   unique_ptr<MethodImpl> ret{new MethodImpl{
       kAndroidStatusLiteral, bp_name, method.GetName(),
-      ArgList{BuildArgList(types, method, true /* for method decl */)}}};
+      ArgList{BuildArgList(method, true /* for method decl */)}}};
   StatementBlock* b = ret->GetStatementBlock();
 
   // Declare parcels to hold our query and the response.
@@ -205,12 +208,21 @@ unique_ptr<Declaration> DefineClientTransaction(const TypeNamespace& types,
   // And declare the status variable we need for error handling.
   b->AddLiteral(StringPrintf("%s status", kAndroidStatusLiteral));
 
+  if (interface.HasCompactToken()) {
+    b->AddStatement(new Assignment(
+        "status",
+        new MethodCall("data.writeInt64",
+                       ArgList(DescriptorHashLiteral(interface)))));
+    b->AddLiteral(kStatusOkOrReturnLiteral, false /* no semicolon */);
+  }
+
   // Serialization looks roughly like:
   //     status = data.WriteInt32(in_param_name);
   //     if (status != android::OK) { return status; }
-  for (const AidlArgument* a : method.GetInArguments()) {
-    string method = types.Find(a->GetType().GetName())->WriteToParcelMethod();
-    string var_name = ((a->IsOut()) ? "*" : "") + a->GetName();
+  for (const ResolvedArgument<Type>& a : method.arguments) {
+    if (!a.IsIn()) { continue; }
+    string method = a.type.type->WriteToParcelMethod();
+    string var_name = ((a.IsOut()) ? "*" : "") + a.GetName();
     b->AddStatement(new Assignment(
         "status",
         new MethodCall("data." + method, ArgList(var_name))));
@@ -227,23 +239,23 @@ unique_ptr<Declaration> DefineClientTransaction(const TypeNamespace& types,
   b->AddLiteral(kStatusOkOrReturnLiteral, false /* no semicolon */);
 
   // If the method is expected to return something, read it first by convention.
-  const Type* return_type = types.Find(method.GetType().GetName());
-  if (return_type != types.VoidType()) {
-    string method = return_type->ReadFromParcelMethod();
+  if (!method.returns_void) {
+    string read_method = method.return_type.type->ReadFromParcelMethod();
     b->AddStatement(new Assignment(
         "status",
-        new MethodCall("reply." + method, ArgList(kReturnVarName))));
+        new MethodCall("reply." + read_method, ArgList(kReturnVarName))));
     b->AddLiteral(kStatusOkOrReturnLiteral, false /* no semicolon */);
   }
 
-  for (const AidlArgument* a : method.GetOutArguments()) {
+  for (const ResolvedArgument<Type>& a : method.arguments) {
+    if (!a.IsOut()) { continue; }
     // Deserialization looks roughly like:
     //     status = reply.ReadInt32(out_param_name);
     //     if (status != android::OK) { return status; }
-    string method = types.Find(a->GetType().GetName())->ReadFromParcelMethod();
+    string method = a.type.type->ReadFromParcelMethod();
     b->AddStatement(new Assignment(
         "status",
-        new MethodCall("reply." + method, ArgList(a->GetName()))));
+        new MethodCall("reply." + method, ArgList(a.GetName()))));
     b->AddLiteral(kStatusOkOrReturnLiteral, false /* no semicolon */);
   }
 
@@ -254,8 +266,10 @@ unique_ptr<Declaration> DefineClientTransaction(const TypeNamespace& types,
 
 }  // namespace
 
-unique_ptr<Document> BuildClientSource(const TypeNamespace& types,
-                                       const AidlInterface& interface) {
+unique_ptr<Document> BuildClientSource(
+    const ResolvedInterface<Type>& resolved) {
+  trace::ScopedTrace trace("BuildClientSource");
+  const AidlInterface& interface = *resolved.interface;
   const string bp_name = ClassName(interface, ClassNames::CLIENT);
   vector<string> include_list = { bp_name + ".h", kParcelHeader };
   vector<unique_ptr<Declaration>> file_decls;
@@ -268,12 +282,12 @@ unique_ptr<Document> BuildClientSource(const TypeNamespace& types,
       { "BpInterface<IPingResponder>(impl)" }}});
 
   // Clients define a method per transaction.
-  for (const auto& method : interface.GetMethods()) {
-    unique_ptr<Declaration> m = DefineClientTransaction(
-        types, interface, *method);
-    if (!m) { return nullptr; }
-    file_decls.push_back(std::move(m));
-  }
+  const ResolvedInterface<Type>* r = &resolved;
+  file_decls.push_back(unique_ptr<Declaration>{new GeneratedDeclarations{
+      resolved.methods.size(),
+      [r](size_t i) {
+        return DefineClientTransaction(*r->interface, r->methods[i]);
+      }}});
   return unique_ptr<Document>{new CppSource{
       include_list,
       NestInNamespaces(std::move(file_decls))}};
@@ -281,32 +295,40 @@ unique_ptr<Document> BuildClientSource(const TypeNamespace& types,
 
 namespace {
 
-bool HandleServerTransaction(const TypeNamespace& types,
-                             const AidlMethod& method,
+void HandleServerTransaction(const AidlInterface& interface,
+                             const ResolvedMethod<Type>& method,
                              StatementBlock* b) {
+  // Check the token first, if the client sends one.
+  if (interface.HasCompactToken()) {
+    b->AddLiteral(StringPrintf(
+        "if (data.readInt64() != %s) { "
+        "status = android::PERMISSION_DENIED; break; }",
+        DescriptorHashLiteral(interface).c_str()), false /* no semicolon */);
+  }
+
   // Declare all the parameters now.  In the common case, we expect no errors
   // in serialization.
-  for (const unique_ptr<AidlArgument>& a : method.GetArguments()) {
-    if (!DeclareLocalVariable(types, *a, b)) { return false; }
+  for (const ResolvedArgument<Type>& a : method.arguments) {
+    DeclareLocalVariable(a, b);
   }
 
   // Declare a variable to hold the return value.
-  const Type* return_type = types.Find(method.GetType().GetName());
-  if (return_type != types.VoidType()) {
+  const Type* return_type = method.return_type.type;
+  if (!method.returns_void) {
     b->AddLiteral(StringPrintf(
         "%s %s", return_type->CppType().c_str(), kReturnVarName));
   }
 
   // Deserialize each "in" parameter to the transaction.
-  for (const AidlArgument* a : method.GetInArguments()) {
+  for (const ResolvedArgument<Type>& a : method.arguments) {
+    if (!a.IsIn()) { continue; }
     // Deserialization looks roughly like:
     //     status = data.ReadInt32(&in_param_name);
     //     if (status != android::OK) { break; }
-    const Type* type = types.Find(a->GetType().GetName());
     b->AddStatement(new Assignment{
         "status",
-        new MethodCall{"data." + type->ReadFromParcelMethod(),
-                       "&" + BuildVarName(*a)}});
+        new MethodCall{"data." + a.type.type->ReadFromParcelMethod(),
+                       "&" + BuildVarName(a)}});
     b->AddLiteral(kStatusOkOrBreakCheck, false /* no semicolon */);
   }
 
@@ -314,11 +336,11 @@ bool HandleServerTransaction(const TypeNamespace& types,
   b->AddStatement(new Assignment{
       "status", new MethodCall{
           method.GetName(),
-          BuildArgList(types, method, false /* not for method decl */)}});
+          BuildArgList(method, false /* not for method decl */)}});
   b->AddLiteral(kStatusOkOrBreakCheck, false /* no semicolon */);
 
   // If we have a return value, write it first.
-  if (return_type != types.VoidType()) {
+  if (!method.returns_void) {
     string method = "reply->" + return_type->WriteToParcelMethod();
     b->AddStatement(new Assignment{
         "status", new MethodCall{method, ArgList{kReturnVarName}}});
@@ -326,25 +348,33 @@ bool HandleServerTransaction(const TypeNamespace& types,
   }
 
   // Write each out parameter to the reply parcel.
-  for (const AidlArgument* a : method.GetOutArguments()) {
+  for (const ResolvedArgument<Type>& a : method.arguments) {
+    if (!a.IsOut()) { continue; }
     // Serialization looks roughly like:
     //     status = data.WriteInt32(out_param_name);
     //     if (status != android::OK) { break; }
-    const Type* type = types.Find(a->GetType().GetName());
     b->AddStatement(new Assignment{
         "status",
-        new MethodCall{"reply->" + type->WriteToParcelMethod(),
-                       BuildVarName(*a)}});
+        new MethodCall{"reply->" + a.type.type->WriteToParcelMethod(),
+                       BuildVarName(a)}});
     b->AddLiteral(kStatusOkOrBreakCheck, false /* no semicolon */);
   }
+}
 
-  return true;
+string ArrayLiteral(const vector<uint32_t>& values) {
+  vector<string> literals;
+  for (uint32_t value : values) {
+    literals.push_back(StringPrintf("%uu", value));
+  }
+  return "{" + Join(literals, ", ") + "}";
 }
 
 }  // namespace
 
-unique_ptr<Document> BuildServerSource(const TypeNamespace& types,
-                                       const AidlInterface& parsed_doc) {
+unique_ptr<Document> BuildServerSource(
+    const ResolvedInterface<Type>& resolved) {
+  trace::ScopedTrace trace("BuildServerSource");
+  const AidlInterface& parsed_doc = *resolved.interface;
   const string bn_name = ClassName(parsed_doc, ClassNames::SERVER);
   vector<string> include_list{bn_name + ".h", kParcelHeader};
   unique_ptr<MethodImpl> on_transact{new MethodImpl{
@@ -359,17 +389,47 @@ unique_ptr<Document> BuildServerSource(const TypeNamespace& types,
   on_transact->GetStatementBlock()->AddLiteral(
       StringPrintf("%s status", kAndroidStatusLiteral));
 
+  // Sparse transaction codes are first mapped to dense slots, which the
+  // compiler can turn into a jump table.  Codes that are not the interface's
+  // are mapped to |modulus|, which has no case.
+  std::shared_ptr<DispatchTable> table = std::make_shared<DispatchTable>();
+  string switch_on = "code";
+  if (BuildDispatchTable(resolved, table.get())) {
+    on_transact->GetStatementBlock()->AddLiteral(StringPrintf(
+        "static const uint32_t kDispatchDisplacements[] = %s",
+        ArrayLiteral(table->displacements).c_str()));
+    on_transact->GetStatementBlock()->AddLiteral(StringPrintf(
+        "static const uint32_t kDispatchCodes[] = %s",
+        ArrayLiteral(table->codes).c_str()));
+    on_transact->GetStatementBlock()->AddLiteral(StringPrintf(
+        "const uint32_t slot = (code %% %uu + "
+        "kDispatchDisplacements[code %% %zuu]) %% %uu",
+        table->modulus, table->displacements.size(), table->modulus));
+    switch_on = StringPrintf("kDispatchCodes[slot] == code ? slot : %uu",
+                             table->modulus);
+  } else {
+    table.reset();
+  }
+
   // Add the all important switch statement, but retain a pointer to it.
-  SwitchStatement* s = new SwitchStatement{"code"};
+  SwitchStatement* s = new SwitchStatement{switch_on};
   on_transact->GetStatementBlock()->AddStatement(s);
 
-  // The switch statement has a case statement for each transaction code.
-  for (const auto& method : parsed_doc.GetMethods()) {
-    StatementBlock* b = s->AddCase("Call::" + UpperCase(method->GetName()));
-    if (!b) { return nullptr; }
-
-    if (!HandleServerTransaction(types, *method, b)) { return nullptr; }
-  }
+  // The switch statement has a case statement for each transaction code, or
+  // its slot.  Method names are unique, so the case values are too.
+  const ResolvedInterface<Type>* r = &resolved;
+  s->AddCases(resolved.methods.size(),
+              [r, table](size_t i, StatementBlock* b) {
+    const ResolvedMethod<Type>& method = r->methods[i];
+    HandleServerTransaction(*r->interface, method, b);
+    const string call = "Call::" + UpperCase(method.GetName());
+    if (table) {
+      return StringPrintf("%u /* %s */",
+                          table->SlotOf(TransactionCode(method.id)),
+                          call.c_str());
+    }
+    return call;
+  });
 
   // The switch statement has a default case which defers to the super class.
   // The superclass handles a few pre-defined transactions.
@@ -385,8 +445,10 @@ unique_ptr<Document> BuildServerSource(const TypeNamespace& types,
       NestInNamespaces(std::move(on_transact))}};
 }
 
-unique_ptr<Document> BuildInterfaceSource(const TypeNamespace& /* types */,
-                                          const AidlInterface& parsed_doc) {
+unique_ptr<Document> BuildInterfaceSource(
+    const ResolvedInterface<Type>& resolved) {
+  trace::ScopedTrace trace("BuildInterfaceSource");
+  const AidlInterface& parsed_doc = *resolved.interface;
   const string i_name = ClassName(parsed_doc, ClassNames::INTERFACE);
   const string bp_name = ClassName(parsed_doc, ClassNames::CLIENT);
   vector<string> include_list{i_name + ".h", bp_name + ".h"};
@@ -406,8 +468,10 @@ unique_ptr<Document> BuildInterfaceSource(const TypeNamespace& /* types */,
       NestInNamespaces(std::move(meta_if))}};
 }
 
-unique_ptr<Document> BuildClientHeader(const TypeNamespace& types,
-                                       const AidlInterface& interface) {
+unique_ptr<Document> BuildClientHeader(
+    const ResolvedInterface<Type>& resolved) {
+  trace::ScopedTrace trace("BuildClientHeader");
+  const AidlInterface& interface = *resolved.interface;
   const string i_name = ClassName(interface, ClassNames::INTERFACE);
   const string bp_name = ClassName(interface, ClassNames::CLIENT);
 
@@ -425,9 +489,10 @@ unique_ptr<Document> BuildClientHeader(const TypeNamespace& types,
   publics.push_back(std::move(constructor));
   publics.push_back(std::move(destructor));
 
-  for (const auto& method: interface.GetMethods()) {
-    publics.push_back(BuildMethodDecl(*method, types, false));
-  }
+  const ResolvedInterface<Type>* r = &resolved;
+  publics.push_back(unique_ptr<Declaration>{new GeneratedDeclarations{
+      resolved.methods.size(),
+      [r](size_t i) { return BuildMethodDecl(r->methods[i], false); }}});
 
   unique_ptr<ClassDecl> bp_class{
       new ClassDecl{bp_name,
@@ -445,8 +510,10 @@ unique_ptr<Document> BuildClientHeader(const TypeNamespace& types,
       NestInNamespaces(std::move(bp_class))}};
 }
 
-unique_ptr<Document> BuildServerHeader(const TypeNamespace& /* types */,
-                                       const AidlInterface& interface) {
+unique_ptr<Document> BuildServerHeader(
+    const ResolvedInterface<Type>& resolved) {
+  trace::ScopedTrace trace("BuildServerHeader");
+  const AidlInterface& interface = *resolved.interface;
   const string i_name = ClassName(interface, ClassNames::INTERFACE);
   const string bn_name = ClassName(interface, ClassNames::SERVER);
 
@@ -476,8 +543,10 @@ unique_ptr<Document> BuildServerHeader(const TypeNamespace& /* types */,
       NestInNamespaces(std::move(bn_class))}};
 }
 
-unique_ptr<Document> BuildInterfaceHeader(const TypeNamespace& types,
-                                          const AidlInterface& interface) {
+unique_ptr<Document> BuildInterfaceHeader(
+    const ResolvedInterface<Type>& resolved) {
+  trace::ScopedTrace trace("BuildInterfaceHeader");
+  const AidlInterface& interface = *resolved.interface;
   unique_ptr<ClassDecl> if_class{
       new ClassDecl{ClassName(interface, ClassNames::INTERFACE),
                     "android::IInterface"}};
@@ -485,14 +554,17 @@ unique_ptr<Document> BuildInterfaceHeader(const TypeNamespace& types,
       "DECLARE_META_INTERFACE",
       ArgList{vector<string>{ClassName(interface, ClassNames::BASE)}}}});
 
+  // Each method gets an enum entry and pure virtual declaration.
+  const ResolvedInterface<Type>* r = &resolved;
+  if_class->AddPublic(unique_ptr<Declaration>{new GeneratedDeclarations{
+      resolved.methods.size(),
+      [r](size_t i) { return BuildMethodDecl(r->methods[i], true); }}});
   unique_ptr<Enum> call_enum{new Enum{"Call"}};
-  for (const auto& method : interface.GetMethods()) {
-    // Each method gets an enum entry and pure virtual declaration.
-    if_class->AddPublic(BuildMethodDecl(*method, types, true));
+  for (const ResolvedMethod<Type>& method : resolved.methods) {
     call_enum->AddValue(
-        UpperCase(method->GetName()),
+        UpperCase(method.GetName()),
         StringPrintf("android::IBinder::FIRST_CALL_TRANSACTION + %d",
-                     method->GetId()));
+                     method.id));
   }
   if_class->AddPublic(std::move(call_enum));
 
@@ -503,11 +575,16 @@ unique_ptr<Document> BuildInterfaceHeader(const TypeNamespace& types,
       NestInNamespaces(std::move(if_class))}};
 }
 
-bool GenerateCppForFile(const std::string& name, unique_ptr<Document> doc) {
+bool GenerateCppForFile(const std::string& name, unique_ptr<Document> doc,
+                        const IoDelegate& io_delegate) {
   if (!doc) {
     return false;
   }
-  unique_ptr<CodeWriter> writer = GetFileWriter(name);
+  trace::ScopedTrace trace("write_cpp", name);
+  unique_ptr<CodeWriter> writer = io_delegate.GetCodeWriter(name);
+  if (!writer) {
+    return false;
+  }
   doc->Write(writer.get());
   return true;
 }
@@ -517,22 +594,28 @@ bool GenerateCppForFile(const std::string& name, unique_ptr<Document> doc) {
 using namespace internals;
 
 bool GenerateCpp(const CppOptions& options,
-                 const TypeNamespace& types,
-                 const AidlInterface& parsed_doc) {
+                 const ResolvedInterface<Type>& interface,
+                 const IoDelegate& io_delegate) {
   bool success = true;
 
   success &= GenerateCppForFile(options.ClientCppFileName(),
-                                BuildClientSource(types, parsed_doc));
+                                BuildClientSource(interface),
+                                io_delegate);
   success &= GenerateCppForFile(options.ClientHeaderFileName(),
-                                BuildClientHeader(types, parsed_doc));
+                                BuildClientHeader(interface),
+                                io_delegate);
   success &= GenerateCppForFile(options.ServerCppFileName(),
-                                BuildServerSource(types, parsed_doc));
+                                BuildServerSource(interface),
+                                io_delegate);
   success &= GenerateCppForFile(options.ServerHeaderFileName(),
-                                BuildServerHeader(types, parsed_doc));
+                                BuildServerHeader(interface),
+                                io_delegate);
   success &= GenerateCppForFile(options.InterfaceCppFileName(),
-                                BuildInterfaceSource(types, parsed_doc));
+                                BuildInterfaceSource(interface),
+                                io_delegate);
   success &= GenerateCppForFile(options.InterfaceHeaderFileName(),
-                                BuildInterfaceHeader(types, parsed_doc));
+                                BuildInterfaceHeader(interface),
+                                io_delegate);
 
   return success;
 }
@@ -19,7 +19,9 @@
 
 #include "aidl_language.h"
 #include "ast_cpp.h"
+#include "io_delegate.h"
 #include "options.h"
+#include "resolved_interface.h"
 #include "type_cpp.h"
 
 namespace android {
@@ -27,22 +29,24 @@ namespace aidl {
 namespace cpp {
 
 bool GenerateCpp(const CppOptions& options,
-                 const cpp::TypeNamespace& types,
-                 const AidlInterface& parsed_doc);
+                 const ResolvedInterface<Type>& interface,
+                 const IoDelegate& io_delegate);
 
 namespace internals {
-std::unique_ptr<Document> BuildClientSource(const TypeNamespace& types,
-                                            const AidlInterface& parsed_doc);
-std::unique_ptr<Document> BuildServerSource(const TypeNamespace& types,
-                                            const AidlInterface& parsed_doc);
-std::unique_ptr<Document> BuildInterfaceSource(const TypeNamespace& types,
-                                               const AidlInterface& parsed_doc);
-std::unique_ptr<Document> BuildClientHeader(const TypeNamespace& types,
-                                            const AidlInterface& parsed_doc);
-std::unique_ptr<Document> BuildServerHeader(const TypeNamespace& types,
-                                            const AidlInterface& parsed_doc);
-std::unique_ptr<Document> BuildInterfaceHeader(const TypeNamespace& types,
-                                               const AidlInterface& parsed_doc);
+// The per-method parts of these documents are only built while the
+// documents are written, so |interface| must outlive them.
+std::unique_ptr<Document> BuildClientSource(
+    const ResolvedInterface<Type>& interface);
+std::unique_ptr<Document> BuildServerSource(
+    const ResolvedInterface<Type>& interface);
+std::unique_ptr<Document> BuildInterfaceSource(
+    const ResolvedInterface<Type>& interface);
+std::unique_ptr<Document> BuildClientHeader(
+    const ResolvedInterface<Type>& interface);
+std::unique_ptr<Document> BuildServerHeader(
+    const ResolvedInterface<Type>& interface);
+std::unique_ptr<Document> BuildInterfaceHeader(
+    const ResolvedInterface<Type>& interface);
 }
 }  // namespace cpp
 }  // namespace aidl
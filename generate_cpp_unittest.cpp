@@ -23,6 +23,7 @@
 #include "ast_cpp.h"
 #include "code_writer.h"
 #include "generate_cpp.h"
+#include "resolved_interface.h"
 #include "tests/fake_io_delegate.h"
 #include "type_cpp.h"
 
@@ -200,27 +201,31 @@ IMPLEMENT_META_INTERFACE(PingResponder, "IPingResponder");
 
 class TrivialInterfaceASTTest : public ::testing::Test {
  protected:
-  AidlInterface* Parse() {
+  const ResolvedInterface<Type>* Parse(
+      const char* contents = kTrivialInterfaceAIDL) {
 
   FakeIoDelegate io_delegate;
-  io_delegate.SetFileContents("IPingResponder.aidl", kTrivialInterfaceAIDL);
+  io_delegate.SetFileContents("IPingResponder.aidl", contents);
 
-  cpp::TypeNamespace types;
-  AidlInterface* ret = nullptr;
+  std::vector<std::unique_ptr<AidlInterface>> interfaces;
   std::vector<std::unique_ptr<AidlImport>> imports;
   int err = ::android::aidl::internals::load_and_validate_aidl(
       {},  // no preprocessed files
       {},  // no import paths
       "IPingResponder.aidl",
       io_delegate,
-      &types,
-      &ret,
+      &types_,
+      &interfaces,
       &imports);
 
     if (err)
       return nullptr;
 
-    return ret;
+    interface_ = std::move(interfaces.front());
+    if (!ResolveInterface(*interface_, types_, &resolved_))
+      return nullptr;
+
+    return &resolved_;
    }
 
   void Compare(Document* doc, const char* expected) {
@@ -231,56 +236,112 @@ class TrivialInterfaceASTTest : public ::testing::Test {
 
     EXPECT_EQ(expected, output);
   }
+
+  TypeNamespace types_;
+  unique_ptr<AidlInterface> interface_;
+  ResolvedInterface<Type> resolved_;
 };
 
 TEST_F(TrivialInterfaceASTTest, GeneratesClientHeader) {
-  AidlInterface* interface = Parse();
+  const ResolvedInterface<Type>* interface = Parse();
   ASSERT_NE(interface, nullptr);
-  TypeNamespace types;
-  unique_ptr<Document> doc = internals::BuildClientHeader(types, *interface);
+  unique_ptr<Document> doc = internals::BuildClientHeader(*interface);
   Compare(doc.get(), kExpectedTrivialClientHeaderOutput);
 }
 
 TEST_F(TrivialInterfaceASTTest, GeneratesClientSource) {
-  AidlInterface* interface = Parse();
+  const ResolvedInterface<Type>* interface = Parse();
   ASSERT_NE(interface, nullptr);
-  TypeNamespace types;
-  unique_ptr<Document> doc = internals::BuildClientSource(types, *interface);
+  unique_ptr<Document> doc = internals::BuildClientSource(*interface);
   Compare(doc.get(), kExpectedTrivialClientSourceOutput);
 }
 
 TEST_F(TrivialInterfaceASTTest, GeneratesServerHeader) {
-  AidlInterface* interface = Parse();
+  const ResolvedInterface<Type>* interface = Parse();
   ASSERT_NE(interface, nullptr);
-  TypeNamespace types;
-  unique_ptr<Document> doc = internals::BuildServerHeader(types, *interface);
+  unique_ptr<Document> doc = internals::BuildServerHeader(*interface);
   Compare(doc.get(), kExpectedTrivialServerHeaderOutput);
 }
 
 TEST_F(TrivialInterfaceASTTest, GeneratesServerSource) {
-  AidlInterface* interface = Parse();
+  const ResolvedInterface<Type>* interface = Parse();
   ASSERT_NE(interface, nullptr);
-  TypeNamespace types;
-  unique_ptr<Document> doc = internals::BuildServerSource(types, *interface);
+  unique_ptr<Document> doc = internals::BuildServerSource(*interface);
   Compare(doc.get(), kExpectedTrivialServerSourceOutput);
 }
 
 TEST_F(TrivialInterfaceASTTest, GeneratesInterfaceHeader) {
-  AidlInterface* interface = Parse();
+  const ResolvedInterface<Type>* interface = Parse();
   ASSERT_NE(interface, nullptr);
-  TypeNamespace types;
-  unique_ptr<Document> doc = internals::BuildInterfaceHeader(types, *interface);
+  unique_ptr<Document> doc = internals::BuildInterfaceHeader(*interface);
   Compare(doc.get(), kExpectedTrivialInterfaceHeaderOutput);
 }
 
 TEST_F(TrivialInterfaceASTTest, GeneratesInterfaceSource) {
-  AidlInterface* interface = Parse();
+  const ResolvedInterface<Type>* interface = Parse();
   ASSERT_NE(interface, nullptr);
-  TypeNamespace types;
-  unique_ptr<Document> doc = internals::BuildInterfaceSource(types, *interface);
+  unique_ptr<Document> doc = internals::BuildInterfaceSource(*interface);
   Compare(doc.get(), kExpectedTrivialInterfaceSourceOutput);
 }
 
+TEST_F(TrivialInterfaceASTTest, SendsCompactTokens) {
+  const ResolvedInterface<Type>* interface = Parse(
+      "@CompactInterfaceToken\n"
+      "interface IPingResponder {\n"
+      "  int Ping(int token);\n"
+      "}\n");
+  ASSERT_NE(interface, nullptr);
+  // The hash of the descriptor is part of the protocol, so it must not
+  // change.
+  const string token = "static_cast<int64_t>(0x9a5ae143c134cd66ULL)";
+
+  string client;
+  unique_ptr<CodeWriter> cw = GetStringWriter(&client);
+  internals::BuildClientSource(*interface)->Write(cw.get());
+  EXPECT_NE(string::npos, client.find(
+      "android::status_t status;\n"
+      "status = data.writeInt64(" + token + ");\n"
+      "if (status != android::OK) { return status; }\n"
+      "status = data.writeInt32(token);\n"));
+
+  string server;
+  cw = GetStringWriter(&server);
+  internals::BuildServerSource(*interface)->Write(cw.get());
+  EXPECT_NE(string::npos, server.find(
+      "case Call::PING:\n{\n"
+      "if (data.readInt64() != " + token + ") { "
+      "status = android::PERMISSION_DENIED; break; }\n"));
+}
+
+TEST_F(TrivialInterfaceASTTest, DispatchesSparseCodesThroughTable) {
+  const ResolvedInterface<Type>* interface = Parse(
+      "interface IPingResponder {\n"
+      "  int Ping(int token) = 0;\n"
+      "  int Pong(int token) = 1000;\n"
+      "  int Ding(int token) = 50000;\n"
+      "  int Dong(int token) = 99999;\n"
+      "}\n");
+  ASSERT_NE(interface, nullptr);
+
+  string server;
+  unique_ptr<CodeWriter> cw = GetStringWriter(&server);
+  internals::BuildServerSource(*interface)->Write(cw.get());
+  EXPECT_NE(string::npos, server.find(
+      "static const uint32_t kDispatchDisplacements[] = {0u, 0u, 0u, 0u};\n"
+      "static const uint32_t kDispatchCodes[] = "
+      "{0u, 1u, 0u, 50001u, 100000u, 1001u};\n"
+      "const uint32_t slot = "
+      "(code % 6u + kDispatchDisplacements[code % 4u]) % 6u;\n"
+      "switch (kDispatchCodes[slot] == code ? slot : 6u) {\n"
+      "case 1 /* Call::PING */:\n"));
+  EXPECT_NE(string::npos, server.find("case 5 /* Call::PONG */:\n"));
+  EXPECT_NE(string::npos, server.find("case 3 /* Call::DING */:\n"));
+  EXPECT_NE(string::npos, server.find("case 4 /* Call::DONG */:\n"));
+  EXPECT_NE(string::npos, server.find(
+      "default:\n{\n"
+      "status = android::BBinder::onTransact(code, data, reply, flags);\n"));
+}
+
 }  // namespace cpp
 }  // namespace aidl
 }  // namespace android
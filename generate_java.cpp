@@ -5,6 +5,7 @@
 #include <string.h>
 
 #include "code_writer.h"
+#include "trace.h"
 #include "type_java.h"
 
 using ::android::aidl::java::Variable;
@@ -49,12 +50,16 @@ namespace java {
 
 int
 generate_java(const string& filename, const string& originalSrc,
-                AidlInterface* iface, JavaTypeNamespace* types)
+                const ResolvedInterface<Type>& resolved,
+                JavaTypeNamespace* types, const IoDelegate& io_delegate,
+                bool instrument)
 {
+    const AidlInterface* iface = resolved.interface;
     Class* cl;
 
     if (iface->item_type == INTERFACE_TYPE_BINDER) {
-        cl = generate_binder_interface_class(iface, types);
+        trace::ScopedTrace trace("generate_binder_interface_class");
+        cl = generate_binder_interface_class(resolved, types, instrument);
     }
 
     Document* document = new Document;
@@ -64,7 +69,11 @@ generate_java(const string& filename, const string& originalSrc,
         document->originalSrc = originalSrc;
         document->classes.push_back(cl);
 
-    CodeWriterPtr code_writer = GetFileWriter(filename);
+    trace::ScopedTrace trace("write_java", filename);
+    CodeWriterPtr code_writer = io_delegate.GetCodeWriter(filename);
+    if (!code_writer) {
+        return 1;
+    }
     document->Write(code_writer.get());
 
     return 0;
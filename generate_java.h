@@ -5,6 +5,8 @@
 
 #include "aidl_language.h"
 #include "ast_java.h"
+#include "io_delegate.h"
+#include "resolved_interface.h"
 
 namespace android {
 namespace aidl {
@@ -15,12 +17,18 @@ using std::vector;
 namespace java {
 
 class JavaTypeNamespace;
+class Type;
 
+// If |instrument| is set, the stub and proxy report the duration and Parcel
+// sizes of each transaction to a listener installed on the stub.
 int generate_java(const string& filename, const string& originalSrc,
-                  AidlInterface* iface, java::JavaTypeNamespace* types);
+                  const ResolvedInterface<Type>& iface,
+                  java::JavaTypeNamespace* types,
+                  const IoDelegate& io_delegate, bool instrument);
 
 android::aidl::java::Class* generate_binder_interface_class(
-    const AidlInterface* iface, java::JavaTypeNamespace* types);
+    const ResolvedInterface<Type>& iface, java::JavaTypeNamespace* types,
+    bool instrument);
 
 }  // namespace java
 
@@ -1,12 +1,16 @@
 #include "generate_java.h"
 
+#include <inttypes.h>
 #include <string.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
+#include <memory>
+
 #include <base/macros.h>
 
+#include "dispatch_table.h"
 #include "type_java.h"
 
 namespace android {
@@ -25,7 +29,9 @@ public:
     Variable* transact_data;
     Variable* transact_reply;
     Variable* transact_flags;
+    StatementBlock* transact_statements;
     SwitchStatement* transact_switch;
+    bool compact_token;
 private:
     void make_as_interface(const Type* interfaceType, JavaTypeNamespace* types);
 
@@ -42,6 +48,7 @@ StubClass::StubClass(const Type* type, const Type* interfaceType,
     this->type = type;
     this->extends = types->BinderNativeType();
     this->interfaces.push_back(interfaceType);
+    this->compact_token = false;
 
     // descriptor
     Field* descriptor = new Field(STATIC | FINAL | PRIVATE,
@@ -89,6 +96,7 @@ StubClass::StubClass(const Type* type, const Type* interfaceType,
         onTransact->statements = new StatementBlock;
         onTransact->exceptions.push_back(types->RemoteExceptionType());
     this->elements.push_back(onTransact);
+    this->transact_statements = onTransact->statements;
     this->transact_switch = new SwitchStatement(this->transact_code);
 
     onTransact->statements->Add(this->transact_switch);
@@ -168,6 +176,8 @@ public:
 
     Variable* mRemote;
     bool mOneWay;
+    bool mBatching;
+    bool mCompactToken;
 };
 
 ProxyClass::ProxyClass(const JavaTypeNamespace* types,
@@ -180,6 +190,8 @@ ProxyClass::ProxyClass(const JavaTypeNamespace* types,
     this->interfaces.push_back(interfaceType);
 
     mOneWay = interfaceType->OneWay();
+    mBatching = false;
+    mCompactToken = false;
 
     // IBinder mRemote
     mRemote = new Variable(types->IBinderType(), "mRemote");
@@ -261,143 +273,541 @@ generate_read_from_parcel(const Type* t, StatementBlock* addTo, Variable* v,
 }
 
 
+// The interface token, the DESCRIPTOR constant marshalled as a string, or
+// DESCRIPTOR_HASH for an interface with a compact token.
 static void
-generate_method(const AidlMethod& method, Class* interface,
-                StubClass* stubClass, ProxyClass* proxyClass, int index,
-                JavaTypeNamespace* types)
+generate_write_interface_token(StatementBlock* addTo, Variable* parcel,
+                               bool compactToken)
 {
-    int i;
-    bool hasOutParams = false;
+    if (compactToken) {
+        addTo->Add(new MethodCall(parcel, "writeLong", 1,
+                new LiteralExpression("DESCRIPTOR_HASH")));
+    } else {
+        addTo->Add(new MethodCall(parcel, "writeInterfaceToken", 1,
+                new LiteralExpression("DESCRIPTOR")));
+    }
+}
 
-    const bool oneway = proxyClass->mOneWay || method.IsOneway();
+static void
+generate_enforce_interface(StatementBlock* addTo, StubClass* stubClass)
+{
+    if (stubClass->compact_token) {
+        addTo->Add(new MethodCall("enforceDescriptorHash", 1,
+                stubClass->transact_data));
+    } else {
+        addTo->Add(new MethodCall(stubClass->transact_data,
+                "enforceInterface", 1, new LiteralExpression("DESCRIPTOR")));
+    }
+}
 
-    // == the TRANSACT_ constant =============================================
-    string transactCodeName = "TRANSACTION_";
-    transactCodeName += method.GetName();
+static string
+transaction_code_name(const ResolvedMethod<Type>& method)
+{
+    return "TRANSACTION_" + method.GetName();
+}
 
+// The TRANSACTION_ constant in the stub.
+static Field*
+generate_transaction_code(const ResolvedMethod<Type>& method,
+                          JavaTypeNamespace* types)
+{
     char transactCodeValue[60];
-    sprintf(transactCodeValue, "(android.os.IBinder.FIRST_CALL_TRANSACTION + %d)", index);
+    sprintf(transactCodeValue, "(android.os.IBinder.FIRST_CALL_TRANSACTION + %d)", method.id);
 
     Field* transactCode = new Field(STATIC | FINAL,
-                            new Variable(types->IntType(), transactCodeName));
+                            new Variable(types->IntType(),
+                                         transaction_code_name(method)));
     transactCode->value = transactCodeValue;
-    stubClass->elements.push_back(transactCode);
+    return transactCode;
+}
 
-    // == the declaration in the interface ===================================
+// The declaration in the interface.
+static Method*
+generate_interface_method(const ResolvedMethod<Type>& method,
+                          JavaTypeNamespace* types)
+{
     Method* decl = new Method;
-        decl->comment = method.GetComments();
+        decl->comment = method.method->GetComments();
         decl->modifiers = PUBLIC;
-        decl->returnType = types->Find(method.GetType().GetName());
-        decl->returnTypeDimension = method.GetType().IsArray() ? 1 : 0;
+        decl->returnType = method.return_type.type;
+        decl->returnTypeDimension = method.return_type.is_array ? 1 : 0;
         decl->name = method.GetName();
 
-    for (const std::unique_ptr<AidlArgument>& arg : method.GetArguments()) {
+    for (const ResolvedArgument<Type>& arg : method.arguments) {
         decl->parameters.push_back(new Variable(
-                            types->Find(arg->GetType().GetName()), arg->GetName(),
-                            arg->GetType().IsArray() ? 1 : 0));
+                            arg.type.type, arg.GetName(),
+                            arg.type.is_array ? 1 : 0));
     }
 
     decl->exceptions.push_back(types->RemoteExceptionType());
+    return decl;
+}
+
+// long _start = java.lang.System.nanoTime();
+static Variable*
+generate_start_time(StatementBlock* addTo, JavaTypeNamespace* types)
+{
+    Variable* start = new Variable(types->Find("long"), "_start");
+    addTo->Add(new VariableDeclaration(start,
+            new MethodCall(new LiteralExpression("java.lang.System"),
+                           "nanoTime")));
+    return start;
+}
+
+// Stub.LazyParcelable<t>, the holder the stub passes for a @Lazy argument.
+static const Type*
+lazy_parcelable_type(const Type* t, JavaTypeNamespace* types)
+{
+    return new Type(types, "LazyParcelable<" + t->QualifiedName() + ">",
+                    Type::GENERATED, false, false);
+}
+
+// The return, argument and exception types of |resolved|'s methods, which
+// are all the types the declarations and proxy methods name.
+static vector<const Type*>
+method_signature_types(const ResolvedInterface<Type>& resolved,
+                       JavaTypeNamespace* types)
+{
+    set<const Type*> result;
+    for (const ResolvedMethod<Type>& method : resolved.methods) {
+        result.insert(method.return_type.type);
+        for (const ResolvedArgument<Type>& arg : method.arguments) {
+            result.insert(arg.type.type);
+        }
+    }
+    result.insert(types->RemoteExceptionType());
+    return vector<const Type*>(result.begin(), result.end());
+}
+
+static bool
+has_lazy_arguments(const ResolvedMethod<Type>& method)
+{
+    for (const ResolvedArgument<Type>& arg : method.arguments) {
+        if (arg.lazy) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// The method in the stub that the stub's onTransact() calls for a method
+// with @Lazy arguments.  It unmarshals them all and calls the interface
+// method, unless the service overrides it to unmarshal them as needed.
+static Method*
+generate_lazy_stub_method(const ResolvedMethod<Type>& method,
+                          JavaTypeNamespace* types)
+{
+    Method* m = new Method;
+        m->comment = "/** Called for " + method.GetName() + "() with its "
+                     "@Lazy arguments still marshalled. */";
+        m->modifiers = PUBLIC;
+        m->returnType = method.return_type.type;
+        m->returnTypeDimension = method.return_type.is_array ? 1 : 0;
+        m->name = method.GetName();
+        m->statements = new StatementBlock;
+        m->exceptions.push_back(types->RemoteExceptionType());
+
+    MethodCall* call = new MethodCall(THIS_VALUE, method.GetName());
+    for (const ResolvedArgument<Type>& arg : method.arguments) {
+        if (arg.lazy) {
+            Variable* v = new Variable(
+                    lazy_parcelable_type(arg.type.type, types), arg.GetName());
+            m->parameters.push_back(v);
+            call->arguments.push_back(new MethodCall(v, "get"));
+        } else {
+            Variable* v = new Variable(arg.type.type, arg.GetName(),
+                                       arg.type.is_array ? 1 : 0);
+            m->parameters.push_back(v);
+            call->arguments.push_back(v);
+        }
+    }
+    if (method.returns_void) {
+        m->statements->Add(call);
+    } else {
+        m->statements->Add(new ReturnStatement(call));
+    }
+    return m;
+}
+
+// Stub.LazyParcelable, which keeps where a @Lazy argument is in the
+// transaction's Parcel and only unmarshals it when asked to.  The proxy
+// writes the argument's length ahead of it so the stub can skip it.
+static void
+generate_lazy_parcelable(StubClass* stub, JavaTypeNamespace* types)
+{
+    const Type* voidType = types->Find("void");
+    const Type* intType = types->IntType();
+    const Type* parcelType = types->ParcelType();
+    const Type* valueType = new Type(types, "T", Type::GENERATED, false,
+                                     false);
+    const Type* creatorType = new Type(types,
+            "android.os.Parcelable.Creator<T>", Type::GENERATED, false, false);
+    const Type* parcelableType = new Type(types, "android.os.Parcelable",
+            Type::BUILT_IN, false, false);
+
+    Class* lazy = new Class;
+        lazy->comment = "/**\n"
+            " * A @Lazy argument, unmarshalled when it is first used.  If\n"
+            " * that is not during the call it was passed to, it cannot be\n"
+            " * used at all.\n"
+            " */";
+        lazy->modifiers = PUBLIC | STATIC | FINAL;
+        lazy->what = Class::CLASS;
+        lazy->type = new Type(types, "LazyParcelable<T>", Type::GENERATED,
+                              false, false);
+
+    Variable* creator = new Variable(creatorType, "mCreator");
+    lazy->elements.push_back(new Field(PRIVATE | FINAL, creator));
+    Variable* source = new Variable(parcelType, "mSource");
+    lazy->elements.push_back(new Field(PRIVATE, source));
+    Variable* offset = new Variable(intType, "mOffset");
+    lazy->elements.push_back(new Field(PRIVATE, offset));
+    Variable* length = new Variable(intType, "mLength");
+    lazy->elements.push_back(new Field(PRIVATE, length));
+    Variable* value = new Variable(valueType, "mValue");
+    lazy->elements.push_back(new Field(PRIVATE, value));
+    Variable* released = new Variable(types->BoolType(), "mReleased");
+    lazy->elements.push_back(new Field(PRIVATE, released));
+
+    // the constructor skips over the argument
+    Variable* ctorCreator = new Variable(creatorType, "creator");
+    Variable* ctorSource = new Variable(parcelType, "source");
+    Method* ctor = new Method;
+        ctor->name = "LazyParcelable";
+        ctor->parameters.push_back(ctorCreator);
+        ctor->parameters.push_back(ctorSource);
+        ctor->statements = new StatementBlock;
+    ctor->statements->Add(new Assignment(creator, ctorCreator));
+    IfStatement* notNull = new IfStatement();
+        notNull->expression = new Comparison(new LiteralExpression("0"), "!=",
+                new MethodCall(ctorSource, "readInt"));
+    notNull->statements->Add(new Assignment(length,
+            new MethodCall(ctorSource, "readInt")));
+    notNull->statements->Add(new Assignment(offset,
+            new MethodCall(ctorSource, "dataPosition")));
+    notNull->statements->Add(new Assignment(source, ctorSource));
+    notNull->statements->Add(new MethodCall(ctorSource, "setDataPosition", 1,
+            new Comparison(offset, "+", length)));
+    ctor->statements->Add(notNull);
+    lazy->elements.push_back(ctor);
+
+    // if (mReleased) throw ...
+    const Type* illegalStateType = new Type(types,
+            "java.lang.IllegalStateException", Type::BUILT_IN, false, false);
+    auto checkNotReleased = [released, illegalStateType](
+            StatementBlock* addTo) {
+        IfStatement* ifReleased = new IfStatement();
+            ifReleased->expression = released;
+        NewExpression* ex = new NewExpression(illegalStateType);
+        ex->arguments.push_back(new StringLiteralExpression(
+                "@Lazy argument used after its call returned"));
+        ifReleased->statements->Add(new ThrowStatement(ex));
+        addTo->Add(ifReleased);
+    };
+
+    // get()
+    Method* get = new Method;
+        get->comment = "/** Returns the argument, unmarshalling it the "
+                       "first time. */";
+        get->modifiers = PUBLIC | SYNCHRONIZED;
+        get->returnType = valueType;
+        get->name = "get";
+        get->statements = new StatementBlock;
+    checkNotReleased(get->statements);
+    IfStatement* pending = new IfStatement();
+        pending->expression = new Comparison(source, "!=", NULL_VALUE);
+    Variable* position = new Variable(intType, "_position");
+    pending->statements->Add(new VariableDeclaration(position,
+            new MethodCall(source, "dataPosition")));
+    pending->statements->Add(new MethodCall(source, "setDataPosition", 1,
+            offset));
+    pending->statements->Add(new Assignment(value,
+            new MethodCall(creator, "createFromParcel", 1, source)));
+    pending->statements->Add(new MethodCall(source, "setDataPosition", 1,
+            position));
+    pending->statements->Add(new Assignment(source, NULL_VALUE));
+    get->statements->Add(pending);
+    get->statements->Add(new ReturnStatement(value));
+    lazy->elements.push_back(get);
+
+    // writeTo(), which copies the argument if it is still marshalled
+    Variable* dest = new Variable(parcelType, "dest");
+    Method* writeTo = new Method;
+        writeTo->comment = "/** Writes the argument the way a parcelable "
+                           "argument is marshalled, without unmarshalling "
+                           "it. */";
+        writeTo->modifiers = PUBLIC | SYNCHRONIZED;
+        writeTo->returnType = voidType;
+        writeTo->name = "writeTo";
+        writeTo->parameters.push_back(dest);
+        writeTo->statements = new StatementBlock;
+    checkNotReleased(writeTo->statements);
+    IfStatement* copy = new IfStatement();
+        copy->expression = new Comparison(source, "!=", NULL_VALUE);
+    copy->statements->Add(new MethodCall(dest, "writeInt", 1,
+            new LiteralExpression("1")));
+    copy->statements->Add(new MethodCall(dest, "appendFrom", 3, source,
+            offset, length));
+    IfStatement* write = new IfStatement();
+        write->expression = new Comparison(value, "!=", NULL_VALUE);
+    write->statements->Add(new MethodCall(dest, "writeInt", 1,
+            new LiteralExpression("1")));
+    write->statements->Add(new MethodCall(new Cast(parcelableType, value),
+            "writeToParcel", 2, dest, new LiteralExpression("0")));
+    IfStatement* writeNull = new IfStatement();
+    writeNull->statements->Add(new MethodCall(dest, "writeInt", 1,
+            new LiteralExpression("0")));
+    write->elseif = writeNull;
+    copy->elseif = write;
+    writeTo->statements->Add(copy);
+    lazy->elements.push_back(writeTo);
+
+    // release(), called by the stub when the call returns
+    Method* release = new Method;
+        release->modifiers = SYNCHRONIZED;
+        release->returnType = voidType;
+        release->name = "release";
+        release->statements = new StatementBlock;
+    IfStatement* unused = new IfStatement();
+        unused->expression = new Comparison(source, "!=", NULL_VALUE);
+    unused->statements->Add(new Assignment(source, NULL_VALUE));
+    unused->statements->Add(new Assignment(released, TRUE_VALUE));
+    release->statements->Add(unused);
+    lazy->elements.push_back(release);
+
+    // write(), called by the proxy
+    Variable* parcel = new Variable(parcelType, "parcel");
+    Variable* parcelable = new Variable(parcelableType, "value");
+    Method* writeLazy = new Method;
+        writeLazy->modifiers = STATIC;
+        writeLazy->returnType = voidType;
+        writeLazy->name = "write";
+        writeLazy->parameters.push_back(parcel);
+        writeLazy->parameters.push_back(parcelable);
+        writeLazy->statements = new StatementBlock;
+    IfStatement* ifValue = new IfStatement();
+        ifValue->expression = new Comparison(parcelable, "!=", NULL_VALUE);
+    ifValue->statements->Add(new MethodCall(parcel, "writeInt", 1,
+            new LiteralExpression("1")));
+    Variable* lengthAt = new Variable(intType, "_lengthAt");
+    ifValue->statements->Add(new VariableDeclaration(lengthAt,
+            new MethodCall(parcel, "dataPosition")));
+    ifValue->statements->Add(new MethodCall(parcel, "writeInt", 1,
+            new LiteralExpression("0")));
+    ifValue->statements->Add(new MethodCall(parcelable, "writeToParcel", 2,
+            parcel, new LiteralExpression("0")));
+    Variable* end = new Variable(intType, "_end");
+    ifValue->statements->Add(new VariableDeclaration(end,
+            new MethodCall(parcel, "dataPosition")));
+    ifValue->statements->Add(new MethodCall(parcel, "setDataPosition", 1,
+            lengthAt));
+    ifValue->statements->Add(new MethodCall(parcel, "writeInt", 1,
+            new Comparison(new Comparison(end, "-", lengthAt), "-",
+                new LiteralExpression("4"))));
+    ifValue->statements->Add(new MethodCall(parcel, "setDataPosition", 1,
+            end));
+    IfStatement* ifNull = new IfStatement();
+    ifNull->statements->Add(new MethodCall(parcel, "writeInt", 1,
+            new LiteralExpression("0")));
+    ifValue->elseif = ifNull;
+    writeLazy->statements->Add(ifValue);
+    lazy->elements.push_back(writeLazy);
+
+    stub->elements.push_back(lazy);
+}
 
-    interface->elements.push_back(decl);
+static string
+transaction_helper_name(const ResolvedMethod<Type>& method)
+{
+    return "onTransact$" + method.GetName() + "$";
+}
 
-    // == the stub method ====================================================
+// The stub's onTransact() only dispatches each transaction to a helper like
+// this one, which does the work.  Keeping onTransact() small keeps it, and
+// each helper, under the size limits for compiling and inlining methods.
+// Sets |declaredClassLoader| if the helper declares a class loader for
+// unmarshalling collections.
+static Method*
+generate_transaction_helper(const ResolvedMethod<Type>& method, bool oneway,
+                            bool instrument, StubClass* stubClass,
+                            JavaTypeNamespace* types,
+                            bool* declaredClassLoader)
+{
+    int i;
 
-    Case* c = new Case(transactCodeName);
+    Method* helper = new Method;
+        helper->modifiers = PRIVATE;
+        helper->returnType = types->BoolType();
+        helper->name = transaction_helper_name(method);
+        helper->parameters.push_back(stubClass->transact_data);
+        helper->parameters.push_back(stubClass->transact_reply);
+        helper->statements = new StatementBlock;
+        helper->exceptions.push_back(types->RemoteExceptionType());
+
+    Variable* start = NULL;
+    if (instrument) {
+        start = generate_start_time(helper->statements, types);
+    }
 
     MethodCall* realCall = new MethodCall(THIS_VALUE, method.GetName());
 
     // interface token validation is the very first thing we do
-    c->statements->Add(new MethodCall(stubClass->transact_data,
-            "enforceInterface", 1, new LiteralExpression("DESCRIPTOR")));
+    generate_enforce_interface(helper->statements, stubClass);
 
     // args
     Variable* cl = NULL;
     VariableFactory stubArgs("_arg");
-    for (const std::unique_ptr<AidlArgument>& arg : method.GetArguments()) {
-        const Type* t = types->Find(arg->GetType().GetName());
+    vector<Variable*> lazyArgs;
+    for (const ResolvedArgument<Type>& arg : method.arguments) {
+        const Type* t = arg.type.type;
+        if (arg.lazy) {
+            const Type* lazyType = lazy_parcelable_type(t, types);
+            Variable* v = stubArgs.Get(lazyType);
+            NewExpression* wrap = new NewExpression(lazyType);
+            wrap->arguments.push_back(
+                    new LiteralExpression(t->QualifiedName() + ".CREATOR"));
+            wrap->arguments.push_back(stubClass->transact_data);
+            helper->statements->Add(new VariableDeclaration(v, wrap));
+            realCall->arguments.push_back(v);
+            lazyArgs.push_back(v);
+            continue;
+        }
         Variable* v = stubArgs.Get(t);
-        v->dimension = arg->GetType().IsArray() ? 1 : 0;
+        v->dimension = arg.type.is_array ? 1 : 0;
 
-        c->statements->Add(new VariableDeclaration(v));
+        helper->statements->Add(new VariableDeclaration(v));
 
-        if (arg->GetDirection() & AidlArgument::IN_DIR) {
-            generate_create_from_parcel(t, c->statements, v,
+        if (arg.IsIn()) {
+            generate_create_from_parcel(t, helper->statements, v,
                     stubClass->transact_data, &cl);
         } else {
-            if (!arg->GetType().IsArray()) {
-                c->statements->Add(new Assignment(v, new NewExpression(v->type)));
+            if (!arg.type.is_array) {
+                helper->statements->Add(new Assignment(v, new NewExpression(v->type)));
             } else {
-                generate_new_array(v->type, c->statements, v,
+                generate_new_array(v->type, helper->statements, v,
                         stubClass->transact_data, types);
             }
         }
 
         realCall->arguments.push_back(v);
     }
+    *declaredClassLoader = (cl != NULL);
 
-    // the real call
+    // The real call.  @Lazy arguments are only usable during the call,
+    // while |data| still holds them.
     Variable* _result = NULL;
-    if (method.GetType().GetName() == "void") {
-        c->statements->Add(realCall);
+    StatementBlock* callBlock = helper->statements;
+    if (!lazyArgs.empty()) {
+        TryStatement* tryStatement = new TryStatement();
+        FinallyStatement* finallyStatement = new FinallyStatement();
+        for (Variable* v : lazyArgs) {
+            finallyStatement->statements->Add(new MethodCall(v, "release"));
+        }
+        if (!method.returns_void) {
+            _result = new Variable(method.return_type.type, "_result",
+                                    method.return_type.is_array ? 1 : 0);
+            helper->statements->Add(new VariableDeclaration(_result));
+        }
+        helper->statements->Add(tryStatement);
+        helper->statements->Add(finallyStatement);
+        callBlock = tryStatement->statements;
+    }
+    if (method.returns_void) {
+        callBlock->Add(realCall);
 
         if (!oneway) {
             // report that there were no exceptions
             MethodCall* ex = new MethodCall(stubClass->transact_reply,
                     "writeNoException", 0);
-            c->statements->Add(ex);
+            helper->statements->Add(ex);
         }
     } else {
-        _result = new Variable(decl->returnType, "_result",
-                                decl->returnTypeDimension);
-        c->statements->Add(new VariableDeclaration(_result, realCall));
+        if (_result != NULL) {
+            callBlock->Add(new Assignment(_result, realCall));
+        } else {
+            _result = new Variable(method.return_type.type, "_result",
+                                    method.return_type.is_array ? 1 : 0);
+            helper->statements->Add(new VariableDeclaration(_result, realCall));
+        }
 
         if (!oneway) {
             // report that there were no exceptions
             MethodCall* ex = new MethodCall(stubClass->transact_reply,
                     "writeNoException", 0);
-            c->statements->Add(ex);
+            helper->statements->Add(ex);
         }
 
         // marshall the return value
-        generate_write_to_parcel(decl->returnType, c->statements, _result,
-                                    stubClass->transact_reply,
+        generate_write_to_parcel(method.return_type.type, helper->statements,
+                                    _result, stubClass->transact_reply,
                                     Type::PARCELABLE_WRITE_RETURN_VALUE);
     }
 
     // out parameters
     i = 0;
-    for (const std::unique_ptr<AidlArgument>& arg : method.GetArguments()) {
-        const Type* t = types->Find(arg->GetType().GetName());
+    for (const ResolvedArgument<Type>& arg : method.arguments) {
+        const Type* t = arg.type.type;
         Variable* v = stubArgs.Get(i++);
 
-        if (arg->GetDirection() & AidlArgument::OUT_DIR) {
-            generate_write_to_parcel(t, c->statements, v,
+        if (arg.IsOut()) {
+            generate_write_to_parcel(t, helper->statements, v,
                                 stubClass->transact_reply,
                                 Type::PARCELABLE_WRITE_RETURN_VALUE);
-            hasOutParams = true;
         }
     }
 
+    if (instrument) {
+        helper->statements->Add(new MethodCall("reportTransaction", 5,
+                new LiteralExpression(transaction_code_name(method)),
+                TRUE_VALUE, start, stubClass->transact_data,
+                stubClass->transact_reply));
+    }
+
     // return true
-    c->statements->Add(new ReturnStatement(TRUE_VALUE));
-    stubClass->transact_switch->cases.push_back(c);
+    helper->statements->Add(new ReturnStatement(TRUE_VALUE));
+    return helper;
+}
+
+// The case in the stub's onTransact() that calls the helper.  If the stub
+// dispatches through a |table|, the case is for the method's slot in it.
+static Case*
+generate_stub_case(const ResolvedMethod<Type>& method, StubClass* stubClass,
+                   const DispatchTable* table)
+{
+    Case* c = new Case(table == nullptr ? transaction_code_name(method) :
+            std::to_string(table->SlotOf(TransactionCode(method.id))));
+    c->statements->Add(new ReturnStatement(new MethodCall(THIS_VALUE,
+            transaction_helper_name(method), 2, stubClass->transact_data,
+            stubClass->transact_reply)));
+    return c;
+}
+
+// The method in the proxy.  The proxy has always reused the class loader
+// its stub case declared, if any, instead of declaring its own, so it is
+// told whether |stubDeclaredClassLoader|.
+static Method*
+generate_proxy_method(const ResolvedMethod<Type>& method, bool oneway,
+                      bool instrument, ProxyClass* proxyClass,
+                      JavaTypeNamespace* types, bool stubDeclaredClassLoader)
+{
+    Variable* cl = NULL;
+    if (stubDeclaredClassLoader) {
+        cl = new Variable(types->ClassLoaderType(), "cl");
+    }
 
-    // == the proxy method ===================================================
     Method* proxy = new Method;
-        proxy->comment = method.GetComments();
+        proxy->comment = method.method->GetComments();
         proxy->modifiers = PUBLIC | OVERRIDE;
-        proxy->returnType = types->Find(method.GetType().GetName());
-        proxy->returnTypeDimension = method.GetType().IsArray() ? 1 : 0;
+        proxy->returnType = method.return_type.type;
+        proxy->returnTypeDimension = method.return_type.is_array ? 1 : 0;
         proxy->name = method.GetName();
         proxy->statements = new StatementBlock;
-        for (const std::unique_ptr<AidlArgument>& arg : method.GetArguments()) {
+        for (const ResolvedArgument<Type>& arg : method.arguments) {
             proxy->parameters.push_back(new Variable(
-                            types->Find(arg->GetType().GetName()), arg->GetName(),
-                            arg->GetType().IsArray() ? 1 : 0));
+                            arg.type.type, arg.GetName(),
+                            arg.type.is_array ? 1 : 0));
         }
         proxy->exceptions.push_back(types->RemoteExceptionType());
-    proxyClass->elements.push_back(proxy);
 
     // the parcels
     Variable* _data = new Variable(types->ParcelType(), "_data");
@@ -413,10 +823,10 @@ generate_method(const AidlMethod& method, Class* interface,
     }
 
     // the return value
-    _result = NULL;
-    if (method.GetType().GetName() != "void") {
+    Variable* _result = NULL;
+    if (!method.returns_void) {
         _result = new Variable(proxy->returnType, "_result",
-                method.GetType().IsArray() ? 1 : 0);
+                method.return_type.is_array ? 1 : 0);
         proxy->statements->Add(new VariableDeclaration(_result));
     }
 
@@ -426,16 +836,16 @@ generate_method(const AidlMethod& method, Class* interface,
     FinallyStatement* finallyStatement = new FinallyStatement();
     proxy->statements->Add(finallyStatement);
 
-    // the interface identifier token: the DESCRIPTOR constant, marshalled as a string
-    tryStatement->statements->Add(new MethodCall(_data, "writeInterfaceToken",
-            1, new LiteralExpression("DESCRIPTOR")));
+    // the interface identifier token
+    generate_write_interface_token(tryStatement->statements, _data,
+                                   proxyClass->mCompactToken);
 
     // the parameters
-    for (const std::unique_ptr<AidlArgument>& arg : method.GetArguments()) {
-        const Type* t = types->Find(arg->GetType().GetName());
-        Variable* v = new Variable(t, arg->GetName(), arg->GetType().IsArray() ? 1 : 0);
-        AidlArgument::Direction dir = arg->GetDirection();
-        if (dir == AidlArgument::OUT_DIR && arg->GetType().IsArray()) {
+    for (const ResolvedArgument<Type>& arg : method.arguments) {
+        const Type* t = arg.type.type;
+        Variable* v = new Variable(t, arg.GetName(), arg.type.is_array ? 1 : 0);
+        AidlArgument::Direction dir = arg.direction;
+        if (dir == AidlArgument::OUT_DIR && arg.type.is_array) {
             IfStatement* checklen = new IfStatement();
             checklen->expression = new Comparison(v, "==", NULL_VALUE);
             checklen->statements->Add(new MethodCall(_data, "writeInt", 1,
@@ -445,18 +855,46 @@ generate_method(const AidlMethod& method, Class* interface,
                         1, new FieldVariable(v, "length")));
             tryStatement->statements->Add(checklen);
         }
+        else if (arg.lazy) {
+            tryStatement->statements->Add(new MethodCall(
+                    new LiteralExpression("Stub.LazyParcelable"), "write", 2,
+                    _data, v));
+        }
         else if (dir & AidlArgument::IN_DIR) {
             generate_write_to_parcel(t, tryStatement->statements, v, _data, 0);
         }
     }
 
-    // the transact call
-    MethodCall* call = new MethodCall(proxyClass->mRemote, "transact", 4,
-                            new LiteralExpression("Stub." + transactCodeName),
-                            _data, _reply ? _reply : NULL_VALUE,
-                            new LiteralExpression(
-                                oneway ? "android.os.IBinder.FLAG_ONEWAY" : "0"));
-    tryStatement->statements->Add(call);
+    // the transact call, or queueing the call to be sent with the next batch
+    if (method.batched) {
+        tryStatement->statements->Add(new MethodCall(THIS_VALUE,
+                "enqueueBatchedCall", 2,
+                new LiteralExpression("Stub." + transaction_code_name(method)),
+                _data));
+    } else {
+        // calls already queued have to arrive first
+        if (proxyClass->mBatching) {
+            tryStatement->statements->Add(new MethodCall(THIS_VALUE,
+                    "flushBatch"));
+        }
+        Variable* start = NULL;
+        if (instrument) {
+            start = generate_start_time(tryStatement->statements, types);
+        }
+        MethodCall* call = new MethodCall(proxyClass->mRemote, "transact", 4,
+                                new LiteralExpression(
+                                    "Stub." + transaction_code_name(method)),
+                                _data, _reply ? _reply : NULL_VALUE,
+                                new LiteralExpression(
+                                    oneway ? "android.os.IBinder.FLAG_ONEWAY" : "0"));
+        tryStatement->statements->Add(call);
+        if (instrument) {
+            tryStatement->statements->Add(new MethodCall(
+                    new LiteralExpression("Stub"), "reportTransaction", 5,
+                    new LiteralExpression("Stub." + transaction_code_name(method)),
+                    FALSE_VALUE, start, _data, _reply ? _reply : NULL_VALUE));
+        }
+    }
 
     // throw back exceptions.
     if (_reply) {
@@ -472,10 +910,10 @@ generate_method(const AidlMethod& method, Class* interface,
         }
 
         // the out/inout parameters
-        for (const std::unique_ptr<AidlArgument>& arg : method.GetArguments()) {
-            const Type* t = types->Find(arg->GetType().GetName());
-            Variable* v = new Variable(t, arg->GetName(), arg->GetType().IsArray() ? 1 : 0);
-            if (arg->GetDirection() & AidlArgument::OUT_DIR) {
+        for (const ResolvedArgument<Type>& arg : method.arguments) {
+            const Type* t = arg.type.type;
+            Variable* v = new Variable(t, arg.GetName(), arg.type.is_array ? 1 : 0);
+            if (arg.IsOut()) {
                 generate_read_from_parcel(t, tryStatement->statements,
                                             v, _reply, &cl);
             }
@@ -488,6 +926,414 @@ generate_method(const AidlMethod& method, Class* interface,
     if (_result != NULL) {
         proxy->statements->Add(new ReturnStatement(_result));
     }
+    return proxy;
+}
+
+// The hooks that report each transaction to a listener, and a table from
+// transaction codes to method names for the listener to use.
+static void
+generate_instrumentation(const ResolvedInterface<Type>& resolved,
+                         StubClass* stub, JavaTypeNamespace* types)
+{
+    const AidlInterface* iface = resolved.interface;
+    const Type* longType = types->Find("long");
+
+    // the listener interface
+    Type* listenerType = new Type(types, iface->GetPackage(),
+            iface->GetName() + ".Stub.TransactionListener", Type::GENERATED,
+            false, false);
+    Class* listener = new Class;
+        listener->comment = "/** Receives the duration and Parcel sizes of "
+                            "each transaction. */";
+        listener->modifiers = PUBLIC | STATIC;
+        listener->what = Class::INTERFACE;
+        listener->type = listenerType;
+    Method* onTransaction = new Method;
+        onTransaction->modifiers = PUBLIC;
+        onTransaction->returnType = types->Find("void");
+        onTransaction->name = "onTransaction";
+        onTransaction->parameters.push_back(
+                new Variable(types->IntType(), "code"));
+        onTransaction->parameters.push_back(
+                new Variable(types->BoolType(), "incoming"));
+        onTransaction->parameters.push_back(
+                new Variable(longType, "durationNanos"));
+        onTransaction->parameters.push_back(
+                new Variable(types->IntType(), "requestBytes"));
+        onTransaction->parameters.push_back(
+                new Variable(types->IntType(), "replyBytes"));
+    listener->elements.push_back(onTransaction);
+    stub->elements.push_back(listener);
+
+    Variable* current = new Variable(listenerType, "sTransactionListener");
+    stub->elements.push_back(new Field(PRIVATE | STATIC | VOLATILE, current));
+
+    // setTransactionListener()
+    Variable* newListener = new Variable(listenerType, "listener");
+    Method* setListener = new Method;
+        setListener->comment = "/** Set the listener for transactions on "
+                               "this interface, or null for none. */";
+        setListener->modifiers = PUBLIC | STATIC;
+        setListener->returnType = types->Find("void");
+        setListener->name = "setTransactionListener";
+        setListener->parameters.push_back(newListener);
+        setListener->statements = new StatementBlock;
+    setListener->statements->Add(new Assignment(current, newListener));
+    stub->elements.push_back(setListener);
+
+    // reportTransaction(), called by the stub and the proxy
+    Variable* code = new Variable(types->IntType(), "code");
+    Variable* incoming = new Variable(types->BoolType(), "incoming");
+    Variable* startNanos = new Variable(longType, "startNanos");
+    Variable* data = new Variable(types->ParcelType(), "data");
+    Variable* reply = new Variable(types->ParcelType(), "reply");
+    Method* report = new Method;
+        report->modifiers = PRIVATE | STATIC;
+        report->returnType = types->Find("void");
+        report->name = "reportTransaction";
+        report->parameters.push_back(code);
+        report->parameters.push_back(incoming);
+        report->parameters.push_back(startNanos);
+        report->parameters.push_back(data);
+        report->parameters.push_back(reply);
+        report->statements = new StatementBlock;
+    Variable* l = new Variable(listenerType, "listener");
+    report->statements->Add(new VariableDeclaration(l, current));
+    IfStatement* ifListener = new IfStatement();
+        ifListener->expression = new Comparison(l, "!=", NULL_VALUE);
+    ifListener->statements->Add(new MethodCall(l, "onTransaction", 5,
+            code, incoming,
+            new Comparison(new MethodCall(
+                    new LiteralExpression("java.lang.System"), "nanoTime"),
+                "-", startNanos),
+            new MethodCall(data, "dataSize"),
+            new Ternary(new Comparison(reply, "==", NULL_VALUE),
+                new LiteralExpression("0"),
+                new MethodCall(reply, "dataSize"))));
+    report->statements->Add(ifListener);
+    stub->elements.push_back(report);
+
+    // getTransactionName()
+    Variable* nameCode = new Variable(types->IntType(), "code");
+    Method* getName = new Method;
+        getName->comment = "/** Returns the name of the method a transaction "
+                           "code calls, or null. */";
+        getName->modifiers = PUBLIC | STATIC;
+        getName->returnType = types->StringType();
+        getName->name = "getTransactionName";
+        getName->parameters.push_back(nameCode);
+        getName->statements = new StatementBlock;
+    SwitchStatement* names = new SwitchStatement(nameCode);
+    const ResolvedInterface<Type>* r = &resolved;
+    names->cases.push_back(new GeneratedCases(resolved.methods.size(),
+            [r](size_t i) {
+                const ResolvedMethod<Type>& method = r->methods[i];
+                Case* c = new Case(transaction_code_name(method));
+                c->statements->Add(new ReturnStatement(
+                        new StringLiteralExpression(method.GetName())));
+                return c;
+            }));
+    Case* unknown = new Case;
+    unknown->statements->Add(new ReturnStatement(NULL_VALUE));
+    names->cases.push_back(unknown);
+    getName->statements->Add(names);
+    stub->elements.push_back(getName);
+}
+
+// Support for @Batched methods.  The proxy queues their calls in one Parcel,
+// each call as its transaction code, its size and the Parcel it would have
+// sent, and sends the lot as BATCH_TRANSACTION once there are enough of them,
+// once they are big enough, or after a short delay.  The stub hands each call
+// to its transaction helper in turn.
+static void
+generate_batching(const ResolvedInterface<Type>& resolved, StubClass* stub,
+                  ProxyClass* proxy, JavaTypeNamespace* types)
+{
+    const AidlInterface* iface = resolved.interface;
+    const Type* voidType = types->Find("void");
+    const Type* intType = types->IntType();
+    const Type* handlerType = new Type(types, "android.os", "Handler",
+            Type::BUILT_IN, false, false);
+    const Type* handlerThreadType = new Type(types, "android.os",
+            "HandlerThread", Type::BUILT_IN, false, false);
+    const Type* runnableType = new Type(types, "java.lang", "Runnable",
+            Type::BUILT_IN, false, false);
+
+    // the transaction code and the thresholds
+    Field* batchCode = new Field(STATIC | FINAL,
+            new Variable(intType, "BATCH_TRANSACTION"));
+    batchCode->value = "android.os.IBinder.LAST_CALL_TRANSACTION";
+    stub->elements.push_back(batchCode);
+    Field* maxBytes = new Field(STATIC | FINAL,
+            new Variable(intType, "MAX_BATCH_BYTES"));
+    maxBytes->value = "8192";
+    stub->elements.push_back(maxBytes);
+    Field* maxCalls = new Field(STATIC | FINAL,
+            new Variable(intType, "MAX_BATCH_CALLS"));
+    maxCalls->value = "32";
+    stub->elements.push_back(maxCalls);
+    Field* maxDelay = new Field(STATIC | FINAL,
+            new Variable(intType, "MAX_BATCH_DELAY_MILLIS"));
+    maxDelay->value = "20";
+    stub->elements.push_back(maxDelay);
+
+    // the stub unpacks a batch
+    Variable* data = stub->transact_data;
+    Case* c = new Case("BATCH_TRANSACTION");
+    generate_enforce_interface(c->statements, stub);
+    WhileStatement* loop = new WhileStatement();
+        loop->expression = new Comparison(new MethodCall(data, "dataAvail"),
+                ">", new LiteralExpression("0"));
+    Variable* callCode = new Variable(intType, "_code");
+    loop->statements->Add(new VariableDeclaration(callCode,
+            new MethodCall(data, "readInt")));
+    Variable* callEnd = new Variable(intType, "_end");
+    loop->statements->Add(new VariableDeclaration(callEnd,
+            new Comparison(new MethodCall(data, "readInt"), "+",
+                new MethodCall(data, "dataPosition"))));
+    SwitchStatement* dispatch = new SwitchStatement(callCode);
+    for (const ResolvedMethod<Type>& method : resolved.methods) {
+        if (method.batched) {
+            Case* batched = new Case(transaction_code_name(method));
+            batched->statements->Add(new MethodCall(THIS_VALUE,
+                    transaction_helper_name(method), 2, data,
+                    stub->transact_reply));
+            batched->statements->Add(new Break());
+            dispatch->cases.push_back(batched);
+        }
+    }
+    Case* unknown = new Case;
+    unknown->statements->Add(new ReturnStatement(FALSE_VALUE));
+    dispatch->cases.push_back(unknown);
+    loop->statements->Add(dispatch);
+    // whatever the call left unread, the next one starts at _end
+    loop->statements->Add(new MethodCall(data, "setDataPosition", 1,
+            callEnd));
+    c->statements->Add(loop);
+    c->statements->Add(new ReturnStatement(TRUE_VALUE));
+    stub->transact_switch->cases.push_back(c);
+
+    // flushBatchedCalls()
+    const Type* interfaceType = types->Find(iface->GetCanonicalName());
+    Variable* target = new Variable(interfaceType, "iface");
+    Method* flushCalls = new Method;
+        flushCalls->comment = "/** Send the calls to @Batched methods that "
+                              "|iface| has queued, if any. */";
+        flushCalls->modifiers = PUBLIC | STATIC;
+        flushCalls->returnType = voidType;
+        flushCalls->name = "flushBatchedCalls";
+        flushCalls->parameters.push_back(target);
+        flushCalls->statements = new StatementBlock;
+        flushCalls->exceptions.push_back(types->RemoteExceptionType());
+    IfStatement* isProxy = new IfStatement();
+        isProxy->expression = new Comparison(target, " instanceof ",
+                new LiteralExpression(proxy->type->QualifiedName()));
+    isProxy->statements->Add(new MethodCall(new Cast(proxy->type, target),
+            "flushBatch"));
+    flushCalls->statements->Add(isProxy);
+    stub->elements.push_back(flushCalls);
+
+    // the proxy's queue, and the thread that sends it after a delay
+    proxy->interfaces.push_back(runnableType);
+    Variable* batch = new Variable(types->ParcelType(), "mBatch");
+    proxy->elements.push_back(new Field(PRIVATE, batch));
+    Variable* batchCalls = new Variable(intType, "mBatchCalls");
+    proxy->elements.push_back(new Field(PRIVATE, batchCalls));
+    Variable* handler = new Variable(handlerType, "sBatchHandler");
+    proxy->elements.push_back(new Field(PRIVATE | STATIC, handler));
+
+    // batchHandler()
+    Method* getHandler = new Method;
+        getHandler->modifiers = PRIVATE | STATIC | SYNCHRONIZED;
+        getHandler->returnType = handlerType;
+        getHandler->name = "batchHandler";
+        getHandler->statements = new StatementBlock;
+    IfStatement* noHandler = new IfStatement();
+        noHandler->expression = new Comparison(handler, "==", NULL_VALUE);
+    Variable* thread = new Variable(handlerThreadType, "_thread");
+    NewExpression* newThread = new NewExpression(handlerThreadType);
+    newThread->arguments.push_back(new StringLiteralExpression(
+            iface->GetCanonicalName() + " batches"));
+    noHandler->statements->Add(new VariableDeclaration(thread, newThread));
+    noHandler->statements->Add(new MethodCall(thread, "start"));
+    NewExpression* newHandler = new NewExpression(handlerType);
+    newHandler->arguments.push_back(new MethodCall(thread, "getLooper"));
+    noHandler->statements->Add(new Assignment(handler, newHandler));
+    getHandler->statements->Add(noHandler);
+    getHandler->statements->Add(new ReturnStatement(handler));
+    proxy->elements.push_back(getHandler);
+
+    // enqueueBatchedCall()
+    Variable* code = new Variable(intType, "code");
+    Variable* call = new Variable(types->ParcelType(), "call");
+    Method* enqueue = new Method;
+        enqueue->modifiers = PRIVATE | SYNCHRONIZED;
+        enqueue->returnType = voidType;
+        enqueue->name = "enqueueBatchedCall";
+        enqueue->parameters.push_back(code);
+        enqueue->parameters.push_back(call);
+        enqueue->statements = new StatementBlock;
+        enqueue->exceptions.push_back(types->RemoteExceptionType());
+    IfStatement* noBatch = new IfStatement();
+        noBatch->expression = new Comparison(batch, "==", NULL_VALUE);
+    noBatch->statements->Add(new Assignment(batch,
+            new MethodCall(types->ParcelType(), "obtain")));
+    generate_write_interface_token(noBatch->statements, batch,
+                                   proxy->mCompactToken);
+    noBatch->statements->Add(new MethodCall(new MethodCall("batchHandler"),
+            "postDelayed", 2, THIS_VALUE,
+            new LiteralExpression("Stub.MAX_BATCH_DELAY_MILLIS")));
+    enqueue->statements->Add(noBatch);
+    enqueue->statements->Add(new MethodCall(batch, "writeInt", 1, code));
+    enqueue->statements->Add(new MethodCall(batch, "writeInt", 1,
+            new MethodCall(call, "dataSize")));
+    enqueue->statements->Add(new MethodCall(batch, "appendFrom", 3, call,
+            new LiteralExpression("0"), new MethodCall(call, "dataSize")));
+    enqueue->statements->Add(new Assignment(batchCalls,
+            new Comparison(batchCalls, "+", new LiteralExpression("1"))));
+    IfStatement* full = new IfStatement();
+        full->expression = new Comparison(
+                new Comparison(batchCalls, ">=",
+                    new LiteralExpression("Stub.MAX_BATCH_CALLS")),
+                "||",
+                new Comparison(new MethodCall(batch, "dataSize"), ">=",
+                    new LiteralExpression("Stub.MAX_BATCH_BYTES")));
+    full->statements->Add(new MethodCall(THIS_VALUE, "flushBatch"));
+    enqueue->statements->Add(full);
+    proxy->elements.push_back(enqueue);
+
+    // flushBatch()
+    Method* flush = new Method;
+        flush->comment = "/** Send the queued calls to @Batched methods "
+                         "now. */";
+        flush->modifiers = PUBLIC | SYNCHRONIZED;
+        flush->returnType = voidType;
+        flush->name = "flushBatch";
+        flush->statements = new StatementBlock;
+        flush->exceptions.push_back(types->RemoteExceptionType());
+    IfStatement* queued = new IfStatement();
+        queued->expression = new Comparison(batch, "!=", NULL_VALUE);
+    Variable* sending = new Variable(types->ParcelType(), "_batch");
+    queued->statements->Add(new VariableDeclaration(sending, batch));
+    queued->statements->Add(new Assignment(batch, NULL_VALUE));
+    queued->statements->Add(new Assignment(batchCalls,
+            new LiteralExpression("0")));
+    queued->statements->Add(new MethodCall(new MethodCall("batchHandler"),
+            "removeCallbacks", 1, THIS_VALUE));
+    TryStatement* tryStatement = new TryStatement();
+    tryStatement->statements->Add(new MethodCall(proxy->mRemote, "transact",
+            4, new LiteralExpression("Stub.BATCH_TRANSACTION"), sending,
+            NULL_VALUE, new LiteralExpression("android.os.IBinder.FLAG_ONEWAY")));
+    queued->statements->Add(tryStatement);
+    FinallyStatement* finallyStatement = new FinallyStatement();
+    finallyStatement->statements->Add(new MethodCall(sending, "recycle"));
+    queued->statements->Add(finallyStatement);
+    flush->statements->Add(queued);
+    proxy->elements.push_back(flush);
+
+    // run(), for the delayed flush
+    Method* run = new Method;
+        run->modifiers = PUBLIC | OVERRIDE;
+        run->returnType = voidType;
+        run->name = "run";
+        run->statements = new StatementBlock;
+    TryStatement* tryFlush = new TryStatement();
+    tryFlush->statements->Add(new MethodCall(THIS_VALUE, "flushBatch"));
+    run->statements->Add(tryFlush);
+    run->statements->Add(new CatchStatement(
+            new Variable(types->RemoteExceptionType(), "e")));
+    proxy->elements.push_back(run);
+}
+
+// DESCRIPTOR_HASH, and the check the stub makes in place of
+// enforceInterface().  The hash is a 64-bit FNV-1a of the descriptor,
+// which C++ clients and servers send and check too.
+static void
+generate_compact_token(const AidlInterface* iface, StubClass* stub,
+                       JavaTypeNamespace* types)
+{
+    char hash[32];
+    snprintf(hash, sizeof(hash), "0x%016" PRIx64 "L",
+             iface->GetDescriptorHash());
+    Field* descriptorHash = new Field(STATIC | FINAL | PRIVATE,
+            new Variable(types->Find("long"), "DESCRIPTOR_HASH"));
+    descriptorHash->value = hash;
+    // right after DESCRIPTOR
+    stub->elements.insert(stub->elements.begin() + 1, descriptorHash);
+
+    Variable* data = new Variable(types->ParcelType(), "data");
+    Method* enforce = new Method;
+        enforce->modifiers = PRIVATE | STATIC;
+        enforce->returnType = types->Find("void");
+        enforce->name = "enforceDescriptorHash";
+        enforce->parameters.push_back(data);
+        enforce->statements = new StatementBlock;
+    IfStatement* mismatch = new IfStatement();
+        mismatch->expression = new Comparison(new MethodCall(data, "readLong"),
+                "!=", new LiteralExpression("DESCRIPTOR_HASH"));
+    NewExpression* ex = new NewExpression(new Type(types,
+            "java.lang.SecurityException", Type::BUILT_IN, false, false));
+    ex->arguments.push_back(new StringLiteralExpression(
+            "Binder invocation to an incorrect interface"));
+    mismatch->statements->Add(new ThrowStatement(ex));
+    enforce->statements->Add(mismatch);
+    stub->elements.push_back(enforce);
+}
+
+static string
+int_array_literal(const vector<uint32_t>& values)
+{
+    string literal = "{";
+    for (size_t i = 0; i < values.size(); i++) {
+        literal += (i == 0 ? "" : ", ") + std::to_string(values[i]);
+    }
+    return literal + "}";
+}
+
+// The tables of a stub whose transaction codes are too sparse for javac to
+// compile a switch on them into a tableswitch, and the start of its
+// onTransact(), which looks the code up in them.  Returns the switch on the
+// code's slot, for the methods' cases.
+static SwitchStatement*
+generate_dispatch_table(const DispatchTable& table, StubClass* stub,
+                        JavaTypeNamespace* types)
+{
+    Field* displacements = new Field(STATIC | FINAL | PRIVATE,
+            new Variable(types->IntType(), "DISPATCH_DISPLACEMENTS", 1));
+    displacements->value = int_array_literal(table.displacements);
+    Field* codes = new Field(STATIC | FINAL | PRIVATE,
+            new Variable(types->IntType(), "DISPATCH_CODES", 1));
+    codes->value = int_array_literal(table.codes);
+    // right after DESCRIPTOR, and DESCRIPTOR_HASH if there is one
+    auto after = stub->elements.begin() + (stub->compact_token ? 2 : 1);
+    stub->elements.insert(after, {displacements, codes});
+
+    // int _key = (code&0x7fffffff);
+    // int _slot = (((_key%M)+DISPATCH_DISPLACEMENTS[(_key%D)])%M);
+    // if ((DISPATCH_CODES[_slot]==code)) {
+    //   switch (_slot) { ... }
+    // }
+    Variable* key = new Variable(types->IntType(), "_key");
+    Variable* slot = new Variable(types->IntType(), "_slot");
+    const string modulus = std::to_string(table.modulus);
+    IfStatement* known = new IfStatement();
+        known->expression = new Comparison(
+                new LiteralExpression("DISPATCH_CODES[_slot]"), "==",
+                stub->transact_code);
+    SwitchStatement* slotSwitch = new SwitchStatement(slot);
+    known->statements->Add(slotSwitch);
+
+    vector<Statement*>& statements = stub->transact_statements->statements;
+    statements.insert(statements.begin(), {
+        new VariableDeclaration(key, new Comparison(stub->transact_code, "&",
+                new LiteralExpression("0x7fffffff"))),
+        new VariableDeclaration(slot, new LiteralExpression(
+                "(((_key%" + modulus + ")+DISPATCH_DISPLACEMENTS[(_key%" +
+                std::to_string(table.displacements.size()) + ")])%" +
+                modulus + ")")),
+        known,
+    });
+    return slotSwitch;
 }
 
 static void
@@ -513,9 +1359,11 @@ generate_interface_descriptors(StubClass* stub, ProxyClass* proxy,
 }
 
 Class*
-generate_binder_interface_class(const AidlInterface* iface,
-                                JavaTypeNamespace* types)
+generate_binder_interface_class(const ResolvedInterface<Type>& resolved,
+                                JavaTypeNamespace* types, bool instrument)
 {
+    const AidlInterface* iface = resolved.interface;
+
     const InterfaceType* interfaceType = static_cast<const InterfaceType*>(
         types->Find(iface->GetCanonicalName()));
 
@@ -533,22 +1381,116 @@ generate_binder_interface_class(const AidlInterface* iface,
         interfaceType, types);
     interface->elements.push_back(stub);
 
-    // the proxy inner class
+    // the proxy inner class, added to the stub after the transaction
+    // helpers
     ProxyClass* proxy = new ProxyClass(
         types,
         types->Find(iface->GetCanonicalName() + ".Stub.Proxy"),
         interfaceType);
-    stub->elements.push_back(proxy);
 
     // stub and proxy support for getInterfaceDescriptor()
     generate_interface_descriptors(stub, proxy, types);
 
-    // all the declared methods of the interface
-    int index = 0;
-    for (const auto& item : iface->GetMethods()) {
-        generate_method(*item, interface, stub, proxy,
-                        item->GetId(), types);
-        index++;
+    for (const ResolvedMethod<Type>& method : resolved.methods) {
+        proxy->mBatching |= method.batched;
+    }
+
+    if (iface->HasCompactToken()) {
+        stub->compact_token = true;
+        proxy->mCompactToken = true;
+        generate_compact_token(iface, stub, types);
+    }
+
+    // All the declared methods of the interface.  Each method's stub case,
+    // transaction helper, proxy method, transaction code and declaration
+    // are only built while the class is written, and freed right after, so
+    // the whole interface is never in memory at once.  The transaction
+    // helpers are written before the proxy methods, and record which of
+    // them declared a class loader.  Only writing generates them, so each
+    // is generated exactly once.
+    const ResolvedInterface<Type>* r = &resolved;
+    const size_t count = resolved.methods.size();
+    const bool interfaceOneway = proxy->mOneWay;
+    std::shared_ptr<vector<bool>> stubClassLoaders =
+        std::make_shared<vector<bool>>(count);
+
+    // Sparse transaction codes are first mapped to dense slots.
+    std::shared_ptr<DispatchTable> table = std::make_shared<DispatchTable>();
+    SwitchStatement* methodSwitch = stub->transact_switch;
+    if (BuildDispatchTable(resolved, table.get())) {
+        methodSwitch = generate_dispatch_table(*table, stub, types);
+    } else {
+        table.reset();
+    }
+    methodSwitch->cases.push_back(new GeneratedCases(count,
+            [r, stub, table](size_t i) {
+                return generate_stub_case(r->methods[i], stub, table.get());
+            }));
+    const vector<const Type*> signatureTypes =
+            method_signature_types(resolved, types);
+    GeneratedElements* helpers = new GeneratedElements(count,
+            [r, interfaceOneway, instrument, stub, types,
+             stubClassLoaders](size_t i) {
+                const ResolvedMethod<Type>& method = r->methods[i];
+                bool declaredClassLoader = false;
+                Method* helper = generate_transaction_helper(method,
+                        interfaceOneway || method.oneway, instrument, stub,
+                        types, &declaredClassLoader);
+                (*stubClassLoaders)[i] = declaredClassLoader;
+                return helper;
+            });
+    helpers->signatureTypes = {types->BoolType(), types->ParcelType(),
+                               types->RemoteExceptionType()};
+    stub->elements.push_back(helpers);
+    stub->elements.push_back(proxy);
+    GeneratedElements* proxyMethods = new GeneratedElements(count,
+            [r, interfaceOneway, instrument, proxy, types,
+             stubClassLoaders](size_t i) {
+                const ResolvedMethod<Type>& method = r->methods[i];
+                return generate_proxy_method(method,
+                        interfaceOneway || method.oneway, instrument, proxy,
+                        types, (*stubClassLoaders)[i]);
+            });
+    proxyMethods->signatureTypes = signatureTypes;
+    proxy->elements.push_back(proxyMethods);
+    GeneratedElements* transactionCodes = new GeneratedElements(count,
+            [r, types](size_t i) {
+                return generate_transaction_code(r->methods[i], types);
+            });
+    transactionCodes->signatureTypes = {types->IntType()};
+    stub->elements.push_back(transactionCodes);
+    GeneratedElements* declarations = new GeneratedElements(count,
+            [r, types](size_t i) {
+                return generate_interface_method(r->methods[i], types);
+            });
+    declarations->signatureTypes = signatureTypes;
+    interface->elements.push_back(declarations);
+
+    if (instrument) {
+        generate_instrumentation(resolved, stub, types);
+    }
+
+    if (proxy->mBatching) {
+        generate_batching(resolved, stub, proxy, types);
+    }
+
+    // the stub's methods taking @Lazy arguments
+    vector<size_t> lazyMethods;
+    for (size_t i = 0; i < count; i++) {
+        if (has_lazy_arguments(resolved.methods[i])) {
+            lazyMethods.push_back(i);
+        }
+    }
+    if (!lazyMethods.empty()) {
+        generate_lazy_parcelable(stub, types);
+        GeneratedElements* lazyStubMethods = new GeneratedElements(
+                lazyMethods.size(),
+                [r, types, lazyMethods](size_t i) {
+                    return generate_lazy_stub_method(
+                            r->methods[lazyMethods[i]], types);
+                });
+        lazyStubMethods->signatureTypes = signatureTypes;
+        stub->elements.push_back(lazyStubMethods);
     }
 
     return interface;
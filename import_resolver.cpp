@@ -23,6 +23,7 @@
 #endif
 
 #include "os.h"
+#include "stats.h"
 
 using std::string;
 using std::vector;
@@ -58,6 +59,7 @@ string ImportResolver::FindImportFile(const string& canonical_name) const {
   // Look for that relative path at each of our import roots.
   for (string path : import_paths_) {
     path = path + relative_path;
+    stats::Increment(stats::FILE_PROBES);
     if (io_delegate_.FileIsReadable(path)) {
       return path;
     }
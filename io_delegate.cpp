@@ -17,6 +17,15 @@
 #include "io_delegate.h"
 
 #include <fstream>
+#include <iostream>
+
+#include <sys/stat.h>
+
+#ifdef _WIN32
+#include <direct.h>
+#endif
+
+#include "os.h"
 
 using std::string;
 using std::unique_ptr;
@@ -55,5 +64,31 @@ bool IoDelegate::FileIsReadable(const string& path) const {
   return (0 == access(path.c_str(), R_OK));
 #endif
 }
+
+CodeWriterPtr IoDelegate::GetCodeWriter(const string& file_path) const {
+  return GetFileWriter(file_path);
+}
+
+void IoDelegate::CreatePathForFile(const string& file_path) const {
+  for (size_t i = 0; i < file_path.length(); ++i) {
+    if (file_path[i] != OS_PATH_SEPARATOR) {
+      continue;
+    }
+    const string dir = file_path.substr(0, i);
+    if (dir.empty() || access(dir.c_str(), F_OK) == 0) {
+      continue;
+    }
+#ifdef _WIN32
+    _mkdir(dir.c_str());
+#else
+    mkdir(dir.c_str(), S_IRUSR|S_IWUSR|S_IXUSR|S_IRGRP|S_IXGRP);
+#endif
+  }
+}
+
+void IoDelegate::ReportDiagnostics(const string& diagnostics) const {
+  std::cerr << diagnostics;
+}
+
 }  // namespace android
 }  // namespace aidl
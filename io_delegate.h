@@ -22,6 +22,8 @@
 #include <memory>
 #include <string>
 
+#include "code_writer.h"
+
 namespace android {
 namespace aidl {
 
@@ -38,6 +40,17 @@ class IoDelegate {
 
   virtual bool FileIsReadable(const std::string& path) const;
 
+  // Returns a CodeWriter that writes to |file_path|, or nullptr if the
+  // file could not be opened.
+  virtual CodeWriterPtr GetCodeWriter(const std::string& file_path) const;
+
+  // Creates the directories leading up to |file_path|, as needed.
+  virtual void CreatePathForFile(const std::string& file_path) const;
+
+  // Prints |diagnostics| collected while parsing a file, e.g. on another
+  // thread, to stderr.
+  virtual void ReportDiagnostics(const std::string& diagnostics) const;
+
  private:
   DISALLOW_COPY_AND_ASSIGN(IoDelegate);
 };  // class IoDelegate
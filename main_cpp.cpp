@@ -20,6 +20,8 @@
 #include "io_delegate.h"
 #include "logging.h"
 #include "options.h"
+#include "stats.h"
+#include "trace.h"
 
 using android::aidl::CppOptions;
 
@@ -33,5 +35,22 @@ int main(int argc, char** argv) {
   }
 
   android::aidl::IoDelegate io_delegate;
-  return android::aidl::compile_aidl_to_cpp(*options, io_delegate);
+  const std::string trace_file = options->TraceFilePath();
+  if (!trace_file.empty()) {
+    android::aidl::trace::Enable();
+  }
+  const std::string stats_file = options->StatsFilePath();
+  if (!stats_file.empty()) {
+    android::aidl::stats::Enable();
+  }
+  int ret = android::aidl::compile_aidl_to_cpp(*options, io_delegate);
+  if (!trace_file.empty() &&
+      !android::aidl::trace::WriteTrace(trace_file, io_delegate)) {
+    ret = 1;
+  }
+  if (!stats_file.empty() &&
+      !android::aidl::stats::WriteStats(stats_file, io_delegate)) {
+    ret = 1;
+  }
+  return ret;
 }
@@ -21,9 +21,34 @@
 #include "io_delegate.h"
 #include "logging.h"
 #include "options.h"
+#include "stats.h"
+#include "trace.h"
 
+using android::aidl::IoDelegate;
 using android::aidl::JavaOptions;
 
+namespace {
+
+int process_command(const JavaOptions& options, const IoDelegate& io_delegate) {
+  switch (options.task) {
+    case JavaOptions::COMPILE_AIDL_TO_JAVA:
+      return android::aidl::compile_aidl_to_java(options, io_delegate);
+    case JavaOptions::COMPILE_AIDL_TO_JAVA_AND_CPP:
+      return android::aidl::compile_aidl_to_java_and_cpp(options, io_delegate);
+    case JavaOptions::PREPROCESS_AIDL:
+      return android::aidl::preprocess_aidl(options, io_delegate);
+    case JavaOptions::WRITE_DEP_GRAPH:
+      return android::aidl::write_dep_graph(options, io_delegate);
+    case JavaOptions::QUERY_DEP_GRAPH_IMPORTS:
+    case JavaOptions::QUERY_DEP_GRAPH_USERS:
+      return android::aidl::query_dep_graph(options, io_delegate);
+  }
+  std::cerr << "aidl: internal error" << std::endl;
+  return 1;
+}
+
+}  // namespace
+
 int main(int argc, char** argv) {
   android::base::InitLogging(argv);
   LOG(DEBUG) << "aidl starting";
@@ -33,12 +58,22 @@ int main(int argc, char** argv) {
   }
 
   android::aidl::IoDelegate io_delegate;
-  switch (options->task) {
-    case JavaOptions::COMPILE_AIDL_TO_JAVA:
-      return android::aidl::compile_aidl_to_java(*options, io_delegate);
-    case JavaOptions::PREPROCESS_AIDL:
-      return android::aidl::preprocess_aidl(*options, io_delegate);
+  if (!options->trace_file_name_.empty()) {
+    android::aidl::trace::Enable();
   }
-  std::cerr << "aidl: internal error" << std::endl;
-  return 1;
+  if (!options->stats_file_name_.empty()) {
+    android::aidl::stats::Enable();
+  }
+  int ret = process_command(*options, io_delegate);
+  if (!options->trace_file_name_.empty() &&
+      !android::aidl::trace::WriteTrace(options->trace_file_name_,
+                                        io_delegate)) {
+    ret = 1;
+  }
+  if (!options->stats_file_name_.empty() &&
+      !android::aidl::stats::WriteStats(options->stats_file_name_,
+                                        io_delegate)) {
+    ret = 1;
+  }
+  return ret;
 }
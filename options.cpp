@@ -36,6 +36,9 @@ unique_ptr<JavaOptions> java_usage() {
   fprintf(stderr,
           "usage: aidl OPTIONS INPUT [OUTPUT]\n"
           "       aidl --preprocess OUTPUT INPUT...\n"
+          "       aidl --dep-graph OUTPUT INPUT...\n"
+          "       aidl --dep-graph-imports GRAPH CLASS_OR_FILE\n"
+          "       aidl --dep-graph-users GRAPH CLASS_OR_FILE\n"
           "\n"
           "OPTIONS:\n"
           "   -I<DIR>    search path for import statements.\n"
@@ -45,6 +48,15 @@ unique_ptr<JavaOptions> java_usage() {
           "   -p<FILE>   file created by --preprocess to import.\n"
           "   -o<FOLDER> base output folder for generated files.\n"
           "   -b         fail when trying to compile a parcelable.\n"
+          "   --cpp-out <FOLDER>  also generate C++ into FOLDER, parsing and "
+          "validating the input only once.\n"
+          "   --trace <FILE>  write a Chrome trace-event file of the "
+          "compile.\n"
+          "   --stats <FILE>  write a JSON report of compiler statistics.\n"
+          "   --size-report <FILE>  write static bounds on the bytes each "
+          "method sends and receives.\n"
+          "   --instrument-transactions  generate hooks reporting the "
+          "duration and Parcel sizes of each transaction.\n"
           "\n"
           "INPUT:\n"
           "   An aidl interface file.\n"
@@ -54,7 +66,13 @@ unique_ptr<JavaOptions> java_usage() {
           "   If omitted and the -o option is not used, the input filename is "
           "used, with the .aidl extension changed to a .java extension.\n"
           "   If the -o option is used, the generated files will be placed in "
-          "the base output folder, under their package folder\n");
+          "the base output folder, under their package folder\n"
+          "\n"
+          "DEPENDENCY GRAPH:\n"
+          "   --dep-graph indexes the imports of each INPUT into OUTPUT.\n"
+          "   --dep-graph-imports prints the classes imported by a file.\n"
+          "   --dep-graph-users prints the indexed files that transitively "
+          "import a file.\n");
   return unique_ptr<JavaOptions>(nullptr);
 }
 
@@ -76,6 +94,30 @@ unique_ptr<JavaOptions> JavaOptions::Parse(int argc, const char* const* argv) {
     return options;
   }
 
+  if (argc >= 2 && 0 == strcmp(argv[1], "--dep-graph")) {
+    if (argc < 4) {
+      return java_usage();
+    }
+    options->output_file_name_ = argv[2];
+    for (int i = 3; i < argc; i++) {
+      options->files_to_index_.push_back(argv[i]);
+    }
+    options->task = WRITE_DEP_GRAPH;
+    return options;
+  }
+
+  if (argc >= 2 && (0 == strcmp(argv[1], "--dep-graph-imports") ||
+                    0 == strcmp(argv[1], "--dep-graph-users"))) {
+    if (argc != 4) {
+      return java_usage();
+    }
+    options->input_file_name_ = argv[2];
+    options->dep_graph_query_ = argv[3];
+    options->task = (0 == strcmp(argv[1], "--dep-graph-imports"))
+        ? QUERY_DEP_GRAPH_IMPORTS : QUERY_DEP_GRAPH_USERS;
+    return options;
+  }
+
   options->task = COMPILE_AIDL_TO_JAVA;
   // OPTIONS
   while (i < argc) {
@@ -121,6 +163,37 @@ unique_ptr<JavaOptions> JavaOptions::Parse(int argc, const char* const* argv) {
       }
     } else if (strcmp(s, "-b") == 0) {
       options->fail_on_parcelable_ = true;
+    } else if (strcmp(s, "--cpp-out") == 0) {
+      if (i + 1 < argc) {
+        options->cpp_output_folder_ = argv[++i];
+        options->task = COMPILE_AIDL_TO_JAVA_AND_CPP;
+      } else {
+        fprintf(stderr, "--cpp-out option (%d) requires a path.\n", i);
+        return java_usage();
+      }
+    } else if (strcmp(s, "--trace") == 0) {
+      if (i + 1 < argc) {
+        options->trace_file_name_ = argv[++i];
+      } else {
+        fprintf(stderr, "--trace option (%d) requires a file.\n", i);
+        return java_usage();
+      }
+    } else if (strcmp(s, "--stats") == 0) {
+      if (i + 1 < argc) {
+        options->stats_file_name_ = argv[++i];
+      } else {
+        fprintf(stderr, "--stats option (%d) requires a file.\n", i);
+        return java_usage();
+      }
+    } else if (strcmp(s, "--size-report") == 0) {
+      if (i + 1 < argc) {
+        options->size_report_file_name_ = argv[++i];
+      } else {
+        fprintf(stderr, "--size-report option (%d) requires a file.\n", i);
+        return java_usage();
+      }
+    } else if (strcmp(s, "--instrument-transactions") == 0) {
+      options->instrument_transactions_ = true;
     } else {
       // s[1] is not known
       fprintf(stderr, "unknown option (%d): %s\n", i, s);
@@ -178,6 +251,10 @@ unique_ptr<CppOptions> cpp_usage() {
        << "OPTIONS:" << endl
        << "   -I<DIR>   search path for import statements" << endl
        << "   -d<FILE>  generate dependency file" << endl
+       << "   --trace <FILE>  write a Chrome trace-event file of the compile"
+       << endl
+       << "   --stats <FILE>  write a JSON report of compiler statistics"
+       << endl
        << endl
        << "INPUT_FILE:" << endl
        << "   an aidl interface file" << endl
@@ -203,6 +280,22 @@ unique_ptr<CppOptions> CppOptions::Parse(int argc, const char* const* argv) {
       cerr << "Invalid argument '" << s << "'." << endl;
       return cpp_usage();
     }
+    if (strcmp(s, "--trace") == 0) {
+      if (i + 1 >= argc) {
+        cerr << "--trace requires a file." << endl;
+        return cpp_usage();
+      }
+      options->trace_file_name_ = argv[++i];
+      continue;
+    }
+    if (strcmp(s, "--stats") == 0) {
+      if (i + 1 >= argc) {
+        cerr << "--stats requires a file." << endl;
+        return cpp_usage();
+      }
+      options->stats_file_name_ = argv[++i];
+      continue;
+    }
     const string the_rest = s + 2;
     if (s[1] == 'I') {
       options->import_paths_.push_back(the_rest);
@@ -220,37 +313,68 @@ unique_ptr<CppOptions> CppOptions::Parse(int argc, const char* const* argv) {
     cerr << "Expected 2 positional arguments but got " << remaining_args << "." << endl;
     return cpp_usage();
   }
-  options->input_file_name_ = argv[i];
-  if (!EndsWith(options->input_file_name_, ".aidl")) {
-    cerr << "Expected .aidl file for input but got "
-         << options->input_file_name_ << endl;
+  if (!options->SetInputFileName(argv[i])) {
     return cpp_usage();
   }
 
   options->output_base_folder_ = argv[i + 1];
 
+  return options;
+}
+
+unique_ptr<CppOptions> CppOptions::ForJava(const JavaOptions& java_options) {
+  unique_ptr<CppOptions> options(new CppOptions());
+  if (!options->SetInputFileName(java_options.input_file_name_)) {
+    return nullptr;
+  }
+  options->import_paths_ = java_options.import_paths_;
+  options->output_base_folder_ = java_options.cpp_output_folder_;
+  return options;
+}
+
+bool CppOptions::SetInputFileName(const string& input_file_name) {
+  input_file_name_ = input_file_name;
+  if (!EndsWith(input_file_name_, ".aidl")) {
+    cerr << "Expected .aidl file for input but got "
+         << input_file_name_ << endl;
+    return false;
+  }
+
   // C++ generation drops 6 files with very similar names based on the name
   // of the input .aidl file.  If this file is called foo/Bar.aidl, extract
   // the substring "Bar" and store it in output_base_name_.
-  string base_name = options->input_file_name_;
+  string base_name = input_file_name_;
   if (!ReplaceSuffix(".aidl", "", &base_name)) {
     LOG(FATAL) << "Internal aidl error.";
-    return cpp_usage();
+    return false;
   }
   auto pos =  base_name.rfind(OS_PATH_SEPARATOR);
   if (pos != string::npos) {
     base_name = base_name.substr(pos + 1);
   }
+  output_base_name_ = OutputBaseName(base_name);
+  return true;
+}
+
+unique_ptr<CppOptions> CppOptions::ForInterface(
+    const string& interface_name) const {
+  unique_ptr<CppOptions> options(new CppOptions());
+  options->input_file_name_ = input_file_name_;
+  options->import_paths_ = import_paths_;
+  options->output_base_folder_ = output_base_folder_;
+  options->output_base_name_ = OutputBaseName(interface_name);
+  return options;
+}
+
+string CppOptions::OutputBaseName(const string& name) {
   // If the .aidl file is named something like ITopic.aidl, strip off
   // the 'I' so that we can generate BpTopic and BnTopic.
-  if (base_name.length() > 2 &&
-      isupper(base_name[0]) &&
-      isupper(base_name[1])) {
-    base_name = base_name.substr(1);
+  if (name.length() > 2 &&
+      isupper(name[0]) &&
+      isupper(name[1])) {
+    return name.substr(1);
   }
-  options->output_base_name_ = base_name;
-
-  return options;
+  return name;
 }
 
 string CppOptions::InputFileName() const {
@@ -261,6 +385,18 @@ vector<string> CppOptions::ImportPaths() const {
   return import_paths_;
 }
 
+string CppOptions::DependencyFilePath() const {
+  return dep_file_name_;
+}
+
+string CppOptions::TraceFilePath() const {
+  return trace_file_name_;
+}
+
+string CppOptions::StatsFilePath() const {
+  return stats_file_name_;
+}
+
 string CppOptions::ClientCppFileName() const {
   return MakeOutputName("Bp", ".cpp");
 }
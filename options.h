@@ -32,7 +32,11 @@ class JavaOptions final {
  public:
   enum {
       COMPILE_AIDL_TO_JAVA,
+      COMPILE_AIDL_TO_JAVA_AND_CPP,
       PREPROCESS_AIDL,
+      WRITE_DEP_GRAPH,
+      QUERY_DEP_GRAPH_IMPORTS,
+      QUERY_DEP_GRAPH_USERS,
   };
 
   ~JavaOptions() = default;
@@ -49,9 +53,21 @@ class JavaOptions final {
   std::string input_file_name_;
   std::string output_file_name_;
   std::string output_base_folder_;
+  // When set, C++ is generated into this folder from the same parse.
+  std::string cpp_output_folder_;
   std::string dep_file_name_;
   bool auto_dep_file_{false};
   std::vector<std::string> files_to_preprocess_;
+  std::vector<std::string> files_to_index_;
+  // The class name or file path asked about by a dependency graph query.
+  std::string dep_graph_query_;
+  std::string trace_file_name_;
+  std::string stats_file_name_;
+  // When set, bounds on the transaction sizes of the interface are written
+  // here.
+  std::string size_report_file_name_;
+  // Generate hooks that time each transaction and measure its Parcels.
+  bool instrument_transactions_{false};
 
   // TODO: Mock file IO and remove this (b/24816077)
   std::string output_file_name_for_deps_test_;
@@ -60,6 +76,8 @@ class JavaOptions final {
   JavaOptions() = default;
 
   FRIEND_TEST(EndToEndTest, IExampleInterface);
+  FRIEND_TEST(EndToEndTest, IPrimitiveLists);
+  FRIEND_TEST(EndToEndTest, IClassLoaders);
   DISALLOW_COPY_AND_ASSIGN(JavaOptions);
 };
 
@@ -73,6 +91,16 @@ class CppOptions final {
   // Prints the usage statement on failure.
   static std::unique_ptr<CppOptions> Parse(int argc, const char* const* argv);
 
+  // Returns the C++ half of a combined Java and C++ compile, which writes
+  // into |java_options.cpp_output_folder_|.
+  static std::unique_ptr<CppOptions> ForJava(const JavaOptions& java_options);
+
+  // Returns options that write the files of |interface_name|, one of the
+  // interfaces the input file declares, into the same folder.  They write no
+  // dependency file, trace or statistics.
+  std::unique_ptr<CppOptions> ForInterface(
+      const std::string& interface_name) const;
+
   std::string InputFileName() const;
   std::vector<std::string> ImportPaths() const;
 
@@ -85,18 +113,36 @@ class CppOptions final {
   std::string InterfaceCppFileName() const;
   std::string InterfaceHeaderFileName() const;
 
+  // Returns the path of the dependency file to write, or an empty string
+  // if no dependency file was requested.
+  std::string DependencyFilePath() const;
+
+  // Returns the path to write a Chrome trace-event file to, or an empty
+  // string if tracing wasn't requested.
+  std::string TraceFilePath() const;
+
+  // Returns the path to write a JSON report of compiler statistics to, or
+  // an empty string if no report was requested.
+  std::string StatsFilePath() const;
+
   // TODO(wiley) Introduce other getters as necessary.
 
  private:
   CppOptions() = default;
   std::string MakeOutputName(const std::string& prefix,
                              const std::string& suffix) const;
+  bool SetInputFileName(const std::string& input_file_name);
+  // The part of the generated file names taken from |name|, the base name
+  // of the input file or the name of an interface it declares.
+  static std::string OutputBaseName(const std::string& name);
 
   std::string input_file_name_;
   std::vector<std::string> import_paths_;
   std::string output_base_folder_;
   std::string output_base_name_;
   std::string dep_file_name_;
+  std::string trace_file_name_;
+  std::string stats_file_name_;
 
   FRIEND_TEST(CppOptionsTests, ParsesCompileCpp);
   DISALLOW_COPY_AND_ASSIGN(CppOptions);
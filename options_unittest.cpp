@@ -66,6 +66,14 @@ const char* kCompileCppCommand[] = {
     kCompileCommandOutputDir,
     nullptr,
 };
+const char* kCompileJavaAndCppCommand[] = {
+    "aidl",
+    kCompileCommandIncludePath,
+    "--cpp-out",
+    kCompileCommandOutputDir,
+    kCompileCommandInput,
+    nullptr,
+};
 
 const char kClientCppPath[] = "output/dir/BpTool.cpp";
 const char kClientHeaderPath[] = "output/dir/BpTool.h";
@@ -121,6 +129,23 @@ TEST(JavaOptionsTests, ParsesCompileJava) {
   EXPECT_EQ(false, options->auto_dep_file_);
 }
 
+TEST(JavaOptionsTests, ParsesCompileJavaAndCpp) {
+  unique_ptr<JavaOptions> options =
+      GetOptions<JavaOptions>(kCompileJavaAndCppCommand);
+  EXPECT_EQ(JavaOptions::COMPILE_AIDL_TO_JAVA_AND_CPP, options->task);
+  EXPECT_EQ(string{kCompileCommandInput}, options->input_file_name_);
+  EXPECT_EQ(string{kCompileCommandJavaOutput}, options->output_file_name_);
+  EXPECT_EQ(string{kCompileCommandOutputDir}, options->cpp_output_folder_);
+
+  unique_ptr<CppOptions> cpp_options = CppOptions::ForJava(*options);
+  ASSERT_NE(cpp_options, nullptr);
+  EXPECT_EQ(kCompileCommandInput, cpp_options->InputFileName());
+  EXPECT_EQ(options->import_paths_, cpp_options->ImportPaths());
+  EXPECT_EQ(string{}, cpp_options->DependencyFilePath());
+  EXPECT_EQ(kClientCppPath, cpp_options->ClientCppFileName());
+  EXPECT_EQ(kInterfaceHeaderPath, cpp_options->InterfaceHeaderFileName());
+}
+
 TEST(CppOptionsTests, ParsesCompileCpp) {
   unique_ptr<CppOptions> options = GetOptions<CppOptions>(kCompileCppCommand);
   ASSERT_EQ(1u, options->import_paths_.size());
@@ -0,0 +1,136 @@
+/*
+ * Copyright (C) 2015, The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef AIDL_RESOLVED_INTERFACE_H_
+#define AIDL_RESOLVED_INTERFACE_H_
+
+#include <string>
+#include <vector>
+
+#include "aidl_language.h"
+
+namespace android {
+namespace aidl {
+
+// An interface after validation, with every type in its method signatures
+// looked up once in a backend's TypeNamespace.  TypeT is that backend's
+// type class (java::Type or cpp::Type).  The types are owned by the
+// namespace and the names and comments by the parse tree, both of which
+// must outlive the resolved interface.
+
+template <typename TypeT>
+struct ResolvedType {
+  const TypeT* type = nullptr;
+  bool is_array = false;
+  // The resolved parameters of a generic type, e.g. String and Foo for
+  // Map<String,Foo>.
+  std::vector<const TypeT*> type_parameters;
+};
+
+template <typename TypeT>
+struct ResolvedArgument {
+  const AidlArgument* arg = nullptr;
+  ResolvedType<TypeT> type;
+  AidlArgument::Direction direction = AidlArgument::IN_DIR;
+  bool lazy = false;
+
+  const std::string& GetName() const { return arg->GetName(); }
+  bool IsIn() const { return direction & AidlArgument::IN_DIR; }
+  bool IsOut() const { return direction & AidlArgument::OUT_DIR; }
+};
+
+template <typename TypeT>
+struct ResolvedMethod {
+  const AidlMethod* method = nullptr;
+  ResolvedType<TypeT> return_type;
+  bool returns_void = false;
+  bool oneway = false;
+  bool batched = false;
+  // The transaction id assigned during validation.
+  int id = 0;
+  std::vector<ResolvedArgument<TypeT>> arguments;
+
+  const std::string& GetName() const { return method->GetName(); }
+};
+
+template <typename TypeT>
+struct ResolvedInterface {
+  const AidlInterface* interface = nullptr;
+  std::vector<ResolvedMethod<TypeT>> methods;
+};
+
+namespace internals {
+
+template <typename TypeT, typename NamespaceT>
+bool ResolveType(const AidlType& raw_type, const NamespaceT& types,
+                 ResolvedType<TypeT>* resolved) {
+  resolved->type = types.Find(raw_type);
+  resolved->is_array = raw_type.IsArray();
+  if (!resolved->type) {
+    return false;
+  }
+
+  for (const std::string& parameter : raw_type.GetTypeParameters()) {
+    const TypeT* type = types.Find(parameter);
+    if (!type) {
+      return false;
+    }
+    resolved->type_parameters.push_back(type);
+  }
+  return true;
+}
+
+}  // namespace internals
+
+// Resolve every type used by |interface| in |types|.  This only fails if a
+// type is unknown, which cannot happen for an interface that was validated
+// against the same namespace.
+template <typename TypeT, typename NamespaceT>
+bool ResolveInterface(const AidlInterface& interface, const NamespaceT& types,
+                      ResolvedInterface<TypeT>* resolved) {
+  resolved->interface = &interface;
+  resolved->methods.clear();
+  resolved->methods.reserve(interface.GetMethods().size());
+  for (const auto& method : interface.GetMethods()) {
+    resolved->methods.emplace_back();
+    ResolvedMethod<TypeT>& m = resolved->methods.back();
+    m.method = method.get();
+    m.returns_void = method->GetType().GetName() == "void";
+    m.oneway = method->IsOneway();
+    m.batched = method->IsBatched();
+    m.id = method->GetId();
+    if (!internals::ResolveType(method->GetType(), types, &m.return_type)) {
+      return false;
+    }
+    m.arguments.reserve(method->GetArguments().size());
+    for (const auto& arg : method->GetArguments()) {
+      m.arguments.emplace_back();
+      ResolvedArgument<TypeT>& a = m.arguments.back();
+      a.arg = arg.get();
+      a.direction = arg->GetDirection();
+      a.lazy = arg->IsLazy();
+      if (!internals::ResolveType(arg->GetType(), types, &a.type)) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+}  // namespace aidl
+}  // namespace android
+
+#endif  // AIDL_RESOLVED_INTERFACE_H_
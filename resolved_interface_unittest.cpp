@@ -0,0 +1,104 @@
+/*
+ * Copyright (C) 2015, The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "aidl.h"
+#include "aidl_language.h"
+#include "resolved_interface.h"
+#include "tests/fake_io_delegate.h"
+#include "type_java.h"
+
+using android::aidl::test::FakeIoDelegate;
+using std::unique_ptr;
+using std::vector;
+
+namespace android {
+namespace aidl {
+namespace java {
+
+class ResolvedInterfaceTest : public ::testing::Test {
+ protected:
+  AidlInterface* Parse(const std::string& contents) {
+    io_delegate_.SetFileContents("p/IFoo.aidl", contents);
+    vector<unique_ptr<AidlInterface>> interfaces;
+    vector<unique_ptr<AidlImport>> imports;
+    if (::android::aidl::internals::load_and_validate_aidl(
+            {}, {}, "p/IFoo.aidl", io_delegate_, &types_, &interfaces,
+            &imports)) {
+      return nullptr;
+    }
+    interface_ = std::move(interfaces.front());
+    return interface_.get();
+  }
+
+  FakeIoDelegate io_delegate_;
+  JavaTypeNamespace types_;
+  unique_ptr<AidlInterface> interface_;
+};
+
+TEST_F(ResolvedInterfaceTest, ResolvesMethodSignatures) {
+  AidlInterface* interface = Parse(
+R"(package p;
+interface IFoo {
+  void f(in List<String> m, inout int[] a) = 3;
+  oneway void g() = 5;
+  Map h(out String[] s) = 7;
+})");
+  ASSERT_NE(interface, nullptr);
+
+  ResolvedInterface<Type> resolved;
+  ASSERT_TRUE(ResolveInterface(*interface, types_, &resolved));
+  EXPECT_EQ(interface, resolved.interface);
+  ASSERT_EQ(3u, resolved.methods.size());
+
+  const ResolvedMethod<Type>& f = resolved.methods[0];
+  EXPECT_EQ("f", f.GetName());
+  EXPECT_EQ(3, f.id);
+  EXPECT_TRUE(f.returns_void);
+  EXPECT_FALSE(f.oneway);
+  ASSERT_EQ(2u, f.arguments.size());
+  EXPECT_EQ("m", f.arguments[0].GetName());
+  EXPECT_EQ(types_.Find("List<String>"), f.arguments[0].type.type);
+  ASSERT_EQ(1u, f.arguments[0].type.type_parameters.size());
+  EXPECT_EQ(types_.Find("String"), f.arguments[0].type.type_parameters[0]);
+  EXPECT_TRUE(f.arguments[0].IsIn());
+  EXPECT_FALSE(f.arguments[0].IsOut());
+  EXPECT_EQ(types_.Find("int"), f.arguments[1].type.type);
+  EXPECT_TRUE(f.arguments[1].type.is_array);
+  EXPECT_TRUE(f.arguments[1].IsIn());
+  EXPECT_TRUE(f.arguments[1].IsOut());
+
+  EXPECT_EQ(5, resolved.methods[1].id);
+  EXPECT_TRUE(resolved.methods[1].oneway);
+  EXPECT_TRUE(resolved.methods[1].arguments.empty());
+
+  const ResolvedMethod<Type>& h = resolved.methods[2];
+  EXPECT_FALSE(h.returns_void);
+  EXPECT_EQ(types_.Find("Map"), h.return_type.type);
+  EXPECT_TRUE(h.return_type.type_parameters.empty());
+  ASSERT_EQ(1u, h.arguments.size());
+  EXPECT_FALSE(h.arguments[0].IsIn());
+  EXPECT_TRUE(h.arguments[0].IsOut());
+}
+
+}  // namespace java
+}  // namespace aidl
+}  // namespace android
@@ -0,0 +1,167 @@
+/*
+ * Copyright (C) 2015, The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "size_report.h"
+
+#include <iostream>
+
+#include <base/stringprintf.h>
+
+#include "code_writer.h"
+
+using android::base::StringPrintf;
+using std::cerr;
+using std::endl;
+using std::string;
+
+namespace android {
+namespace aidl {
+namespace java {
+namespace {
+
+// Parcel.writeNoException() ahead of the results of a two-way call.
+const size_t kReplyHeaderBytes = 4;
+
+// The size of a String16 as Parcel writes it: a length, then the UTF-16
+// characters and a terminator, padded to four bytes.
+size_t String16Bytes(const string& str) {
+  const size_t chars = (str.size() + 1) * 2;
+  return 4 + ((chars + 3) & ~static_cast<size_t>(3));
+}
+
+string Descriptor(const AidlInterface& interface) {
+  return (interface.GetPackage().empty())
+      ? interface.GetName() : interface.GetCanonicalName();
+}
+
+// Parcel.writeInterfaceToken() writes a strict mode policy and the
+// descriptor of the interface.  A @CompactInterfaceToken is just the
+// long hash of the descriptor.
+size_t InterfaceTokenBytes(const AidlInterface& interface) {
+  if (interface.HasCompactToken()) {
+    return 8;
+  }
+  return 4 + String16Bytes(Descriptor(interface));
+}
+
+MarshalledSize SizeOf(const ResolvedType<Type>& type) {
+  return (type.is_array) ? type.type->GetArrayMarshalledSize()
+                         : type.type->GetMarshalledSize();
+}
+
+bool IsUnbounded(const ResolvedType<Type>& type) {
+  return type.is_array || type.type->IsCollection();
+}
+
+string FormatBounds(const MarshalledSize& size) {
+  if (!size.bounded) {
+    return StringPrintf("%zu..unbounded bytes", size.min);
+  }
+  return StringPrintf("%zu..%zu bytes", size.min, size.max);
+}
+
+}  // namespace
+
+MethodSize ComputeMethodSize(const ResolvedMethod<Type>& method,
+                             const AidlInterface& interface) {
+  MethodSize result;
+  result.name = method.GetName();
+  result.oneway = method.oneway;
+
+  const size_t token_bytes = InterfaceTokenBytes(interface);
+  result.request = MarshalledSize::Fixed(token_bytes);
+  if (!method.oneway) {
+    result.reply = MarshalledSize::Fixed(kReplyHeaderBytes);
+  }
+
+  if (!method.returns_void) {
+    result.reply += SizeOf(method.return_type);
+    if (IsUnbounded(method.return_type)) {
+      result.unbounded.push_back(
+          "return " + method.method->GetType().ToString());
+    }
+  }
+
+  for (const ResolvedArgument<Type>& arg : method.arguments) {
+    const MarshalledSize size = SizeOf(arg.type);
+    if (arg.IsIn()) {
+      result.request += size;
+      if (arg.lazy) {
+        // @Lazy parcelables are prefixed with their length.
+        result.request += MarshalledSize::Fixed(4);
+      }
+    } else if (arg.type.is_array) {
+      // The proxy sends the length of an out array so the stub can
+      // allocate one to fill in.
+      result.request += MarshalledSize::Fixed(4);
+    }
+    if (arg.IsOut()) {
+      result.reply += size;
+    }
+    if (IsUnbounded(arg.type)) {
+      result.unbounded.push_back(arg.arg->ToString());
+    }
+  }
+
+  result.batching_candidate =
+      !method.oneway &&
+      result.request.bounded && result.reply.bounded &&
+      result.request.max - token_bytes <= kSmallPayloadBytes &&
+      result.reply.max - kReplyHeaderBytes <= kSmallPayloadBytes;
+  return result;
+}
+
+bool WriteSizeReport(const string& file_path,
+                     const ResolvedInterface<Type>& interface,
+                     const IoDelegate& io_delegate) {
+  CodeWriterPtr writer = io_delegate.GetCodeWriter(file_path);
+  if (!writer) {
+    cerr << "Could not open size report file: " << file_path << endl;
+    return false;
+  }
+
+  const AidlInterface& iface = *interface.interface;
+  bool success = writer->Write(
+      "// aidl size report for %s\n"
+      "// Bounds on the Parcel bytes of each transaction.  Binder fails\n"
+      "// transactions once a process's 1MB buffer is used up.\n",
+      Descriptor(iface).c_str());
+  for (const ResolvedMethod<Type>& method : interface.methods) {
+    const MethodSize size = ComputeMethodSize(method, iface);
+    if (size.oneway) {
+      success &= writer->Write("%s: oneway, request %s\n", size.name.c_str(),
+                               FormatBounds(size.request).c_str());
+    } else {
+      success &= writer->Write("%s: request %s, reply %s\n",
+                               size.name.c_str(),
+                               FormatBounds(size.request).c_str(),
+                               FormatBounds(size.reply).c_str());
+    }
+    for (const string& unbounded : size.unbounded) {
+      success &= writer->Write("  unbounded: %s\n", unbounded.c_str());
+    }
+    if (size.batching_candidate) {
+      success &= writer->Write(
+          "  batching candidate: at most %zu bytes of arguments and "
+          "results\n", kSmallPayloadBytes);
+    }
+  }
+  return success;
+}
+
+}  // namespace java
+}  // namespace aidl
+}  // namespace android
@@ -0,0 +1,64 @@
+/*
+ * Copyright (C) 2015, The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef AIDL_SIZE_REPORT_H_
+#define AIDL_SIZE_REPORT_H_
+
+#include <string>
+#include <vector>
+
+#include "io_delegate.h"
+#include "resolved_interface.h"
+#include "type_java.h"
+
+namespace android {
+namespace aidl {
+namespace java {
+
+// Two-way methods whose arguments and results both fit in this many bytes
+// are reported as candidates for batching into fewer transactions.
+const size_t kSmallPayloadBytes = 16;
+
+// Static bounds on the Parcels the generated Java proxy and stub exchange
+// for one method.
+struct MethodSize {
+  std::string name;
+  bool oneway = false;
+  // Everything the proxy writes, including the interface token.
+  MarshalledSize request;
+  // Everything the stub writes back, including the exception header.  Empty
+  // for oneway methods, which get no reply.
+  MarshalledSize reply;
+  // Arguments and return values that are arrays or collections, and so
+  // have no upper bound, e.g. "in int[] data" or "return List<String>".
+  std::vector<std::string> unbounded;
+  bool batching_candidate = false;
+};
+
+// Bounds the transactions of |method|, a method of |interface|.
+MethodSize ComputeMethodSize(const ResolvedMethod<Type>& method,
+                             const AidlInterface& interface);
+
+// Write the bounds on every method of |interface| to |file_path|.
+bool WriteSizeReport(const std::string& file_path,
+                     const ResolvedInterface<Type>& interface,
+                     const IoDelegate& io_delegate);
+
+}  // namespace java
+}  // namespace aidl
+}  // namespace android
+
+#endif  // AIDL_SIZE_REPORT_H_
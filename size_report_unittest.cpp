@@ -0,0 +1,176 @@
+/*
+ * Copyright (C) 2015, The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "aidl.h"
+#include "aidl_language.h"
+#include "size_report.h"
+#include "tests/fake_io_delegate.h"
+#include "type_java.h"
+
+using android::aidl::test::FakeIoDelegate;
+using std::string;
+using std::unique_ptr;
+using std::vector;
+
+namespace android {
+namespace aidl {
+namespace java {
+namespace {
+
+const char kPath[] = "p/IFoo.aidl";
+// The strict mode policy, then "p.IFoo" as a String16: a length and seven
+// UTF-16 characters, padded to 16 bytes.
+const size_t kTokenBytes = 4 + 4 + 16;
+
+const char kContents[] =
+R"(package p;
+import p.Bundle;
+interface IFoo {
+  int ping(int token, long when, boolean flag);
+  void send(in byte[] data, out String[] names);
+  List<String> list();
+  oneway void notify(in IFoo callback);
+  void store(in Bundle bundle);
+})";
+
+// A compact interface token is a long, whatever the descriptor.
+const char kCompactPath[] = "p/ICompact.aidl";
+const size_t kCompactTokenBytes = 8;
+
+const char kCompactContents[] =
+R"(package p;
+@CompactInterfaceToken
+interface ICompact {
+  int now();
+  int pair(long a, long b);
+  int triple(long a, long b, long c);
+})";
+
+const char kExpectedReport[] =
+R"(// aidl size report for p.IFoo
+// Bounds on the Parcel bytes of each transaction.  Binder fails
+// transactions once a process's 1MB buffer is used up.
+ping: request 40..40 bytes, reply 8..8 bytes
+  batching candidate: at most 16 bytes of arguments and results
+send: request 32..unbounded bytes, reply 8..unbounded bytes
+  unbounded: in byte[] data
+  unbounded: out String[] names
+list: request 24..24 bytes, reply 8..unbounded bytes
+  unbounded: return List<String>
+notify: oneway, request 48..48 bytes
+store: request 28..unbounded bytes, reply 4..4 bytes
+)";
+
+}  // namespace
+
+class SizeReportTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    io_delegate_.SetFileContents(kPath, kContents);
+    io_delegate_.AddStubParcelable("p.Bundle");
+    vector<unique_ptr<AidlInterface>> interfaces;
+    vector<unique_ptr<AidlImport>> imports;
+    ASSERT_EQ(0, ::android::aidl::internals::load_and_validate_aidl(
+        {}, {"."}, kPath, io_delegate_, &types_, &interfaces, &imports));
+    interface_ = std::move(interfaces.front());
+    ASSERT_TRUE(ResolveInterface(*interface_, types_, &resolved_));
+  }
+
+  FakeIoDelegate io_delegate_;
+  JavaTypeNamespace types_;
+  unique_ptr<AidlInterface> interface_;
+  ResolvedInterface<Type> resolved_;
+};
+
+TEST_F(SizeReportTest, BoundsFixedSizeMethods) {
+  const MethodSize ping = ComputeMethodSize(resolved_.methods[0], *interface_);
+  EXPECT_EQ("ping", ping.name);
+  EXPECT_FALSE(ping.oneway);
+  EXPECT_TRUE(ping.request.bounded);
+  EXPECT_EQ(kTokenBytes + 4 + 8 + 4, ping.request.min);
+  EXPECT_EQ(ping.request.min, ping.request.max);
+  EXPECT_TRUE(ping.reply.bounded);
+  EXPECT_EQ(8u, ping.reply.max);
+  EXPECT_TRUE(ping.unbounded.empty());
+  EXPECT_TRUE(ping.batching_candidate);
+
+  // Oneway methods have no reply, so they are never batching candidates.
+  const MethodSize notify =
+      ComputeMethodSize(resolved_.methods[3], *interface_);
+  EXPECT_TRUE(notify.oneway);
+  EXPECT_EQ(kTokenBytes + 24, notify.request.max);
+  EXPECT_EQ(0u, notify.reply.max);
+  EXPECT_FALSE(notify.batching_candidate);
+}
+
+TEST_F(SizeReportTest, FlagsUnboundedArguments) {
+  const MethodSize send = ComputeMethodSize(resolved_.methods[1], *interface_);
+  EXPECT_FALSE(send.request.bounded);
+  // A null marker for the input, and the length of the output array.
+  EXPECT_EQ(kTokenBytes + 4 + 4, send.request.min);
+  EXPECT_FALSE(send.reply.bounded);
+  EXPECT_EQ((vector<string>{"in byte[] data", "out String[] names"}),
+            send.unbounded);
+  EXPECT_FALSE(send.batching_candidate);
+
+  // Parcelables are opaque, but not flagged as collections.
+  const MethodSize store =
+      ComputeMethodSize(resolved_.methods[4], *interface_);
+  EXPECT_FALSE(store.request.bounded);
+  EXPECT_TRUE(store.unbounded.empty());
+  EXPECT_FALSE(store.batching_candidate);
+}
+
+TEST_F(SizeReportTest, CountsCompactInterfaceTokens) {
+  io_delegate_.SetFileContents(kCompactPath, kCompactContents);
+  JavaTypeNamespace types;
+  vector<unique_ptr<AidlInterface>> interfaces;
+  vector<unique_ptr<AidlImport>> imports;
+  ASSERT_EQ(0, ::android::aidl::internals::load_and_validate_aidl(
+      {}, {"."}, kCompactPath, io_delegate_, &types, &interfaces, &imports));
+  ResolvedInterface<Type> resolved;
+  ASSERT_TRUE(ResolveInterface(*interfaces.front(), types, &resolved));
+  const AidlInterface& compact = *interfaces.front();
+
+  const MethodSize now = ComputeMethodSize(resolved.methods[0], compact);
+  EXPECT_EQ(kCompactTokenBytes, now.request.max);
+  EXPECT_TRUE(now.batching_candidate);
+
+  // Batching candidates are judged on their arguments alone.
+  const MethodSize pair = ComputeMethodSize(resolved.methods[1], compact);
+  EXPECT_EQ(kCompactTokenBytes + 16, pair.request.max);
+  EXPECT_TRUE(pair.batching_candidate);
+  const MethodSize triple = ComputeMethodSize(resolved.methods[2], compact);
+  EXPECT_EQ(kCompactTokenBytes + 24, triple.request.max);
+  EXPECT_FALSE(triple.batching_candidate);
+}
+
+TEST_F(SizeReportTest, WritesReport) {
+  ASSERT_TRUE(WriteSizeReport("out/IFoo.sizes", resolved_, io_delegate_));
+  string report;
+  ASSERT_TRUE(io_delegate_.GetWrittenContents("out/IFoo.sizes", &report));
+  EXPECT_EQ(kExpectedReport, report);
+}
+
+}  // namespace java
+}  // namespace aidl
+}  // namespace android
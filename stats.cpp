@@ -0,0 +1,114 @@
+/*
+ * Copyright (C) 2015, The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "stats.h"
+
+#include <atomic>
+#include <iostream>
+
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+
+#include "code_writer.h"
+
+using std::cerr;
+using std::endl;
+using std::string;
+
+namespace android {
+namespace aidl {
+namespace stats {
+namespace {
+
+std::atomic<bool> enabled{false};
+std::atomic<uint64_t> counters[NUM_COUNTERS];
+
+// Keep in sync with enum Counter.
+const char* const kCounterNames[NUM_COUNTERS] = {
+  "files_read",
+  "bytes_lexed",
+  "tokens",
+  "imports_resolved",
+  "file_readable_probes",
+  "import_cache_hits",
+  "import_cache_misses",
+  "java_types_created",
+  "cpp_types_created",
+  "type_lookups",
+  "ast_nodes_allocated",
+  "bytes_written",
+};
+
+}  // namespace
+
+uint64_t PeakResidentSetKb() {
+#ifdef _WIN32
+  return 0;
+#else
+  struct rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage) != 0) {
+    return 0;
+  }
+#ifdef __APPLE__
+  return usage.ru_maxrss / 1024;  // Darwin reports bytes.
+#else
+  return usage.ru_maxrss;
+#endif
+#endif
+}
+
+void Enable() {
+  enabled = true;
+}
+
+bool IsEnabled() {
+  return enabled;
+}
+
+void Increment(Counter counter, uint64_t amount) {
+  if (!enabled.load(std::memory_order_relaxed)) {
+    return;
+  }
+  counters[counter].fetch_add(amount, std::memory_order_relaxed);
+}
+
+uint64_t Get(Counter counter) {
+  return counters[counter].load(std::memory_order_relaxed);
+}
+
+bool WriteStats(const string& file_path, const IoDelegate& io_delegate) {
+  CodeWriterPtr writer = io_delegate.GetCodeWriter(file_path);
+  if (!writer) {
+    cerr << "Could not open stats file: " << file_path << endl;
+    return false;
+  }
+
+  bool success = writer->Write("{\n");
+  for (int i = 0; i < NUM_COUNTERS; ++i) {
+    success &= writer->Write(
+        "  \"%s\": %llu,\n", kCounterNames[i],
+        static_cast<unsigned long long>(Get(static_cast<Counter>(i))));
+  }
+  success &= writer->Write(
+      "  \"peak_rss_kb\": %llu\n}\n",
+      static_cast<unsigned long long>(PeakResidentSetKb()));
+  return success;
+}
+
+}  // namespace stats
+}  // namespace aidl
+}  // namespace android
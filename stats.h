@@ -0,0 +1,67 @@
+/*
+ * Copyright (C) 2015, The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef AIDL_STATS_H_
+#define AIDL_STATS_H_
+
+#include <cstdint>
+#include <string>
+
+#include "io_delegate.h"
+
+namespace android {
+namespace aidl {
+namespace stats {
+
+enum Counter {
+  FILES_READ,
+  BYTES_LEXED,
+  TOKENS,
+  IMPORTS_RESOLVED,
+  FILE_PROBES,
+  // Imports satisfied by a type we already knew about, e.g. from a
+  // preprocessed file, versus imports we had to go find on disk.
+  IMPORT_CACHE_HITS,
+  IMPORT_CACHE_MISSES,
+  JAVA_TYPES_CREATED,
+  CPP_TYPES_CREATED,
+  TYPE_LOOKUPS,
+  AST_NODES,
+  BYTES_WRITTEN,
+  NUM_COUNTERS,
+};
+
+// Start counting.  Until this is called, Increment does nothing beyond
+// checking a flag.
+void Enable();
+bool IsEnabled();
+
+// Counters are process wide and safe to bump from any thread.
+void Increment(Counter counter, uint64_t amount = 1);
+uint64_t Get(Counter counter);
+
+// Peak resident set size of this process so far, or 0 if unknown.
+uint64_t PeakResidentSetKb();
+
+// Write every counter, plus the peak resident set size of this process, to
+// |file_path| as a flat JSON object.
+bool WriteStats(const std::string& file_path, const IoDelegate& io_delegate);
+
+}  // namespace stats
+}  // namespace aidl
+}  // namespace android
+
+#endif  // AIDL_STATS_H_
@@ -0,0 +1,109 @@
+/*
+ * Copyright (C) 2015, The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <memory>
+#include <string>
+
+#include <base/macros.h>
+#include <base/stringprintf.h>
+#include <gtest/gtest.h>
+
+#include "aidl.h"
+#include "options.h"
+#include "stats.h"
+#include "tests/fake_io_delegate.h"
+
+using android::aidl::test::FakeIoDelegate;
+using android::base::StringPrintf;
+using std::string;
+using std::unique_ptr;
+
+namespace android {
+namespace aidl {
+namespace stats {
+
+// Counters are process wide, so these tests only look at how they change.
+TEST(StatsTest, CountsOnceEnabled) {
+  if (!IsEnabled()) {
+    const uint64_t before = Get(TOKENS);
+    Increment(TOKENS, 5);
+    EXPECT_EQ(before, Get(TOKENS));
+  }
+
+  Enable();
+  ASSERT_TRUE(IsEnabled());
+  const uint64_t before = Get(TOKENS);
+  Increment(TOKENS);
+  Increment(TOKENS, 5);
+  EXPECT_EQ(before + 6, Get(TOKENS));
+}
+
+TEST(StatsTest, CountsCompilerWork) {
+  Enable();
+  uint64_t before[NUM_COUNTERS];
+  for (int i = 0; i < NUM_COUNTERS; ++i) {
+    before[i] = Get(static_cast<Counter>(i));
+  }
+
+  FakeIoDelegate io_delegate;
+  io_delegate.SetFileContents("p/IFoo.aidl",
+                              "package p;\n"
+                              "interface IFoo {\n"
+                              "  int ping(int token);\n"
+                              "}\n");
+  const char* argv[] = {"aidl", "-I.", "p/IFoo.aidl", "out/IFoo.java"};
+  unique_ptr<JavaOptions> options = JavaOptions::Parse(arraysize(argv), argv);
+  ASSERT_NE(options, nullptr);
+  ASSERT_EQ(0, compile_aidl_to_java(*options, io_delegate));
+
+  EXPECT_LT(before[FILES_READ], Get(FILES_READ));
+  EXPECT_LT(before[BYTES_LEXED], Get(BYTES_LEXED));
+  EXPECT_LT(before[TOKENS], Get(TOKENS));
+  EXPECT_LT(before[AST_NODES], Get(AST_NODES));
+  EXPECT_LT(before[TYPE_LOOKUPS], Get(TYPE_LOOKUPS));
+}
+
+TEST(StatsTest, WritesEveryCounterAsJson) {
+  Enable();
+  Increment(IMPORTS_RESOLVED, 3);
+
+  FakeIoDelegate io_delegate;
+  ASSERT_TRUE(WriteStats("out/stats.json", io_delegate));
+  string report;
+  ASSERT_TRUE(io_delegate.GetWrittenContents("out/stats.json", &report));
+  EXPECT_EQ(0u, report.find("{\n  \"files_read\": "));
+  EXPECT_NE(string::npos, report.find(StringPrintf(
+      "\n  \"imports_resolved\": %llu,\n",
+      static_cast<unsigned long long>(Get(IMPORTS_RESOLVED)))));
+  const char* const kNames[] = {
+    "files_read", "bytes_lexed", "tokens", "imports_resolved",
+    "file_readable_probes", "import_cache_hits", "import_cache_misses",
+    "java_types_created", "cpp_types_created", "type_lookups",
+    "ast_nodes_allocated", "bytes_written",
+  };
+  static_assert(arraysize(kNames) == NUM_COUNTERS,
+                "every counter is reported");
+  for (const char* name : kNames) {
+    EXPECT_NE(string::npos, report.find(StringPrintf("\"%s\": ", name)))
+        << name;
+  }
+  EXPECT_NE(string::npos, report.find("\n  \"peak_rss_kb\": "));
+  EXPECT_EQ("\n}\n", report.substr(report.size() - 3));
+}
+
+}  // namespace stats
+}  // namespace aidl
+}  // namespace android
@@ -0,0 +1,346 @@
+/*
+ * Copyright (C) 2015, The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <base/stringprintf.h>
+#include <benchmark/benchmark.h>
+
+#include "aidl.h"
+#include "aidl_language.h"
+#include "ast_java.h"
+#include "code_writer.h"
+#include "generate_cpp.h"
+#include "generate_java.h"
+#include "options.h"
+#include "resolved_interface.h"
+#include "stats.h"
+#include "tests/fake_io_delegate.h"
+#include "tests/synthetic_corpus.h"
+#include "type_cpp.h"
+#include "type_java.h"
+
+using android::aidl::test::Corpus;
+using android::aidl::test::CorpusOptions;
+using android::aidl::test::FakeIoDelegate;
+using android::aidl::test::GenerateCorpus;
+using android::aidl::test::MakeInterface;
+using android::base::StringPrintf;
+using std::string;
+using std::unique_ptr;
+using std::vector;
+
+namespace android {
+namespace aidl {
+namespace {
+
+const char kPackage[] = "android.bench";
+const char kInterfacePath[] = "android/bench/IBench.aidl";
+const uint32_t kSeed = 42;
+
+// Parses and validates a single generated interface.  The returned
+// interface is owned by the caller.
+AidlInterface* LoadInterface(int num_methods, bool primitives_only,
+                             TypeNamespace* types) {
+  FakeIoDelegate io_delegate;
+  io_delegate.SetFileContents(
+      kInterfacePath,
+      MakeInterface(kPackage, "IBench", num_methods, primitives_only, kSeed));
+  vector<unique_ptr<AidlInterface>> interfaces;
+  vector<unique_ptr<AidlImport>> imports;
+  if (internals::load_and_validate_aidl({}, {}, kInterfacePath, io_delegate,
+                                        types, &interfaces, &imports) != 0) {
+    return nullptr;
+  }
+  return interfaces.front().release();
+}
+
+// Compiles every interface in |corpus| to Java.
+bool CompileCorpus(const Corpus& corpus, const FakeIoDelegate& io_delegate) {
+  for (const string& path : corpus.interface_paths) {
+    vector<const char*> argv = {"aidl", "-I."};
+    string preprocessed;
+    if (!corpus.preprocessed_path.empty()) {
+      preprocessed = "-p" + corpus.preprocessed_path;
+      argv.push_back(preprocessed.c_str());
+    }
+    argv.push_back(path.c_str());
+    unique_ptr<JavaOptions> options = JavaOptions::Parse(argv.size(),
+                                                         argv.data());
+    if (!options || compile_aidl_to_java(*options, io_delegate) != 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Reports what one iteration of an end to end benchmark did, and the peak
+// memory use of the whole run so far.
+class StatsLabel {
+ public:
+  StatsLabel() {
+    stats::Enable();
+    for (int i = 0; i < stats::NUM_COUNTERS; ++i) {
+      start_[i] = stats::Get(static_cast<stats::Counter>(i));
+    }
+  }
+
+  void Set(benchmark::State& state) const {
+    const uint64_t iterations = std::max<uint64_t>(state.iterations(), 1);
+    state.SetLabel(StringPrintf(
+        "files_read=%llu bytes_lexed=%llu ast_nodes=%llu type_lookups=%llu "
+        "peak_rss_kb=%llu",
+        PerIteration(stats::FILES_READ, iterations),
+        PerIteration(stats::BYTES_LEXED, iterations),
+        PerIteration(stats::AST_NODES, iterations),
+        PerIteration(stats::TYPE_LOOKUPS, iterations),
+        static_cast<unsigned long long>(stats::PeakResidentSetKb())));
+  }
+
+ private:
+  unsigned long long PerIteration(stats::Counter counter,
+                                  uint64_t iterations) const {
+    return (stats::Get(counter) - start_[counter]) / iterations;
+  }
+
+  uint64_t start_[stats::NUM_COUNTERS];
+};
+
+}  // namespace
+
+// Lexing and parsing a single interface of state.range(0) methods.
+void BM_ParseInterface(benchmark::State& state) {
+  FakeIoDelegate io_delegate;
+  const string contents =
+      MakeInterface(kPackage, "IBench", state.range(0), false, kSeed);
+  io_delegate.SetFileContents(kInterfacePath, contents);
+  while (state.KeepRunning()) {
+    Parser p{io_delegate};
+    if (!p.ParseFile(kInterfacePath)) {
+      state.SkipWithError("Failed to parse");
+      break;
+    }
+    unique_ptr<AidlDocument> doc(p.GetDocument());
+  }
+  state.SetBytesProcessed(state.iterations() * contents.size());
+}
+BENCHMARK(BM_ParseInterface)->Arg(10)->Arg(100)->Arg(1000);
+
+// Looking up a parcelable by its short name among state.range(0) others.
+void BM_JavaTypeNamespaceFind(benchmark::State& state) {
+  java::JavaTypeNamespace types;
+  const int count = state.range(0);
+  for (int i = 0; i < count; ++i) {
+    // These leak, like every AidlParcelable handed to a namespace.
+    types.AddParcelableType(
+        new AidlParcelable(StringPrintf("Parcelable%d", i), 0, kPackage),
+        "Parcelables.aidl");
+  }
+  const string last = StringPrintf("Parcelable%d", count - 1);
+  while (state.KeepRunning()) {
+    benchmark::DoNotOptimize(types.Find(last));
+  }
+}
+BENCHMARK(BM_JavaTypeNamespaceFind)->Arg(10)->Arg(100)->Arg(1000)->Arg(10000);
+
+// Starting a compile with state.range(0) preprocessed parcelables, by
+// loading them into a new namespace each time...
+void BM_JavaTypeNamespaceFromScratch(benchmark::State& state) {
+  const int count = state.range(0);
+  vector<unique_ptr<AidlParcelable>> parcelables;
+  for (int i = 0; i < count; ++i) {
+    parcelables.emplace_back(
+        new AidlParcelable(StringPrintf("Parcelable%d", i), 0, kPackage));
+  }
+  while (state.KeepRunning()) {
+    java::JavaTypeNamespace types;
+    for (const auto& parcelable : parcelables) {
+      types.AddParcelableType(parcelable.get(), "framework.aidl");
+    }
+  }
+}
+BENCHMARK(BM_JavaTypeNamespaceFromScratch)->Arg(100)->Arg(1000);
+
+// ...or by layering over a frozen namespace that already holds them.
+void BM_JavaTypeNamespaceOverlay(benchmark::State& state) {
+  const int count = state.range(0);
+  vector<unique_ptr<AidlParcelable>> parcelables;
+  java::JavaTypeNamespace base;
+  for (int i = 0; i < count; ++i) {
+    parcelables.emplace_back(
+        new AidlParcelable(StringPrintf("Parcelable%d", i), 0, kPackage));
+    base.AddParcelableType(parcelables.back().get(), "framework.aidl");
+  }
+  base.Freeze();
+  while (state.KeepRunning()) {
+    java::JavaTypeNamespace types(&base);
+    benchmark::DoNotOptimize(types.StringType());
+  }
+}
+BENCHMARK(BM_JavaTypeNamespaceOverlay)->Arg(100)->Arg(1000);
+
+void BM_CheckTypes(benchmark::State& state) {
+  java::JavaTypeNamespace types;
+  unique_ptr<AidlInterface> interface(
+      LoadInterface(state.range(0), false, &types));
+  if (!interface) {
+    state.SkipWithError("Failed to load interface");
+    return;
+  }
+  while (state.KeepRunning()) {
+    benchmark::DoNotOptimize(
+        internals::check_types(kInterfacePath, interface.get(), &types));
+  }
+}
+BENCHMARK(BM_CheckTypes)->Arg(10)->Arg(100)->Arg(1000);
+
+void BM_GenerateBinderInterfaceClass(benchmark::State& state) {
+  java::JavaTypeNamespace types;
+  unique_ptr<AidlInterface> interface(
+      LoadInterface(state.range(0), false, &types));
+  if (!interface) {
+    state.SkipWithError("Failed to load interface");
+    return;
+  }
+  ResolvedInterface<java::Type> resolved;
+  if (!ResolveInterface(*interface, types, &resolved)) {
+    state.SkipWithError("Failed to resolve interface");
+    return;
+  }
+  size_t bytes = 0;
+  while (state.KeepRunning()) {
+    // The per-method code is only built while the class is written.  The
+    // rest of the Java AST is freed with the scope.
+    java::NodeScope scope;
+    string output;
+    CodeWriterPtr writer = GetStringWriter(&output);
+    java::generate_binder_interface_class(resolved, &types, false)
+        ->Write(writer.get());
+    bytes += output.size();
+  }
+  state.SetBytesProcessed(bytes);
+}
+BENCHMARK(BM_GenerateBinderInterfaceClass)->Arg(10)->Arg(100)->Arg(1000);
+
+void BM_BuildCpp(benchmark::State& state) {
+  cpp::TypeNamespace types;
+  unique_ptr<AidlInterface> interface(
+      LoadInterface(state.range(0), true, &types));
+  if (!interface) {
+    state.SkipWithError("Failed to load interface");
+    return;
+  }
+  ResolvedInterface<cpp::Type> resolved;
+  if (!ResolveInterface(*interface, types, &resolved)) {
+    state.SkipWithError("Failed to resolve interface");
+    return;
+  }
+  size_t bytes = 0;
+  while (state.KeepRunning()) {
+    // The per-method code is only built while each document is written.
+    string output;
+    CodeWriterPtr writer = GetStringWriter(&output);
+    cpp::internals::BuildClientSource(resolved)->Write(writer.get());
+    cpp::internals::BuildClientHeader(resolved)->Write(writer.get());
+    cpp::internals::BuildServerSource(resolved)->Write(writer.get());
+    cpp::internals::BuildServerHeader(resolved)->Write(writer.get());
+    cpp::internals::BuildInterfaceSource(resolved)->Write(writer.get());
+    cpp::internals::BuildInterfaceHeader(resolved)->Write(writer.get());
+    bytes += output.size();
+  }
+  state.SetBytesProcessed(bytes);
+}
+BENCHMARK(BM_BuildCpp)->Arg(10)->Arg(100)->Arg(1000);
+
+// Writing state.range(0) formatted lines through a CodeWriter.
+void BM_CodeWriter(benchmark::State& state) {
+  const int lines = state.range(0);
+  size_t bytes = 0;
+  while (state.KeepRunning()) {
+    string output;
+    CodeWriterPtr writer = GetStringWriter(&output);
+    for (int i = 0; i < lines; ++i) {
+      writer->Write("status = data.writeInt32(%s%d);\n", "arg", i);
+    }
+    bytes += output.size();
+  }
+  state.SetBytesProcessed(bytes);
+}
+BENCHMARK(BM_CodeWriter)->Arg(100)->Arg(10000);
+
+// End to end: compile a tree of state.range(0) interfaces, each importing
+// a handful of parcelables and the interfaces generated before it.
+void BM_CompileCorpus(benchmark::State& state) {
+  FakeIoDelegate io_delegate;
+  CorpusOptions options;
+  options.num_interfaces = state.range(0);
+  options.methods_per_interface = 10;
+  options.num_parcelables = 32;
+  options.interface_imports_per_interface = 4;
+  const Corpus corpus = GenerateCorpus(options, &io_delegate);
+  const StatsLabel label;
+  while (state.KeepRunning()) {
+    if (!CompileCorpus(corpus, io_delegate)) {
+      state.SkipWithError("Failed to compile corpus");
+      break;
+    }
+  }
+  label.Set(state);
+}
+BENCHMARK(BM_CompileCorpus)->Arg(10)->Arg(1000)->Arg(10000);
+
+// End to end: a single interface with state.range(0) methods.
+void BM_CompileLargeInterface(benchmark::State& state) {
+  FakeIoDelegate io_delegate;
+  CorpusOptions options;
+  options.methods_per_interface = state.range(0);
+  const Corpus corpus = GenerateCorpus(options, &io_delegate);
+  const StatsLabel label;
+  while (state.KeepRunning()) {
+    if (!CompileCorpus(corpus, io_delegate)) {
+      state.SkipWithError("Failed to compile corpus");
+      break;
+    }
+  }
+  label.Set(state);
+}
+BENCHMARK(BM_CompileLargeInterface)->Arg(100)->Arg(1000);
+
+// End to end: one interface compiled against a preprocessed file with
+// state.range(0) declarations, as when building against the SDK.
+void BM_CompileWithPreprocessed(benchmark::State& state) {
+  FakeIoDelegate io_delegate;
+  CorpusOptions options;
+  options.preprocessed_lines = state.range(0);
+  const Corpus corpus = GenerateCorpus(options, &io_delegate);
+  const StatsLabel label;
+  while (state.KeepRunning()) {
+    if (!CompileCorpus(corpus, io_delegate)) {
+      state.SkipWithError("Failed to compile corpus");
+      break;
+    }
+  }
+  label.Set(state);
+}
+BENCHMARK(BM_CompileWithPreprocessed)->Arg(1000)->Arg(10000);
+
+}  // namespace aidl
+}  // namespace android
+
+BENCHMARK_MAIN();
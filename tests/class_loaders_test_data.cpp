@@ -0,0 +1,283 @@
+/*
+ * Copyright (C) 2015, The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "tests/test_data.h"
+
+namespace aidl {
+namespace test_data {
+
+const char kIClassLoadersClass[] = "android.test.IClassLoaders";
+
+// Untyped collections need a class loader to unmarshal.  A proxy method
+// reuses the class loader its transaction helper declared, if any.
+const char kIClassLoadersContents[] = R"(
+package android.test;
+
+interface IClassLoaders {
+    Map swap(in Map m);
+    Map fresh(int x);
+    void fill(out List l);
+    List both(in List a, out Map b);
+    int plain(int a);
+}
+)";
+
+const char kIClassLoadersJava[] =
+R"(/*
+ * This file is auto-generated.  DO NOT MODIFY.
+ * Original file: android/test/IClassLoaders.aidl
+ */
+package android.test;
+public interface IClassLoaders extends android.os.IInterface
+{
+/** Local-side IPC implementation stub class. */
+public static abstract class Stub extends android.os.Binder implements android.test.IClassLoaders
+{
+private static final java.lang.String DESCRIPTOR = "android.test.IClassLoaders";
+/** Construct the stub at attach it to the interface. */
+public Stub()
+{
+this.attachInterface(this, DESCRIPTOR);
+}
+/**
+ * Cast an IBinder object into an android.test.IClassLoaders interface,
+ * generating a proxy if needed.
+ */
+public static android.test.IClassLoaders asInterface(android.os.IBinder obj)
+{
+if ((obj==null)) {
+return null;
+}
+android.os.IInterface iin = obj.queryLocalInterface(DESCRIPTOR);
+if (((iin!=null)&&(iin instanceof android.test.IClassLoaders))) {
+return ((android.test.IClassLoaders)iin);
+}
+return new android.test.IClassLoaders.Stub.Proxy(obj);
+}
+@Override public android.os.IBinder asBinder()
+{
+return this;
+}
+@Override public boolean onTransact(int code, android.os.Parcel data, android.os.Parcel reply, int flags) throws android.os.RemoteException
+{
+switch (code)
+{
+case INTERFACE_TRANSACTION:
+{
+reply.writeString(DESCRIPTOR);
+return true;
+}
+case TRANSACTION_swap:
+{
+return this.onTransact$swap$(data, reply);
+}
+case TRANSACTION_fresh:
+{
+return this.onTransact$fresh$(data, reply);
+}
+case TRANSACTION_fill:
+{
+return this.onTransact$fill$(data, reply);
+}
+case TRANSACTION_both:
+{
+return this.onTransact$both$(data, reply);
+}
+case TRANSACTION_plain:
+{
+return this.onTransact$plain$(data, reply);
+}
+}
+return super.onTransact(code, data, reply, flags);
+}
+private boolean onTransact$swap$(android.os.Parcel data, android.os.Parcel reply) throws android.os.RemoteException
+{
+data.enforceInterface(DESCRIPTOR);
+java.util.Map _arg0;
+java.lang.ClassLoader cl = (java.lang.ClassLoader)this.getClass().getClassLoader();
+_arg0 = data.readHashMap(cl);
+java.util.Map _result = this.swap(_arg0);
+reply.writeNoException();
+reply.writeMap(_result);
+return true;
+}
+private boolean onTransact$fresh$(android.os.Parcel data, android.os.Parcel reply) throws android.os.RemoteException
+{
+data.enforceInterface(DESCRIPTOR);
+int _arg0;
+_arg0 = data.readInt();
+java.util.Map _result = this.fresh(_arg0);
+reply.writeNoException();
+reply.writeMap(_result);
+return true;
+}
+private boolean onTransact$fill$(android.os.Parcel data, android.os.Parcel reply) throws android.os.RemoteException
+{
+data.enforceInterface(DESCRIPTOR);
+java.util.List _arg0;
+_arg0 = new java.util.ArrayList();
+this.fill(_arg0);
+reply.writeNoException();
+reply.writeList(_arg0);
+return true;
+}
+private boolean onTransact$both$(android.os.Parcel data, android.os.Parcel reply) throws android.os.RemoteException
+{
+data.enforceInterface(DESCRIPTOR);
+java.util.List _arg0;
+java.lang.ClassLoader cl = (java.lang.ClassLoader)this.getClass().getClassLoader();
+_arg0 = data.readArrayList(cl);
+java.util.Map _arg1;
+_arg1 = new java.util.Map();
+java.util.List _result = this.both(_arg0, _arg1);
+reply.writeNoException();
+reply.writeList(_result);
+reply.writeMap(_arg1);
+return true;
+}
+private boolean onTransact$plain$(android.os.Parcel data, android.os.Parcel reply) throws android.os.RemoteException
+{
+data.enforceInterface(DESCRIPTOR);
+int _arg0;
+_arg0 = data.readInt();
+int _result = this.plain(_arg0);
+reply.writeNoException();
+reply.writeInt(_result);
+return true;
+}
+private static class Proxy implements android.test.IClassLoaders
+{
+private android.os.IBinder mRemote;
+Proxy(android.os.IBinder remote)
+{
+mRemote = remote;
+}
+@Override public android.os.IBinder asBinder()
+{
+return mRemote;
+}
+public java.lang.String getInterfaceDescriptor()
+{
+return DESCRIPTOR;
+}
+@Override public java.util.Map swap(java.util.Map m) throws android.os.RemoteException
+{
+android.os.Parcel _data = android.os.Parcel.obtain();
+android.os.Parcel _reply = android.os.Parcel.obtain();
+java.util.Map _result;
+try {
+_data.writeInterfaceToken(DESCRIPTOR);
+_data.writeMap(m);
+mRemote.transact(Stub.TRANSACTION_swap, _data, _reply, 0);
+_reply.readException();
+_result = _reply.readHashMap(cl);
+}
+finally {
+_reply.recycle();
+_data.recycle();
+}
+return _result;
+}
+@Override public java.util.Map fresh(int x) throws android.os.RemoteException
+{
+android.os.Parcel _data = android.os.Parcel.obtain();
+android.os.Parcel _reply = android.os.Parcel.obtain();
+java.util.Map _result;
+try {
+_data.writeInterfaceToken(DESCRIPTOR);
+_data.writeInt(x);
+mRemote.transact(Stub.TRANSACTION_fresh, _data, _reply, 0);
+_reply.readException();
+java.lang.ClassLoader cl = (java.lang.ClassLoader)this.getClass().getClassLoader();
+_result = _reply.readHashMap(cl);
+}
+finally {
+_reply.recycle();
+_data.recycle();
+}
+return _result;
+}
+@Override public void fill(java.util.List l) throws android.os.RemoteException
+{
+android.os.Parcel _data = android.os.Parcel.obtain();
+android.os.Parcel _reply = android.os.Parcel.obtain();
+try {
+_data.writeInterfaceToken(DESCRIPTOR);
+mRemote.transact(Stub.TRANSACTION_fill, _data, _reply, 0);
+_reply.readException();
+java.lang.ClassLoader cl = (java.lang.ClassLoader)this.getClass().getClassLoader();
+_reply.readList(l, cl);
+}
+finally {
+_reply.recycle();
+_data.recycle();
+}
+}
+@Override public java.util.List both(java.util.List a, java.util.Map b) throws android.os.RemoteException
+{
+android.os.Parcel _data = android.os.Parcel.obtain();
+android.os.Parcel _reply = android.os.Parcel.obtain();
+java.util.List _result;
+try {
+_data.writeInterfaceToken(DESCRIPTOR);
+_data.writeList(a);
+mRemote.transact(Stub.TRANSACTION_both, _data, _reply, 0);
+_reply.readException();
+_result = _reply.readArrayList(cl);
+_reply.readMap(b, cl);
+}
+finally {
+_reply.recycle();
+_data.recycle();
+}
+return _result;
+}
+@Override public int plain(int a) throws android.os.RemoteException
+{
+android.os.Parcel _data = android.os.Parcel.obtain();
+android.os.Parcel _reply = android.os.Parcel.obtain();
+int _result;
+try {
+_data.writeInterfaceToken(DESCRIPTOR);
+_data.writeInt(a);
+mRemote.transact(Stub.TRANSACTION_plain, _data, _reply, 0);
+_reply.readException();
+_result = _reply.readInt();
+}
+finally {
+_reply.recycle();
+_data.recycle();
+}
+return _result;
+}
+}
+static final int TRANSACTION_swap = (android.os.IBinder.FIRST_CALL_TRANSACTION + 0);
+static final int TRANSACTION_fresh = (android.os.IBinder.FIRST_CALL_TRANSACTION + 1);
+static final int TRANSACTION_fill = (android.os.IBinder.FIRST_CALL_TRANSACTION + 2);
+static final int TRANSACTION_both = (android.os.IBinder.FIRST_CALL_TRANSACTION + 3);
+static final int TRANSACTION_plain = (android.os.IBinder.FIRST_CALL_TRANSACTION + 4);
+}
+public java.util.Map swap(java.util.Map m) throws android.os.RemoteException;
+public java.util.Map fresh(int x) throws android.os.RemoteException;
+public void fill(java.util.List l) throws android.os.RemoteException;
+public java.util.List both(java.util.List a, java.util.Map b) throws android.os.RemoteException;
+public int plain(int a) throws android.os.RemoteException;
+}
+)";
+
+}  // namespace test_data
+}  // namespace aidl
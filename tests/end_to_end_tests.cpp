@@ -14,6 +14,7 @@
  * limitations under the License.
  */
 
+#include <algorithm>
 #include <memory>
 #include <string>
 #include <vector>
@@ -50,6 +51,117 @@ namespace {
 
 const char kDiffTemplate[] = "diff -u %s %s";
 
+// The proxy method of generated |java| whose signature starts with
+// |return_type_and_name|, or "" if there is none.
+string ProxyMethod(const string& java, const string& return_type_and_name) {
+  const size_t start =
+      java.find("@Override public " + return_type_and_name + "(");
+  if (start == string::npos) {
+    return "";
+  }
+  const size_t next_method = java.find("\n@Override ", start);
+  // The last proxy method is followed by the end of the proxy class.
+  const size_t end_of_proxy =
+      java.find("\n}\nstatic final int TRANSACTION_", start);
+  return java.substr(start, std::min(next_method, end_of_proxy) - start);
+}
+
+const char kPingResponderPath[] = "android/test/IPingResponder.aidl";
+const char kPingResponderContents[] =
+R"(package android.test;
+import android.test.PingParcelable;
+interface IPingResponder {
+  int Ping(int token);
+})";
+
+// PingParcelable is imported but never used, so it is never read and does
+// not show up as a dependency.
+const char kPingResponderCppDeps[] =
+R"(out/BpPingResponder.cpp out/BpPingResponder.h out/BnPingResponder.cpp out/BnPingResponder.h out/IPingResponder.cpp out/IPingResponder.h: \
+  android/test/IPingResponder.aidl
+
+android/test/IPingResponder.aidl :
+)";
+
+// Compiling both languages at once lists every output in one file.
+const char kPingResponderJavaAndCppDeps[] =
+R"(out/IPingResponder.java out/BpPingResponder.cpp out/BpPingResponder.h out/BnPingResponder.cpp out/BnPingResponder.h out/IPingResponder.cpp out/IPingResponder.h: \
+  android/test/IPingResponder.aidl 
+
+android/test/IPingResponder.aidl :
+)";
+
+const char kUnusedImportPath[] = "android/test/IUnusedImport.aidl";
+const char kUnusedImportContents[] =
+R"(package android.test;
+import android.test.Missing;
+import android.test.Used;
+interface IUnusedImport {
+  void f(in Used u);
+})";
+
+const char kUnusedImportDeps[] =
+R"(out/IUnusedImport.java: \
+  android/test/IUnusedImport.aidl \
+  ./android/test/Used.aidl
+
+android/test/IUnusedImport.aidl :
+./android/test/Used.aidl :
+)";
+
+// Types.aidl declares a type named after the file plus two others, and
+// IGrouped.aidl declares a parcelable of its own next to the interface.
+const char kGroupedTypesPath[] = "android/test/Types.aidl";
+const char kGroupedTypesContents[] =
+R"(package android.test;
+parcelable Types;
+parcelable Point;
+interface ICallback {
+  void done();
+})";
+
+const char kGroupedTypesDeps[] =
+    "out/Types.java out/ICallback.java: \\\n"
+    "  android/test/Types.aidl \n"
+    "\n"
+    "android/test/Types.aidl :\n";
+
+// IPinger.aidl declares a second interface, which gets C++ of its own.
+const char kPingerPath[] = "android/test/IPinger.aidl";
+const char kPingerContents[] =
+R"(package android.test;
+interface IPinger {
+  int Ping(int token);
+}
+interface IPingListener {
+  int onPing(int token);
+})";
+
+const char kPingerCppDeps[] =
+R"(out/BpPinger.cpp out/BpPinger.h out/BnPinger.cpp out/BnPinger.h out/IPinger.cpp out/IPinger.h out/BpPingListener.cpp out/BpPingListener.h out/BnPingListener.cpp out/BnPingListener.h out/IPingListener.cpp out/IPingListener.h: \
+  android/test/IPinger.aidl
+
+android/test/IPinger.aidl :
+)";
+
+const char kGroupedPath[] = "android/test/IGrouped.aidl";
+const char kGroupedContents[] =
+R"(package android.test;
+import android.test.Types;
+parcelable Local;
+interface IGrouped {
+  void f(in Point p, ICallback c, in Local l);
+})";
+
+const char kGroupedDeps[] =
+R"(out/IGrouped.java: \
+  android/test/IGrouped.aidl \
+  ./android/test/Types.aidl
+
+android/test/IGrouped.aidl :
+./android/test/Types.aidl :
+)";
+
 }  // namespace
 
 class EndToEndTest : public ::testing::Test {
@@ -80,8 +192,9 @@ class EndToEndTest : public ::testing::Test {
                          const string& expected_content) {
     string actual_contents;
     FilePath actual_path = outputDir_.Append(rel_path);
-    if (!ReadFileToString(actual_path, &actual_contents)) {
-      FAIL() << "Failed to read expected output file: " << rel_path.value();
+    if (!io_delegate_.GetWrittenContents(actual_path.value(),
+                                         &actual_contents)) {
+      FAIL() << "Expected output file was not written: " << rel_path.value();
     }
 
     if (actual_contents != expected_content) {
@@ -91,6 +204,9 @@ class EndToEndTest : public ::testing::Test {
       EXPECT_TRUE(CreateTemporaryFileInDir(tmpDir_, &expected_path));
       WriteFile(expected_path, expected_content.c_str(),
                 expected_content.length());
+      EXPECT_TRUE(CreateTemporaryFileInDir(tmpDir_, &actual_path));
+      WriteFile(actual_path, actual_contents.c_str(),
+                actual_contents.length());
       const size_t buf_len =
           strlen(kDiffTemplate) + actual_path.value().length() +
           expected_path.value().length() + 1;
@@ -104,12 +220,12 @@ class EndToEndTest : public ::testing::Test {
     }
   }
 
+  FakeIoDelegate io_delegate_;
   FilePath tmpDir_;
   FilePath outputDir_;
 };
 
 TEST_F(EndToEndTest, IExampleInterface) {
-  FakeIoDelegate io_delegate;
   JavaOptions options;
   options.fail_on_parcelable_ = true;
   options.import_paths_.push_back("");
@@ -121,19 +237,565 @@ TEST_F(EndToEndTest, IExampleInterface) {
   options.dep_file_name_ = outputDir_.Append(FilePath("test.d")).value();
 
   // Load up our fake file system with data.
-  io_delegate.SetFileContents(options.input_file_name_,
-                              kIExampleInterfaceContents);
-  io_delegate.AddCompoundParcelable("android.test.CompoundParcelable", 
-                                    {"Subclass1", "Subclass2"});
+  io_delegate_.SetFileContents(options.input_file_name_,
+                               kIExampleInterfaceContents);
+  io_delegate_.AddCompoundParcelable("android.test.CompoundParcelable",
+                                     {"Subclass1", "Subclass2"});
   AddStubAidls(kIExampleInterfaceParcelables, kIExampleInterfaceInterfaces,
-               &io_delegate);
+               &io_delegate_);
 
   // Check that we parse correctly.
-  EXPECT_EQ(android::aidl::compile_aidl_to_java(options, io_delegate), 0);
+  EXPECT_EQ(android::aidl::compile_aidl_to_java(options, io_delegate_), 0);
   CheckFileContents(CanonicalNameToPath(kIExampleInterfaceClass, ".java"),
                     kIExampleInterfaceJava);
   CheckFileContents(FilePath("test.d"), kIExampleInterfaceDeps);
 }
 
+TEST_F(EndToEndTest, IPrimitiveLists) {
+  JavaOptions options;
+  options.import_paths_.push_back("");
+  options.input_file_name_ =
+      CanonicalNameToPath(kIPrimitiveListsClass, ".aidl").value();
+  options.output_file_name_for_deps_test_ =
+      CanonicalNameToPath(kIPrimitiveListsClass, ".java").value();
+  options.output_base_folder_ = outputDir_.value();
+
+  io_delegate_.SetFileContents(options.input_file_name_,
+                               kIPrimitiveListsContents);
+
+  EXPECT_EQ(android::aidl::compile_aidl_to_java(options, io_delegate_), 0);
+  CheckFileContents(CanonicalNameToPath(kIPrimitiveListsClass, ".java"),
+                    kIPrimitiveListsJava);
+}
+
+TEST_F(EndToEndTest, IClassLoaders) {
+  JavaOptions options;
+  options.import_paths_.push_back("");
+  options.input_file_name_ =
+      CanonicalNameToPath(kIClassLoadersClass, ".aidl").value();
+  options.output_file_name_for_deps_test_ =
+      CanonicalNameToPath(kIClassLoadersClass, ".java").value();
+  options.output_base_folder_ = outputDir_.value();
+
+  io_delegate_.SetFileContents(options.input_file_name_,
+                               kIClassLoadersContents);
+
+  EXPECT_EQ(android::aidl::compile_aidl_to_java(options, io_delegate_), 0);
+  CheckFileContents(CanonicalNameToPath(kIClassLoadersClass, ".java"),
+                    kIClassLoadersJava);
+}
+
+TEST_F(EndToEndTest, HandsOffClassLoadersInLargeInterfaces) {
+  // The methods of IClassLoaders, many times over.  Each method's code is
+  // built while it is written, and each proxy method is told separately
+  // whether its transaction helper declared a class loader, so every copy
+  // must come out like the original.
+  const int kCopies = 200;
+  const char* kMethods[][2] = {
+      {"Map swap%d(in Map m);", "java.util.Map swap"},
+      {"Map fresh%d(int x);", "java.util.Map fresh"},
+      {"void fill%d(out List l);", "void fill"},
+      {"List both%d(in List a, out Map b);", "java.util.List both"},
+      {"int plain%d(int a);", "int plain"},
+  };
+  string contents = "package android.test;\ninterface IClassLoaders {\n";
+  for (int i = 0; i < kCopies; ++i) {
+    for (const auto& method : kMethods) {
+      StringAppendF(&contents, "    ");
+      StringAppendF(&contents, method[0], i);
+      StringAppendF(&contents, "\n");
+    }
+  }
+  contents += "}\n";
+  const char* argv[] = {
+      "aidl", "-I.", "android/test/IClassLoaders.aidl", "out/IClassLoaders.java",
+  };
+  unique_ptr<JavaOptions> options = JavaOptions::Parse(arraysize(argv), argv);
+  ASSERT_NE(options, nullptr);
+  io_delegate_.SetFileContents("android/test/IClassLoaders.aidl", contents);
+
+  EXPECT_EQ(android::aidl::compile_aidl_to_java(*options, io_delegate_), 0);
+  string java;
+  ASSERT_TRUE(io_delegate_.GetWrittenContents("out/IClassLoaders.java",
+                                              &java));
+  for (const auto& method : kMethods) {
+    const string name = string(method[1]).substr(
+        string(method[1]).rfind(' ') + 1);
+    const string expected = ProxyMethod(kIClassLoadersJava, method[1]);
+    ASSERT_FALSE(expected.empty()) << method[1];
+    for (int i = 0; i < kCopies; ++i) {
+      const string suffix = std::to_string(i);
+      string renamed = expected;
+      for (size_t pos = renamed.find(name); pos != string::npos;
+           pos = renamed.find(name, pos + name.size() + suffix.size())) {
+        renamed.insert(pos + name.size(), suffix);
+      }
+      EXPECT_EQ(renamed, ProxyMethod(java, method[1] + suffix))
+          << method[1] << suffix;
+    }
+  }
+}
+
+TEST_F(EndToEndTest, CppDependencyFile) {
+  const char* argv[] = {
+      "aidl-cpp", "-I", "-dout/IPingResponder.d", kPingResponderPath, "out",
+  };
+  unique_ptr<CppOptions> options = CppOptions::Parse(arraysize(argv), argv);
+  ASSERT_NE(options, nullptr);
+
+  io_delegate_.SetFileContents(kPingResponderPath, kPingResponderContents);
+  io_delegate_.AddStubParcelable("android.test.PingParcelable");
+
+  EXPECT_EQ(android::aidl::compile_aidl_to_cpp(*options, io_delegate_), 0);
+  string actual_deps;
+  ASSERT_TRUE(io_delegate_.GetWrittenContents("out/IPingResponder.d",
+                                              &actual_deps));
+  EXPECT_EQ(kPingResponderCppDeps, actual_deps);
+  EXPECT_TRUE(io_delegate_.GetWrittenContents("out/BpPingResponder.cpp",
+                                              nullptr));
+}
+
+TEST_F(EndToEndTest, CompilesJavaAndCppTogether) {
+  io_delegate_.SetFileContents(kPingResponderPath, kPingResponderContents);
+  io_delegate_.AddStubParcelable("android.test.PingParcelable");
+  const vector<string> outputs = {
+      "out/IPingResponder.java",
+      "out/BpPingResponder.cpp", "out/BpPingResponder.h",
+      "out/BnPingResponder.cpp", "out/BnPingResponder.h",
+      "out/IPingResponder.cpp", "out/IPingResponder.h",
+  };
+
+  // Compile each language on its own first.
+  const char* java_argv[] = {
+      "aidl", "-I.", kPingResponderPath, "out/IPingResponder.java",
+  };
+  unique_ptr<JavaOptions> java_options =
+      JavaOptions::Parse(arraysize(java_argv), java_argv);
+  ASSERT_NE(java_options, nullptr);
+  EXPECT_EQ(android::aidl::compile_aidl_to_java(*java_options, io_delegate_),
+            0);
+  const char* cpp_argv[] = {
+      "aidl-cpp", "-I.", kPingResponderPath, "out",
+  };
+  unique_ptr<CppOptions> cpp_options =
+      CppOptions::Parse(arraysize(cpp_argv), cpp_argv);
+  ASSERT_NE(cpp_options, nullptr);
+  EXPECT_EQ(android::aidl::compile_aidl_to_cpp(*cpp_options, io_delegate_), 0);
+  vector<string> expected(outputs.size());
+  for (size_t i = 0; i < outputs.size(); ++i) {
+    ASSERT_TRUE(io_delegate_.GetWrittenContents(outputs[i], &expected[i]))
+        << outputs[i];
+  }
+
+  // A single invocation writes the same files.
+  FakeIoDelegate combined_io_delegate;
+  combined_io_delegate.SetFileContents(kPingResponderPath,
+                                       kPingResponderContents);
+  combined_io_delegate.AddStubParcelable("android.test.PingParcelable");
+  const char* argv[] = {
+      "aidl", "-I.", "-dout/IPingResponder.d", "--cpp-out", "out",
+      kPingResponderPath, "out/IPingResponder.java",
+  };
+  unique_ptr<JavaOptions> options = JavaOptions::Parse(arraysize(argv), argv);
+  ASSERT_NE(options, nullptr);
+  EXPECT_EQ(android::aidl::compile_aidl_to_java_and_cpp(*options,
+                                                        combined_io_delegate),
+            0);
+  for (size_t i = 0; i < outputs.size(); ++i) {
+    string actual;
+    ASSERT_TRUE(combined_io_delegate.GetWrittenContents(outputs[i], &actual))
+        << outputs[i];
+    EXPECT_EQ(expected[i], actual) << outputs[i];
+  }
+  string actual_deps;
+  ASSERT_TRUE(combined_io_delegate.GetWrittenContents("out/IPingResponder.d",
+                                                      &actual_deps));
+  EXPECT_EQ(kPingResponderJavaAndCppDeps, actual_deps);
+}
+
+TEST_F(EndToEndTest, SkipsUnusedImports) {
+  const char* argv[] = {
+      "aidl", "-I.", "-dout/IUnusedImport.d", kUnusedImportPath,
+      "out/IUnusedImport.java",
+  };
+  unique_ptr<JavaOptions> options = JavaOptions::Parse(arraysize(argv), argv);
+  ASSERT_NE(options, nullptr);
+
+  // android.test.Missing does not exist anywhere, but nothing uses it.
+  io_delegate_.SetFileContents(kUnusedImportPath, kUnusedImportContents);
+  io_delegate_.AddStubParcelable("android.test.Used");
+
+  EXPECT_EQ(android::aidl::compile_aidl_to_java(*options, io_delegate_), 0);
+  string actual_deps;
+  ASSERT_TRUE(io_delegate_.GetWrittenContents("out/IUnusedImport.d",
+                                              &actual_deps));
+  EXPECT_EQ(kUnusedImportDeps, actual_deps);
+}
+
+TEST_F(EndToEndTest, ReadsImportsThatDeclareSeveralTypes) {
+  const char* argv[] = {
+      "aidl", "-I.", "-dout/IGrouped.d", kGroupedPath, "out/IGrouped.java",
+  };
+  unique_ptr<JavaOptions> options = JavaOptions::Parse(arraysize(argv), argv);
+  ASSERT_NE(options, nullptr);
+
+  // No signature names android.test.Types, but it is still read because
+  // nothing else declares Point or ICallback.
+  io_delegate_.SetFileContents(kGroupedTypesPath, kGroupedTypesContents);
+  io_delegate_.SetFileContents(kGroupedPath, kGroupedContents);
+
+  EXPECT_EQ(android::aidl::compile_aidl_to_java(*options, io_delegate_), 0);
+  string actual_deps;
+  ASSERT_TRUE(io_delegate_.GetWrittenContents("out/IGrouped.d",
+                                              &actual_deps));
+  EXPECT_EQ(kGroupedDeps, actual_deps);
+  EXPECT_TRUE(io_delegate_.GetWrittenContents("out/IGrouped.java", nullptr));
+}
+
+TEST_F(EndToEndTest, GeneratesJavaForEveryDeclaredInterface) {
+  io_delegate_.SetFileContents(kGroupedTypesPath, kGroupedTypesContents);
+
+  // Types.aidl is named after a parcelable, so its only interface is
+  // written next to the output file.
+  const char* java_argv[] = {
+      "aidl", "-I.", "-dout/Types.d", kGroupedTypesPath, "out/Types.java",
+  };
+  unique_ptr<JavaOptions> java_options =
+      JavaOptions::Parse(arraysize(java_argv), java_argv);
+  ASSERT_NE(java_options, nullptr);
+  EXPECT_EQ(android::aidl::compile_aidl_to_java(*java_options, io_delegate_),
+            0);
+  string java;
+  ASSERT_TRUE(io_delegate_.GetWrittenContents("out/ICallback.java", &java));
+  EXPECT_NE(java.find("public interface ICallback extends "
+                      "android.os.IInterface"),
+            string::npos);
+  EXPECT_NE(java.find("public void done() throws android.os.RemoteException"),
+            string::npos);
+  EXPECT_FALSE(io_delegate_.GetWrittenContents("out/Types.java", nullptr));
+  string deps;
+  ASSERT_TRUE(io_delegate_.GetWrittenContents("out/Types.d", &deps));
+  EXPECT_EQ(kGroupedTypesDeps, deps);
+}
+
+TEST_F(EndToEndTest, GeneratesCppForEveryDeclaredInterface) {
+  const char* argv[] = {
+      "aidl-cpp", "-I.", "-dout/IPinger.d", kPingerPath, "out",
+  };
+  unique_ptr<CppOptions> options = CppOptions::Parse(arraysize(argv), argv);
+  ASSERT_NE(options, nullptr);
+  io_delegate_.SetFileContents(kPingerPath, kPingerContents);
+
+  EXPECT_EQ(android::aidl::compile_aidl_to_cpp(*options, io_delegate_), 0);
+  string deps;
+  ASSERT_TRUE(io_delegate_.GetWrittenContents("out/IPinger.d", &deps));
+  EXPECT_EQ(kPingerCppDeps, deps);
+  string header;
+  ASSERT_TRUE(io_delegate_.GetWrittenContents("out/BpPingListener.h",
+                                              &header));
+  EXPECT_NE(header.find("class BpPingListener : public "
+                        "android::BpInterface<IPingListener>"),
+            string::npos);
+  string source;
+  ASSERT_TRUE(io_delegate_.GetWrittenContents("out/BnPingListener.cpp",
+                                              &source));
+  EXPECT_NE(source.find("BnPingListener::onTransact"), string::npos);
+  EXPECT_TRUE(io_delegate_.GetWrittenContents("out/BpPinger.h", nullptr));
+}
+
+TEST_F(EndToEndTest, InstrumentsTransactions) {
+  const char* argv[] = {
+      "aidl", "-I.", "--instrument-transactions", kPingResponderPath,
+      "out/IPingResponder.java",
+  };
+  unique_ptr<JavaOptions> options = JavaOptions::Parse(arraysize(argv), argv);
+  ASSERT_NE(options, nullptr);
+  io_delegate_.SetFileContents(kPingResponderPath, kPingResponderContents);
+
+  EXPECT_EQ(android::aidl::compile_aidl_to_java(*options, io_delegate_), 0);
+  string java;
+  ASSERT_TRUE(io_delegate_.GetWrittenContents("out/IPingResponder.java",
+                                              &java));
+  // Both sides of the transaction report to the listener.
+  EXPECT_NE(string::npos, java.find(
+      "reportTransaction(TRANSACTION_Ping, true, _start, data, reply);\n"
+      "return true;\n"));
+  EXPECT_NE(string::npos, java.find(
+      "mRemote.transact(Stub.TRANSACTION_Ping, _data, _reply, 0);\n"
+      "Stub.reportTransaction(Stub.TRANSACTION_Ping, false, _start, _data, "
+      "_reply);\n"));
+  EXPECT_NE(string::npos, java.find(
+      "public static void setTransactionListener("
+      "android.test.IPingResponder.Stub.TransactionListener listener)"));
+  EXPECT_NE(string::npos, java.find(
+      "case TRANSACTION_Ping:\n{\nreturn \"Ping\";\n}\n"));
+}
+
+TEST_F(EndToEndTest, BatchesOnewayCalls) {
+  const char kPath[] = "android/test/IProgress.aidl";
+  io_delegate_.SetFileContents(kPath,
+      "package android.test;\n"
+      "interface IProgress {\n"
+      "  @Batched oneway void progress(int percent);\n"
+      "  void done();\n"
+      "}\n");
+  const char* argv[] = {"aidl", "-I.", kPath, "out/IProgress.java"};
+  unique_ptr<JavaOptions> options = JavaOptions::Parse(arraysize(argv), argv);
+  ASSERT_NE(options, nullptr);
+
+  EXPECT_EQ(android::aidl::compile_aidl_to_java(*options, io_delegate_), 0);
+  string java;
+  ASSERT_TRUE(io_delegate_.GetWrittenContents("out/IProgress.java", &java));
+  // The proxy queues batched calls, and sends what it has queued before
+  // any other call.
+  EXPECT_NE(string::npos, java.find(
+      "_data.writeInt(percent);\n"
+      "this.enqueueBatchedCall(Stub.TRANSACTION_progress, _data);\n"));
+  EXPECT_NE(string::npos, java.find(
+      "this.flushBatch();\n"
+      "mRemote.transact(Stub.TRANSACTION_done, _data, _reply, 0);\n"));
+  EXPECT_NE(string::npos, java.find(
+      "mRemote.transact(Stub.BATCH_TRANSACTION, _batch, null, "
+      "android.os.IBinder.FLAG_ONEWAY);\n"));
+  EXPECT_NE(string::npos, java.find(
+      "implements android.test.IProgress, java.lang.Runnable\n"));
+  // The stub dispatches each call in the batch in turn.
+  EXPECT_NE(string::npos, java.find(
+      "switch (_code)\n{\n"
+      "case TRANSACTION_progress:\n{\n"
+      "this.onTransact$progress$(data, reply);\n"
+      "break;\n}\n"));
+  EXPECT_EQ(string::npos,
+            java.find("{\nthis.onTransact$done$(data, reply);\nbreak;"));
+}
+
+TEST_F(EndToEndTest, RejectsBatchedCallsThatReply) {
+  const char kPath[] = "android/test/IProgress.aidl";
+  io_delegate_.SetFileContents(kPath,
+      "package android.test;\n"
+      "interface IProgress {\n"
+      "  @Batched void progress(int percent);\n"
+      "}\n");
+  const char* argv[] = {"aidl", "-I.", kPath, "out/IProgress.java"};
+  unique_ptr<JavaOptions> options = JavaOptions::Parse(arraysize(argv), argv);
+  ASSERT_NE(options, nullptr);
+  EXPECT_NE(android::aidl::compile_aidl_to_java(*options, io_delegate_), 0);
+}
+
+TEST_F(EndToEndTest, UnmarshalsLazyArgumentsOnDemand) {
+  const char kPath[] = "android/test/IStore.aidl";
+  io_delegate_.SetFileContents(kPath,
+      "package android.test;\n"
+      "import android.test.Blob;\n"
+      "interface IStore {\n"
+      "  int put(@Lazy in Blob blob, int tag);\n"
+      "}\n");
+  io_delegate_.AddStubParcelable("android.test.Blob");
+  const char* argv[] = {"aidl", "-I.", kPath, "out/IStore.java"};
+  unique_ptr<JavaOptions> options = JavaOptions::Parse(arraysize(argv), argv);
+  ASSERT_NE(options, nullptr);
+
+  EXPECT_EQ(android::aidl::compile_aidl_to_java(*options, io_delegate_), 0);
+  string java;
+  ASSERT_TRUE(io_delegate_.GetWrittenContents("out/IStore.java", &java));
+  // The proxy writes the argument with its length.
+  EXPECT_NE(string::npos, java.find(
+      "Stub.LazyParcelable.write(_data, blob);\n_data.writeInt(tag);\n"));
+  // The stub wraps it, and it is only good for the length of the call.
+  EXPECT_NE(string::npos, java.find(
+      "LazyParcelable<android.test.Blob> _arg0 = new "
+      "LazyParcelable<android.test.Blob>(android.test.Blob.CREATOR, data);\n"));
+  EXPECT_NE(string::npos, java.find(
+      "try {\n_result = this.put(_arg0, _arg1);\n}\n"
+      "finally {\n_arg0.release();\n}\n"));
+  // Unless the service overrides it, the wrapped argument is unmarshalled
+  // before calling the declared method.
+  EXPECT_NE(string::npos, java.find(
+      "public int put(LazyParcelable<android.test.Blob> blob, int tag) "
+      "throws android.os.RemoteException\n"
+      "{\nreturn this.put(blob.get(), tag);\n}\n"));
+}
+
+TEST_F(EndToEndTest, RejectsLazyArgumentsThatAreNotParcelables) {
+  const char kPath[] = "android/test/IStore.aidl";
+  io_delegate_.SetFileContents(kPath,
+      "package android.test;\n"
+      "interface IStore {\n"
+      "  void put(@Lazy in String name);\n"
+      "}\n"
+      "interface IStoreListener {\n"
+      "  void onPut(in String name);\n"
+      "}\n");
+  const char* argv[] = {
+      "aidl", "-I.", "-dout/IStore.d", kPath, "out/IStore.java",
+  };
+  unique_ptr<JavaOptions> options = JavaOptions::Parse(arraysize(argv), argv);
+  ASSERT_NE(options, nullptr);
+  EXPECT_NE(android::aidl::compile_aidl_to_java(*options, io_delegate_), 0);
+  // The error is found before anything is written.
+  EXPECT_FALSE(io_delegate_.GetWrittenContents("out/IStore.d", nullptr));
+  EXPECT_FALSE(io_delegate_.GetWrittenContents("out/IStore.java", nullptr));
+  EXPECT_FALSE(io_delegate_.GetWrittenContents("out/IStoreListener.java",
+                                               nullptr));
+}
+
+TEST_F(EndToEndTest, SendsCompactInterfaceTokens) {
+  const char kPath[] = "android/test/IToken.aidl";
+  io_delegate_.SetFileContents(kPath,
+      "package android.test;\n"
+      "/** Docs. */\n"
+      "@CompactInterfaceToken\n"
+      "interface IToken {\n"
+      "  void f(int a);\n"
+      "}\n");
+  const char* argv[] = {"aidl", "-I.", kPath, "out/IToken.java"};
+  unique_ptr<JavaOptions> options = JavaOptions::Parse(arraysize(argv), argv);
+  ASSERT_NE(options, nullptr);
+
+  EXPECT_EQ(android::aidl::compile_aidl_to_java(*options, io_delegate_), 0);
+  string java;
+  ASSERT_TRUE(io_delegate_.GetWrittenContents("out/IToken.java", &java));
+  // The same hash as C++ sends for the descriptor.
+  EXPECT_NE(string::npos, java.find(
+      "private static final long DESCRIPTOR_HASH = 0xd65000e9c38c2f08L;\n"));
+  EXPECT_NE(string::npos, java.find(
+      "_data.writeLong(DESCRIPTOR_HASH);\n_data.writeInt(a);\n"));
+  EXPECT_NE(string::npos, java.find(
+      "private boolean onTransact$f$(android.os.Parcel data, "
+      "android.os.Parcel reply) throws android.os.RemoteException\n"
+      "{\nenforceDescriptorHash(data);\n"));
+  EXPECT_EQ(string::npos, java.find("writeInterfaceToken"));
+  EXPECT_EQ(string::npos, java.find("enforceInterface"));
+  // The full descriptor is still there for INTERFACE_TRANSACTION.
+  EXPECT_NE(string::npos, java.find("reply.writeString(DESCRIPTOR);\n"));
+  EXPECT_NE(string::npos, java.find("/** Docs. */\npublic interface IToken"));
+}
+
+TEST_F(EndToEndTest, DispatchesSparseTransactionCodesThroughTable) {
+  const char kPath[] = "android/test/ISparse.aidl";
+  io_delegate_.SetFileContents(kPath,
+      "package android.test;\n"
+      "interface ISparse {\n"
+      "  void a(int x) = 0;\n"
+      "  int b() = 1000;\n"
+      "  oneway void c() = 50000;\n"
+      "  void d(int y) = 99999;\n"
+      "}\n");
+  const char* argv[] = {"aidl", "-I.", kPath, "out/ISparse.java"};
+  unique_ptr<JavaOptions> options = JavaOptions::Parse(arraysize(argv), argv);
+  ASSERT_NE(options, nullptr);
+
+  EXPECT_EQ(android::aidl::compile_aidl_to_java(*options, io_delegate_), 0);
+  string java;
+  ASSERT_TRUE(io_delegate_.GetWrittenContents("out/ISparse.java", &java));
+  EXPECT_NE(string::npos, java.find(
+      "private static final int[] DISPATCH_DISPLACEMENTS = {0, 0, 0, 0};\n"
+      "private static final int[] DISPATCH_CODES = "
+      "{0, 1, 0, 50001, 100000, 1001};\n"));
+  EXPECT_NE(string::npos, java.find(
+      "{\nint _key = (code&0x7fffffff);\n"
+      "int _slot = (((_key%6)+DISPATCH_DISPLACEMENTS[(_key%4)])%6);\n"
+      "if ((DISPATCH_CODES[_slot]==code)) {\n"
+      "switch (_slot)\n{\n"
+      "case 1:\n{\nreturn this.onTransact$a$(data, reply);\n}\n"
+      "case 5:\n{\nreturn this.onTransact$b$(data, reply);\n}\n"
+      "case 3:\n{\nreturn this.onTransact$c$(data, reply);\n}\n"
+      "case 4:\n{\nreturn this.onTransact$d$(data, reply);\n}\n"
+      "}\n}\n"
+      "switch (code)\n{\ncase INTERFACE_TRANSACTION:\n"));
+  // The transaction codes themselves are unchanged.
+  EXPECT_NE(string::npos, java.find(
+      "static final int TRANSACTION_d = "
+      "(android.os.IBinder.FIRST_CALL_TRANSACTION + 99999);\n"));
+}
+
+TEST_F(EndToEndTest, MarshalsTypedMapsEntryByEntry) {
+  const char kPath[] = "android/test/IMaps.aidl";
+  io_delegate_.SetFileContents(kPath,
+      "package android.test;\n"
+      "interface IMaps {\n"
+      "  Map<String, Integer> counts(in Map<Long, String> names);\n"
+      "}\n");
+  const char* argv[] = {"aidl", "-I.", kPath, "out/IMaps.java"};
+  unique_ptr<JavaOptions> options = JavaOptions::Parse(arraysize(argv), argv);
+  ASSERT_NE(options, nullptr);
+
+  EXPECT_EQ(android::aidl::compile_aidl_to_java(*options, io_delegate_), 0);
+  string java;
+  ASSERT_TRUE(io_delegate_.GetWrittenContents("out/IMaps.java", &java));
+  EXPECT_NE(string::npos, java.find(
+      "_data.writeInt(names.size());\n"
+      "for (java.util.Map.Entry<java.lang.Long,java.lang.String> _entry : "
+      "names.entrySet()) {\n"
+      "java.lang.Long _key = _entry.getKey();\n"
+      "java.lang.String _value = _entry.getValue();\n"
+      "if ((_key==null)) {\n_data.writeInt(0);\n}\n"
+      "else {\n_data.writeInt(1);\n_data.writeLong(_key);\n}\n"
+      "_data.writeString(_value);\n"
+      "}\n"));
+  // The capacity is bounded however big a size the other side sends.
+  EXPECT_NE(string::npos, java.find(
+      "_arg0 = new java.util.HashMap<java.lang.Long,java.lang.String>"
+      "((((java.lang.Math.min(_size, 65536)*4)/3)+1));\n"
+      "while ((_size>0)) {\n"
+      "java.lang.Long _key;\n"
+      "if ((0!=data.readInt())) {\n_key = data.readLong();\n}\n"
+      "else {\n_key = null;\n}\n"
+      "java.lang.String _value;\n_value = data.readString();\n"
+      "_arg0.put(_key, _value);\n"
+      "_size--;\n"
+      "}\n"));
+  // Null values are marked rather than unboxed.
+  EXPECT_NE(string::npos, java.find(
+      "java.lang.Integer _value = _entry.getValue();\n"
+      "reply.writeString(_key);\n"
+      "if ((_value==null)) {\nreply.writeInt(0);\n}\n"
+      "else {\nreply.writeInt(1);\nreply.writeInt(_value);\n}\n"));
+  // Neither side needs a class loader, or tags the entries' types.
+  EXPECT_EQ(string::npos, java.find("getClassLoader"));
+  EXPECT_EQ(string::npos, java.find("writeMap"));
+  EXPECT_EQ(string::npos, java.find("readHashMap"));
+}
+
+TEST_F(EndToEndTest, ReportsImportErrorsInDeclarationOrder) {
+  // Enough imports that they are loaded on several threads.
+  const int kNumImports = 32;
+  string contents = "package android.test;\n";
+  string methods;
+  for (int i = 0; i < kNumImports; ++i) {
+    const string name = StringPrintf("P%d", i);
+    StringAppendF(&contents, "import android.test.%s;\n", name.c_str());
+    StringAppendF(&methods, "  void f%d(in %s p);\n", i, name.c_str());
+    if (i % 3 == 0) {
+      io_delegate_.SetFileContents(
+          StringPrintf("android/test/%s.aidl", name.c_str()),
+          "package android.test;\nparcelable ;\n");
+    } else {
+      io_delegate_.AddStubParcelable("android.test." + name);
+    }
+  }
+  contents += "interface IMany {\n" + methods + "}\n";
+  io_delegate_.SetFileContents("android/test/IMany.aidl", contents);
+
+  const char* argv[] = {
+      "aidl", "-I.", "android/test/IMany.aidl", "out/IMany.java",
+  };
+  unique_ptr<JavaOptions> options = JavaOptions::Parse(arraysize(argv), argv);
+  ASSERT_NE(options, nullptr);
+
+  EXPECT_NE(android::aidl::compile_aidl_to_java(*options, io_delegate_), 0);
+  EXPECT_FALSE(io_delegate_.GetWrittenContents("out/IMany.java", nullptr));
+
+  // The broken imports are parsed on several threads, but reported in the
+  // order they were declared.
+  string expected;
+  for (int i = 0; i < kNumImports; i += 3) {
+    StringAppendF(&expected,
+                  "./android/test/P%d.aidl:2 syntax error in parcelable "
+                  "declaration. Expected type name.\n", i);
+  }
+  EXPECT_EQ(expected, io_delegate_.GetReportedDiagnostics());
+}
+
 }  // namespace android
 }  // namespace aidl
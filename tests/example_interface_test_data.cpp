@@ -124,13 +124,52 @@ return true;
 }
 case TRANSACTION_isEnabled:
 {
+return this.onTransact$isEnabled$(data, reply);
+}
+case TRANSACTION_getState:
+{
+return this.onTransact$getState$(data, reply);
+}
+case TRANSACTION_getAddress:
+{
+return this.onTransact$getAddress$(data, reply);
+}
+case TRANSACTION_getParcelables:
+{
+return this.onTransact$getParcelables$(data, reply);
+}
+case TRANSACTION_setScanMode:
+{
+return this.onTransact$setScanMode$(data, reply);
+}
+case TRANSACTION_registerBinder:
+{
+return this.onTransact$registerBinder$(data, reply);
+}
+case TRANSACTION_getRecursiveBinder:
+{
+return this.onTransact$getRecursiveBinder$(data, reply);
+}
+case TRANSACTION_takesAnInterface:
+{
+return this.onTransact$takesAnInterface$(data, reply);
+}
+case TRANSACTION_takesAParcelable:
+{
+return this.onTransact$takesAParcelable$(data, reply);
+}
+}
+return super.onTransact(code, data, reply, flags);
+}
+private boolean onTransact$isEnabled$(android.os.Parcel data, android.os.Parcel reply) throws android.os.RemoteException
+{
 data.enforceInterface(DESCRIPTOR);
 boolean _result = this.isEnabled();
 reply.writeNoException();
 reply.writeInt(((_result)?(1):(0)));
 return true;
 }
-case TRANSACTION_getState:
+private boolean onTransact$getState$(android.os.Parcel data, android.os.Parcel reply) throws android.os.RemoteException
 {
 data.enforceInterface(DESCRIPTOR);
 int _result = this.getState();
@@ -138,7 +177,7 @@ reply.writeNoException();
 reply.writeInt(_result);
 return true;
 }
-case TRANSACTION_getAddress:
+private boolean onTransact$getAddress$(android.os.Parcel data, android.os.Parcel reply) throws android.os.RemoteException
 {
 data.enforceInterface(DESCRIPTOR);
 java.lang.String _result = this.getAddress();
@@ -146,7 +185,7 @@ reply.writeNoException();
 reply.writeString(_result);
 return true;
 }
-case TRANSACTION_getParcelables:
+private boolean onTransact$getParcelables$(android.os.Parcel data, android.os.Parcel reply) throws android.os.RemoteException
 {
 data.enforceInterface(DESCRIPTOR);
 android.foo.ExampleParcelable[] _result = this.getParcelables();
@@ -154,7 +193,7 @@ reply.writeNoException();
 reply.writeTypedArray(_result, android.os.Parcelable.PARCELABLE_WRITE_RETURN_VALUE);
 return true;
 }
-case TRANSACTION_setScanMode:
+private boolean onTransact$setScanMode$(android.os.Parcel data, android.os.Parcel reply) throws android.os.RemoteException
 {
 data.enforceInterface(DESCRIPTOR);
 int _arg0;
@@ -166,7 +205,7 @@ reply.writeNoException();
 reply.writeInt(((_result)?(1):(0)));
 return true;
 }
-case TRANSACTION_registerBinder:
+private boolean onTransact$registerBinder$(android.os.Parcel data, android.os.Parcel reply) throws android.os.RemoteException
 {
 data.enforceInterface(DESCRIPTOR);
 android.bar.IAuxInterface _arg0;
@@ -175,7 +214,7 @@ this.registerBinder(_arg0);
 reply.writeNoException();
 return true;
 }
-case TRANSACTION_getRecursiveBinder:
+private boolean onTransact$getRecursiveBinder$(android.os.Parcel data, android.os.Parcel reply) throws android.os.RemoteException
 {
 data.enforceInterface(DESCRIPTOR);
 android.test.IExampleInterface _result = this.getRecursiveBinder();
@@ -183,7 +222,7 @@ reply.writeNoException();
 reply.writeStrongBinder((((_result!=null))?(_result.asBinder()):(null)));
 return true;
 }
-case TRANSACTION_takesAnInterface:
+private boolean onTransact$takesAnInterface$(android.os.Parcel data, android.os.Parcel reply) throws android.os.RemoteException
 {
 data.enforceInterface(DESCRIPTOR);
 android.test.IAuxInterface2 _arg0;
@@ -193,7 +232,7 @@ reply.writeNoException();
 reply.writeInt(_result);
 return true;
 }
-case TRANSACTION_takesAParcelable:
+private boolean onTransact$takesAParcelable$(android.os.Parcel data, android.os.Parcel reply) throws android.os.RemoteException
 {
 data.enforceInterface(DESCRIPTOR);
 android.test.CompoundParcelable.Subclass1 _arg0;
@@ -222,9 +261,6 @@ reply.writeInt(0);
 }
 return true;
 }
-}
-return super.onTransact(code, data, reply, flags);
-}
 private static class Proxy implements android.test.IExampleInterface
 {
 private android.os.IBinder mRemote;
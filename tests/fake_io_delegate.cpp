@@ -53,6 +53,20 @@ bool FakeIoDelegate::FileIsReadable(const string& path) const {
   return file_contents_.find(CleanPath(path)) != file_contents_.end();
 }
 
+CodeWriterPtr FakeIoDelegate::GetCodeWriter(const string& file_path) const {
+  string* contents = new string;
+  written_file_contents_[file_path].reset(contents);
+  return GetStringWriter(contents);
+}
+
+void FakeIoDelegate::CreatePathForFile(const string& file_path) const {
+  // Fake files can be written anywhere.
+}
+
+void FakeIoDelegate::ReportDiagnostics(const string& diagnostics) const {
+  reported_diagnostics_ += diagnostics;
+}
+
 void FakeIoDelegate::SetFileContents(const string& filename,
                                      const string& contents) {
   file_contents_[filename] = contents;
@@ -89,6 +103,21 @@ void FakeIoDelegate::AddStub(const string& canonical_name,
       StringPrintf(format_str, package.c_str(), class_name.c_str()));
 }
 
+bool FakeIoDelegate::GetWrittenContents(const string& path, string* content) {
+  const auto it = written_file_contents_.find(path);
+  if (it == written_file_contents_.end()) {
+    return false;
+  }
+  if (content) {
+    *content = *it->second;
+  }
+  return true;
+}
+
+const string& FakeIoDelegate::GetReportedDiagnostics() const {
+  return reported_diagnostics_;
+}
+
 string FakeIoDelegate::CleanPath(const string& path) const {
   string clean_path = path;
   while (clean_path.length() >= 2 &&
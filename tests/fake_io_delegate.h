@@ -41,6 +41,9 @@ class FakeIoDelegate : public IoDelegate {
       const std::string& append_content_suffix = "") const override;
 
   bool FileIsReadable(const std::string& path) const override;
+  CodeWriterPtr GetCodeWriter(const std::string& file_path) const override;
+  void CreatePathForFile(const std::string& file_path) const override;
+  void ReportDiagnostics(const std::string& diagnostics) const override;
 
   void SetFileContents(const std::string& filename,
                        const std::string& contents);
@@ -49,12 +52,23 @@ class FakeIoDelegate : public IoDelegate {
   void AddCompoundParcelable(const std::string& canonical_name,
                              const std::vector<std::string>& subclasses);
 
+  // Returns true iff we've previously written to |path|.
+  // When we return true, we'll set *contents to the written string.
+  bool GetWrittenContents(const std::string& path, std::string* content);
+
+  // Everything passed to ReportDiagnostics() so far.
+  const std::string& GetReportedDiagnostics() const;
+
  private:
   void AddStub(const std::string& canonical_name, const char* format_str);
   // Remove leading "./" from |path|.
   std::string CleanPath(const std::string& path) const;
 
   std::map<std::string, std::string> file_contents_;
+  // Normally, writing to files would count as a side effect, but these are
+  // fake files, so we'll pretend that they're mutable.
+  mutable std::map<std::string, std::unique_ptr<std::string>> written_file_contents_;
+  mutable std::string reported_diagnostics_;
 
   DISALLOW_COPY_AND_ASSIGN(FakeIoDelegate);
 };  // class FakeIoDelegate
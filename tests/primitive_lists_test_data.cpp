@@ -0,0 +1,417 @@
+/*
+ * Copyright (C) 2015, The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "tests/test_data.h"
+
+namespace aidl {
+namespace test_data {
+
+const char kIPrimitiveListsClass[] = "android.test.IPrimitiveLists";
+
+const char kIPrimitiveListsContents[] = R"(
+package android.test;
+
+interface IPrimitiveLists {
+    List<Integer> reverse(in List<Integer> ints, out List<Long> longs);
+    void scale(inout List<Float> floats, in List<Double> doubles);
+    oneway void setFlags(in List<Boolean> flags);
+}
+)";
+
+const char kIPrimitiveListsJava[] =
+R"(/*
+ * This file is auto-generated.  DO NOT MODIFY.
+ * Original file: android/test/IPrimitiveLists.aidl
+ */
+package android.test;
+public interface IPrimitiveLists extends android.os.IInterface
+{
+/** Local-side IPC implementation stub class. */
+public static abstract class Stub extends android.os.Binder implements android.test.IPrimitiveLists
+{
+private static final java.lang.String DESCRIPTOR = "android.test.IPrimitiveLists";
+/** Construct the stub at attach it to the interface. */
+public Stub()
+{
+this.attachInterface(this, DESCRIPTOR);
+}
+/**
+ * Cast an IBinder object into an android.test.IPrimitiveLists interface,
+ * generating a proxy if needed.
+ */
+public static android.test.IPrimitiveLists asInterface(android.os.IBinder obj)
+{
+if ((obj==null)) {
+return null;
+}
+android.os.IInterface iin = obj.queryLocalInterface(DESCRIPTOR);
+if (((iin!=null)&&(iin instanceof android.test.IPrimitiveLists))) {
+return ((android.test.IPrimitiveLists)iin);
+}
+return new android.test.IPrimitiveLists.Stub.Proxy(obj);
+}
+@Override public android.os.IBinder asBinder()
+{
+return this;
+}
+@Override public boolean onTransact(int code, android.os.Parcel data, android.os.Parcel reply, int flags) throws android.os.RemoteException
+{
+switch (code)
+{
+case INTERFACE_TRANSACTION:
+{
+reply.writeString(DESCRIPTOR);
+return true;
+}
+case TRANSACTION_reverse:
+{
+return this.onTransact$reverse$(data, reply);
+}
+case TRANSACTION_scale:
+{
+return this.onTransact$scale$(data, reply);
+}
+case TRANSACTION_setFlags:
+{
+return this.onTransact$setFlags$(data, reply);
+}
+}
+return super.onTransact(code, data, reply, flags);
+}
+private boolean onTransact$reverse$(android.os.Parcel data, android.os.Parcel reply) throws android.os.RemoteException
+{
+data.enforceInterface(DESCRIPTOR);
+java.util.List<java.lang.Integer> _arg0;
+{
+int _size = data.readInt();
+if ((_size<0)) {
+_arg0 = null;
+}
+else {
+_arg0 = new java.util.ArrayList<java.lang.Integer>(java.lang.Math.min(_size, 65536));
+while ((_arg0.size()<_size)) {
+java.lang.Integer _item;
+if ((0!=data.readInt())) {
+_item = data.readInt();
+}
+else {
+_item = null;
+}
+_arg0.add(_item);
+}
+}
+}
+java.util.List<java.lang.Long> _arg1;
+_arg1 = new java.util.ArrayList<java.lang.Long>();
+java.util.List<java.lang.Integer> _result = this.reverse(_arg0, _arg1);
+reply.writeNoException();
+if ((_result==null)) {
+reply.writeInt(-1);
+}
+else {
+reply.writeInt(_result.size());
+for (java.lang.Integer _item : _result) {
+if ((_item==null)) {
+reply.writeInt(0);
+}
+else {
+reply.writeInt(1);
+reply.writeInt(_item);
+}
+}
+}
+if ((_arg1==null)) {
+reply.writeInt(-1);
+}
+else {
+reply.writeInt(_arg1.size());
+for (java.lang.Long _item : _arg1) {
+if ((_item==null)) {
+reply.writeInt(0);
+}
+else {
+reply.writeInt(1);
+reply.writeLong(_item);
+}
+}
+}
+return true;
+}
+private boolean onTransact$scale$(android.os.Parcel data, android.os.Parcel reply) throws android.os.RemoteException
+{
+data.enforceInterface(DESCRIPTOR);
+java.util.List<java.lang.Float> _arg0;
+{
+int _size = data.readInt();
+if ((_size<0)) {
+_arg0 = null;
+}
+else {
+_arg0 = new java.util.ArrayList<java.lang.Float>(java.lang.Math.min(_size, 65536));
+while ((_arg0.size()<_size)) {
+java.lang.Float _item;
+if ((0!=data.readInt())) {
+_item = data.readFloat();
+}
+else {
+_item = null;
+}
+_arg0.add(_item);
+}
+}
+}
+java.util.List<java.lang.Double> _arg1;
+{
+int _size = data.readInt();
+if ((_size<0)) {
+_arg1 = null;
+}
+else {
+_arg1 = new java.util.ArrayList<java.lang.Double>(java.lang.Math.min(_size, 65536));
+while ((_arg1.size()<_size)) {
+java.lang.Double _item;
+if ((0!=data.readInt())) {
+_item = data.readDouble();
+}
+else {
+_item = null;
+}
+_arg1.add(_item);
+}
+}
+}
+this.scale(_arg0, _arg1);
+reply.writeNoException();
+if ((_arg0==null)) {
+reply.writeInt(-1);
+}
+else {
+reply.writeInt(_arg0.size());
+for (java.lang.Float _item : _arg0) {
+if ((_item==null)) {
+reply.writeInt(0);
+}
+else {
+reply.writeInt(1);
+reply.writeFloat(_item);
+}
+}
+}
+return true;
+}
+private boolean onTransact$setFlags$(android.os.Parcel data, android.os.Parcel reply) throws android.os.RemoteException
+{
+data.enforceInterface(DESCRIPTOR);
+java.util.List<java.lang.Boolean> _arg0;
+{
+int _size = data.readInt();
+if ((_size<0)) {
+_arg0 = null;
+}
+else {
+_arg0 = new java.util.ArrayList<java.lang.Boolean>(java.lang.Math.min(_size, 65536));
+while ((_arg0.size()<_size)) {
+java.lang.Boolean _item;
+if ((0!=data.readInt())) {
+_item = (0!=data.readInt());
+}
+else {
+_item = null;
+}
+_arg0.add(_item);
+}
+}
+}
+this.setFlags(_arg0);
+return true;
+}
+private static class Proxy implements android.test.IPrimitiveLists
+{
+private android.os.IBinder mRemote;
+Proxy(android.os.IBinder remote)
+{
+mRemote = remote;
+}
+@Override public android.os.IBinder asBinder()
+{
+return mRemote;
+}
+public java.lang.String getInterfaceDescriptor()
+{
+return DESCRIPTOR;
+}
+@Override public java.util.List<java.lang.Integer> reverse(java.util.List<java.lang.Integer> ints, java.util.List<java.lang.Long> longs) throws android.os.RemoteException
+{
+android.os.Parcel _data = android.os.Parcel.obtain();
+android.os.Parcel _reply = android.os.Parcel.obtain();
+java.util.List<java.lang.Integer> _result;
+try {
+_data.writeInterfaceToken(DESCRIPTOR);
+if ((ints==null)) {
+_data.writeInt(-1);
+}
+else {
+_data.writeInt(ints.size());
+for (java.lang.Integer _item : ints) {
+if ((_item==null)) {
+_data.writeInt(0);
+}
+else {
+_data.writeInt(1);
+_data.writeInt(_item);
+}
+}
+}
+mRemote.transact(Stub.TRANSACTION_reverse, _data, _reply, 0);
+_reply.readException();
+{
+int _size = _reply.readInt();
+if ((_size<0)) {
+_result = null;
+}
+else {
+_result = new java.util.ArrayList<java.lang.Integer>(java.lang.Math.min(_size, 65536));
+while ((_result.size()<_size)) {
+java.lang.Integer _item;
+if ((0!=_reply.readInt())) {
+_item = _reply.readInt();
+}
+else {
+_item = null;
+}
+_result.add(_item);
+}
+}
+}
+{
+int _size = _reply.readInt();
+longs.clear();
+while ((longs.size()<_size)) {
+java.lang.Long _item;
+if ((0!=_reply.readInt())) {
+_item = _reply.readLong();
+}
+else {
+_item = null;
+}
+longs.add(_item);
+}
+}
+}
+finally {
+_reply.recycle();
+_data.recycle();
+}
+return _result;
+}
+@Override public void scale(java.util.List<java.lang.Float> floats, java.util.List<java.lang.Double> doubles) throws android.os.RemoteException
+{
+android.os.Parcel _data = android.os.Parcel.obtain();
+android.os.Parcel _reply = android.os.Parcel.obtain();
+try {
+_data.writeInterfaceToken(DESCRIPTOR);
+if ((floats==null)) {
+_data.writeInt(-1);
+}
+else {
+_data.writeInt(floats.size());
+for (java.lang.Float _item : floats) {
+if ((_item==null)) {
+_data.writeInt(0);
+}
+else {
+_data.writeInt(1);
+_data.writeFloat(_item);
+}
+}
+}
+if ((doubles==null)) {
+_data.writeInt(-1);
+}
+else {
+_data.writeInt(doubles.size());
+for (java.lang.Double _item : doubles) {
+if ((_item==null)) {
+_data.writeInt(0);
+}
+else {
+_data.writeInt(1);
+_data.writeDouble(_item);
+}
+}
+}
+mRemote.transact(Stub.TRANSACTION_scale, _data, _reply, 0);
+_reply.readException();
+{
+int _size = _reply.readInt();
+floats.clear();
+while ((floats.size()<_size)) {
+java.lang.Float _item;
+if ((0!=_reply.readInt())) {
+_item = _reply.readFloat();
+}
+else {
+_item = null;
+}
+floats.add(_item);
+}
+}
+}
+finally {
+_reply.recycle();
+_data.recycle();
+}
+}
+@Override public void setFlags(java.util.List<java.lang.Boolean> flags) throws android.os.RemoteException
+{
+android.os.Parcel _data = android.os.Parcel.obtain();
+try {
+_data.writeInterfaceToken(DESCRIPTOR);
+if ((flags==null)) {
+_data.writeInt(-1);
+}
+else {
+_data.writeInt(flags.size());
+for (java.lang.Boolean _item : flags) {
+if ((_item==null)) {
+_data.writeInt(0);
+}
+else {
+_data.writeInt(1);
+_data.writeInt(((_item)?(1):(0)));
+}
+}
+}
+mRemote.transact(Stub.TRANSACTION_setFlags, _data, null, android.os.IBinder.FLAG_ONEWAY);
+}
+finally {
+_data.recycle();
+}
+}
+}
+static final int TRANSACTION_reverse = (android.os.IBinder.FIRST_CALL_TRANSACTION + 0);
+static final int TRANSACTION_scale = (android.os.IBinder.FIRST_CALL_TRANSACTION + 1);
+static final int TRANSACTION_setFlags = (android.os.IBinder.FIRST_CALL_TRANSACTION + 2);
+}
+public java.util.List<java.lang.Integer> reverse(java.util.List<java.lang.Integer> ints, java.util.List<java.lang.Long> longs) throws android.os.RemoteException;
+public void scale(java.util.List<java.lang.Float> floats, java.util.List<java.lang.Double> doubles) throws android.os.RemoteException;
+public void setFlags(java.util.List<java.lang.Boolean> flags) throws android.os.RemoteException;
+}
+)";
+
+}  // namespace test_data
+}  // namespace aidl
@@ -0,0 +1,149 @@
+/*
+ * Copyright (C) 2015, The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <chrono>
+#include <memory>
+#include <string>
+
+#include <base/macros.h>
+#include <base/stringprintf.h>
+#include <gtest/gtest.h>
+
+#include "aidl.h"
+#include "aidl_language.h"
+#include "options.h"
+#include "tests/fake_io_delegate.h"
+#include "tests/synthetic_corpus.h"
+#include "type_java.h"
+
+using android::aidl::test::FakeIoDelegate;
+using android::aidl::test::MakeInterface;
+using android::aidl::test::MakeParcelables;
+using android::base::StringPrintf;
+using std::string;
+using std::unique_ptr;
+
+namespace android {
+namespace aidl {
+namespace {
+
+// These tests guard against work that grows quadratically with the number
+// of declarations in a file.  Each runs in a few seconds at most even in a
+// sanitizer build, so the budget only trips once something rescans all the
+// declarations seen so far for every new one.
+const int kNumDeclarations = 5000;
+const std::chrono::seconds kTimeBudget(10);
+
+const char kPackage[] = "android.scale";
+const char kInterfacePath[] = "android/scale/IScale.aidl";
+const char kParcelablesPath[] = "android/scale/Outer.aidl";
+
+class ScaleTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    start_ = std::chrono::steady_clock::now();
+  }
+
+  void TearDown() override {
+    EXPECT_LT(std::chrono::steady_clock::now() - start_, kTimeBudget);
+  }
+
+  FakeIoDelegate io_delegate_;
+
+ private:
+  std::chrono::steady_clock::time_point start_;
+};
+
+}  // namespace
+
+TEST_F(ScaleTest, CompilesLargeInterface) {
+  io_delegate_.SetFileContents(
+      kInterfacePath,
+      MakeInterface(kPackage, "IScale", kNumDeclarations, false, 1));
+  const char* java_argv[] = {
+      "aidl", "-I.", kInterfacePath, "out/IScale.java",
+  };
+  unique_ptr<JavaOptions> java_options =
+      JavaOptions::Parse(arraysize(java_argv), java_argv);
+  ASSERT_NE(java_options, nullptr);
+  EXPECT_EQ(compile_aidl_to_java(*java_options, io_delegate_), 0);
+
+  // The C++ backend only handles a subset of types, so it gets an interface
+  // of its own.
+  io_delegate_.SetFileContents(
+      kInterfacePath,
+      MakeInterface(kPackage, "IScale", kNumDeclarations, true, 1));
+  const char* cpp_argv[] = {
+      "aidl-cpp", "-I.", kInterfacePath, "out",
+  };
+  unique_ptr<CppOptions> cpp_options =
+      CppOptions::Parse(arraysize(cpp_argv), cpp_argv);
+  ASSERT_NE(cpp_options, nullptr);
+  EXPECT_EQ(compile_aidl_to_cpp(*cpp_options, io_delegate_), 0);
+  EXPECT_TRUE(io_delegate_.GetWrittenContents("out/BnScale.cpp", nullptr));
+}
+
+TEST_F(ScaleTest, CompilesLargeSparseInterface) {
+  // Ids spread over the whole range that can be set, so transactions are
+  // dispatched through a table.
+  string contents = "package android.scale;\ninterface IScale {\n";
+  for (int i = 0; i < kNumDeclarations; ++i) {
+    contents += StringPrintf("  int m%d(int a) = %d;\n", i, i * 3301 + i % 7);
+  }
+  contents += "}\n";
+  io_delegate_.SetFileContents(kInterfacePath, contents);
+  const char* java_argv[] = {
+      "aidl", "-I.", kInterfacePath, "out/IScale.java",
+  };
+  unique_ptr<JavaOptions> java_options =
+      JavaOptions::Parse(arraysize(java_argv), java_argv);
+  ASSERT_NE(java_options, nullptr);
+  EXPECT_EQ(compile_aidl_to_java(*java_options, io_delegate_), 0);
+  string java;
+  ASSERT_TRUE(io_delegate_.GetWrittenContents("out/IScale.java", &java));
+  EXPECT_NE(java.find("DISPATCH_CODES"), string::npos);
+
+  const char* cpp_argv[] = {
+      "aidl-cpp", "-I.", kInterfacePath, "out",
+  };
+  unique_ptr<CppOptions> cpp_options =
+      CppOptions::Parse(arraysize(cpp_argv), cpp_argv);
+  ASSERT_NE(cpp_options, nullptr);
+  EXPECT_EQ(compile_aidl_to_cpp(*cpp_options, io_delegate_), 0);
+  EXPECT_TRUE(io_delegate_.GetWrittenContents("out/BnScale.cpp", nullptr));
+}
+
+TEST_F(ScaleTest, LoadsLargeParcelableFile) {
+  io_delegate_.SetFileContents(
+      kParcelablesPath, MakeParcelables(kPackage, "Outer", kNumDeclarations));
+  Parser p{io_delegate_};
+  ASSERT_TRUE(p.ParseFile(kParcelablesPath));
+  unique_ptr<AidlDocument> doc(p.GetDocument());
+  ASSERT_NE(doc, nullptr);
+  ASSERT_EQ(static_cast<size_t>(kNumDeclarations),
+            doc->GetParcelables().size());
+
+  java::JavaTypeNamespace types;
+  for (size_t i = 0; i < doc->GetParcelables().size(); ++i) {
+    const AidlParcelable* parcelable = doc->GetParcelables()[i].get();
+    EXPECT_EQ("Outer.P" + std::to_string(i), parcelable->GetName());
+    EXPECT_TRUE(types.AddParcelableType(parcelable, kParcelablesPath));
+  }
+  EXPECT_NE(types.Find("android.scale.Outer.P4999"), nullptr);
+}
+
+}  // namespace aidl
+}  // namespace android
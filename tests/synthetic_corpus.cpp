@@ -0,0 +1,233 @@
+/*
+ * Copyright (C) 2015, The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tests/synthetic_corpus.h"
+
+#include <random>
+
+#include <base/stringprintf.h>
+
+#include "os.h"
+
+using android::base::StringAppendF;
+using android::base::StringPrintf;
+using std::string;
+using std::vector;
+
+namespace android {
+namespace aidl {
+namespace test {
+namespace {
+
+// Types that are always available, paired with whether they may be given
+// an explicit direction.
+struct BuiltinType {
+  const char* name;
+  bool directional;
+};
+
+const BuiltinType kBuiltinTypes[] = {
+  {"int", false},
+  {"long", false},
+  {"boolean", false},
+  {"String", false},
+  {"IBinder", false},
+  {"int[]", true},
+  {"String[]", true},
+  {"List<String>", true},
+  {"Map", true},
+};
+const size_t kNumBuiltinTypes = sizeof(kBuiltinTypes) / sizeof(kBuiltinTypes[0]);
+// The first few builtins are plain primitives, which every backend supports.
+const size_t kNumPrimitiveTypes = 2;
+const char* const kDirections[] = {"in", "out", "inout"};
+
+// std::minstd_rand is fully specified by the standard, unlike the
+// distributions, so we only ever take its raw output modulo some bound.
+class Random {
+ public:
+  explicit Random(uint32_t seed) : engine_(seed) {}
+  size_t Next(size_t bound) { return engine_() % bound; }
+
+ private:
+  std::minstd_rand engine_;
+};
+
+string PathFor(const string& package, const string& name) {
+  string path = package;
+  for (char& c : path) {
+    if (c == '.') {
+      c = OS_PATH_SEPARATOR;
+    }
+  }
+  return path + OS_PATH_SEPARATOR + name + ".aidl";
+}
+
+// |parcelables| and |interfaces| are the user defined types that methods
+// may refer to.  All of them must already be imported.  |allow_void| is
+// false for backends that cannot yet return void.
+string MakeMethods(int num_methods,
+                   size_t num_builtin_types,
+                   bool allow_void,
+                   const vector<string>& parcelables,
+                   const vector<string>& interfaces,
+                   Random* random) {
+  string methods;
+  for (int i = 0; i < num_methods; ++i) {
+    const size_t num_user_types = parcelables.size() + interfaces.size();
+    // Pick a return type, sometimes void.
+    size_t pick = random->Next(num_builtin_types + num_user_types +
+                               ((allow_void) ? 2 : 0));
+    string return_type;
+    if (pick < num_builtin_types) {
+      return_type = kBuiltinTypes[pick].name;
+    } else if (pick < num_builtin_types + parcelables.size()) {
+      return_type = parcelables[pick - num_builtin_types];
+    } else if (pick < num_builtin_types + num_user_types) {
+      return_type =
+          interfaces[pick - num_builtin_types - parcelables.size()];
+    } else {
+      return_type = "void";
+    }
+
+    vector<string> args;
+    const size_t num_args = random->Next(5);
+    for (size_t j = 0; j < num_args; ++j) {
+      pick = random->Next(num_builtin_types + num_user_types);
+      string arg;
+      if (pick < num_builtin_types) {
+        const BuiltinType& type = kBuiltinTypes[pick];
+        if (type.directional) {
+          arg = StringPrintf("%s ", kDirections[random->Next(3)]);
+        }
+        arg += type.name;
+      } else if (pick < num_builtin_types + parcelables.size()) {
+        arg = StringPrintf("%s %s", kDirections[random->Next(3)],
+                           parcelables[pick - num_builtin_types].c_str());
+      } else {
+        arg = interfaces[pick - num_builtin_types - parcelables.size()];
+      }
+      StringAppendF(&arg, " arg%zu", j);
+      args.push_back(arg);
+    }
+
+    StringAppendF(&methods, "  /** Synthetic method %d. */\n", i);
+    StringAppendF(&methods, "  %s method%d(", return_type.c_str(), i);
+    for (size_t j = 0; j < args.size(); ++j) {
+      StringAppendF(&methods, "%s%s", (j == 0) ? "" : ", ", args[j].c_str());
+    }
+    methods += ");\n";
+  }
+  return methods;
+}
+
+}  // namespace
+
+Corpus GenerateCorpus(const CorpusOptions& options,
+                      FakeIoDelegate* io_delegate) {
+  Corpus corpus;
+  Random random(options.seed);
+
+  vector<string> parcelable_names;
+  for (int i = 0; i < options.num_parcelables; ++i) {
+    const string name = StringPrintf("Parcelable%d", i);
+    const string path = PathFor(options.package, name);
+    io_delegate->SetFileContents(
+        path, StringPrintf("package %s;\n\nparcelable %s;\n",
+                           options.package.c_str(), name.c_str()));
+    parcelable_names.push_back(name);
+    corpus.parcelable_paths.push_back(path);
+  }
+
+  vector<string> interface_names;
+  for (int i = 0; i < options.num_interfaces; ++i) {
+    const string name = StringPrintf("IService%d", i);
+    string contents = StringPrintf("package %s;\n\n", options.package.c_str());
+
+    vector<string> parcelables;
+    if (!parcelable_names.empty()) {
+      for (int j = 0; j < options.parcelable_imports_per_interface &&
+                      j < static_cast<int>(parcelable_names.size()); ++j) {
+        const string& parcelable =
+            parcelable_names[(i + j) % parcelable_names.size()];
+        StringAppendF(&contents, "import %s.%s;\n",
+                      options.package.c_str(), parcelable.c_str());
+        parcelables.push_back(parcelable);
+      }
+    }
+    vector<string> interfaces;
+    for (int j = 1; j <= options.interface_imports_per_interface && j <= i;
+         ++j) {
+      const string& iface = interface_names[i - j];
+      StringAppendF(&contents, "import %s.%s;\n",
+                    options.package.c_str(), iface.c_str());
+      interfaces.push_back(iface);
+    }
+
+    StringAppendF(&contents, "\n/** Synthetic interface %d. */\n", i);
+    StringAppendF(&contents, "interface %s {\n", name.c_str());
+    contents += MakeMethods(options.methods_per_interface, kNumBuiltinTypes,
+                            true, parcelables, interfaces, &random);
+    contents += "}\n";
+
+    const string path = PathFor(options.package, name);
+    io_delegate->SetFileContents(path, contents);
+    interface_names.push_back(name);
+    corpus.interface_paths.push_back(path);
+  }
+
+  if (options.preprocessed_lines > 0) {
+    string contents;
+    for (int i = 0; i < options.preprocessed_lines; ++i) {
+      if (i % 2 == 0) {
+        StringAppendF(&contents, "parcelable %s.pre.Parcelable%d;\n",
+                      options.package.c_str(), i);
+      } else {
+        StringAppendF(&contents, "interface %s.pre.IService%d;\n",
+                      options.package.c_str(), i);
+      }
+    }
+    corpus.preprocessed_path = "synthetic.preprocessed.aidl";
+    io_delegate->SetFileContents(corpus.preprocessed_path, contents);
+  }
+
+  return corpus;
+}
+
+string MakeInterface(const string& package, const string& name,
+                     int num_methods, bool primitives_only, uint32_t seed) {
+  Random random(seed);
+  string contents = StringPrintf("package %s;\n\n", package.c_str());
+  StringAppendF(&contents, "interface %s {\n", name.c_str());
+  contents += MakeMethods(
+      num_methods, (primitives_only) ? kNumPrimitiveTypes : kNumBuiltinTypes,
+      !primitives_only, {}, {}, &random);
+  contents += "}\n";
+  return contents;
+}
+
+string MakeParcelables(const string& package, const string& base_name,
+                       int count) {
+  string contents = StringPrintf("package %s;\n\n", package.c_str());
+  for (int i = 0; i < count; ++i) {
+    StringAppendF(&contents, "parcelable %s.P%d;\n", base_name.c_str(), i);
+  }
+  return contents;
+}
+
+}  // namespace test
+}  // namespace aidl
+}  // namespace android
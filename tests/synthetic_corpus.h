@@ -0,0 +1,78 @@
+/*
+ * Copyright (C) 2015, The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef AIDL_TESTS_SYNTHETIC_CORPUS_H_
+#define AIDL_TESTS_SYNTHETIC_CORPUS_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "tests/fake_io_delegate.h"
+
+namespace android {
+namespace aidl {
+namespace test {
+
+// Describes a synthetic tree of .aidl files.  The same options (including
+// |seed|) always produce byte-identical files.
+struct CorpusOptions {
+  std::string package = "android.synthetic";
+  int num_interfaces = 1;
+  int methods_per_interface = 10;
+  int num_parcelables = 8;
+  // Number of parcelables each interface imports.
+  int parcelable_imports_per_interface = 4;
+  // Each interface imports up to this many of the interfaces generated
+  // before it, which gives deep, overlapping import chains.
+  int interface_imports_per_interface = 0;
+  // Number of lines in a generated preprocessed file, or 0 for none.
+  int preprocessed_lines = 0;
+  uint32_t seed = 1;
+};
+
+struct Corpus {
+  // Relative paths of the generated interfaces, in generation order.
+  std::vector<std::string> interface_paths;
+  std::vector<std::string> parcelable_paths;
+  // Path of the generated preprocessed file, or empty.
+  std::string preprocessed_path;
+};
+
+// Write the tree described by |options| into |io_delegate|.
+Corpus GenerateCorpus(const CorpusOptions& options,
+                      FakeIoDelegate* io_delegate);
+
+// Returns the source of a single interface with |num_methods| methods that
+// only uses built in types.  If |primitives_only| is set, the methods stick
+// to types (and non-void returns) that every backend supports.
+std::string MakeInterface(const std::string& package,
+                          const std::string& name,
+                          int num_methods,
+                          bool primitives_only,
+                          uint32_t seed);
+
+// Returns the source of a single file declaring |count| parcelables named
+// <base_name>.P0 through <base_name>.P<count - 1>.
+std::string MakeParcelables(const std::string& package,
+                            const std::string& base_name,
+                            int count);
+
+}  // namespace test
+}  // namespace aidl
+}  // namespace android
+
+#endif  // AIDL_TESTS_SYNTHETIC_CORPUS_H_
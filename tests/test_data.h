@@ -28,6 +28,14 @@ extern const char* kIExampleInterfaceInterfaces[];
 extern const char kIExampleInterfaceDeps[];
 extern const char kIExampleInterfaceJava[];
 
+extern const char kIPrimitiveListsClass[];
+extern const char kIPrimitiveListsContents[];
+extern const char kIPrimitiveListsJava[];
+
+extern const char kIClassLoadersClass[];
+extern const char kIClassLoadersContents[];
+extern const char kIClassLoadersJava[];
+
 }  // namespace test_data
 }  // namespace aidl
 #endif // AIDL_TESTS_TEST_DATA_H_
@@ -0,0 +1,166 @@
+/*
+ * Copyright (C) 2015, The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "trace.h"
+
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <base/stringprintf.h>
+
+#include "code_writer.h"
+
+using android::base::StringAppendF;
+using std::cerr;
+using std::endl;
+using std::string;
+using std::vector;
+
+namespace android {
+namespace aidl {
+namespace trace {
+namespace {
+
+struct Event {
+  const char* name;
+  string detail;
+  uint64_t start_us;
+  uint64_t duration_us;
+  int thread_id;
+};
+
+std::atomic<bool> enabled{false};
+std::mutex events_lock;
+vector<Event> events;
+std::map<std::thread::id, int> thread_ids;
+std::chrono::steady_clock::time_point start_time;
+
+uint64_t NowMicros() {
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+      std::chrono::steady_clock::now() - start_time).count();
+}
+
+// Trace viewers want small, stable thread ids; number threads in the order
+// we first see them.  Caller must hold |events_lock|.
+int CurrentThreadId() {
+  auto it = thread_ids.find(std::this_thread::get_id());
+  if (it != thread_ids.end()) {
+    return it->second;
+  }
+  int id = thread_ids.size() + 1;
+  thread_ids[std::this_thread::get_id()] = id;
+  return id;
+}
+
+// JSON strings may not contain quotes, backslashes or control characters
+// unescaped.
+string EscapeJson(const string& str) {
+  string result;
+  for (char c : str) {
+    if (c == '"' || c == '\\') {
+      result += '\\';
+      result += c;
+    } else if (c == '\n') {
+      result += "\\n";
+    } else if (c == '\t') {
+      result += "\\t";
+    } else if (static_cast<unsigned char>(c) < 0x20) {
+      StringAppendF(&result, "\\u%04x", static_cast<unsigned char>(c));
+    } else {
+      result += c;
+    }
+  }
+  return result;
+}
+
+}  // namespace
+
+void Enable() {
+  std::lock_guard<std::mutex> guard(events_lock);
+  if (!enabled) {
+    start_time = std::chrono::steady_clock::now();
+    enabled = true;
+  }
+}
+
+bool IsEnabled() {
+  return enabled;
+}
+
+bool WriteTrace(const string& file_path, const IoDelegate& io_delegate) {
+  CodeWriterPtr writer = io_delegate.GetCodeWriter(file_path);
+  if (!writer) {
+    cerr << "Could not open trace file: " << file_path << endl;
+    return false;
+  }
+
+  std::lock_guard<std::mutex> guard(events_lock);
+  bool success = writer->Write("{\"traceEvents\":[");
+  bool first = true;
+  for (const Event& event : events) {
+    success &= writer->Write(
+        "%s\n{\"name\":\"%s\",\"cat\":\"aidl\",\"ph\":\"X\",\"pid\":1,"
+        "\"tid\":%d,\"ts\":%llu,\"dur\":%llu",
+        (first) ? "" : ",", event.name, event.thread_id,
+        static_cast<unsigned long long>(event.start_us),
+        static_cast<unsigned long long>(event.duration_us));
+    if (!event.detail.empty()) {
+      success &= writer->Write(",\"args\":{\"detail\":\"%s\"}",
+                               EscapeJson(event.detail).c_str());
+    }
+    success &= writer->Write("}");
+    first = false;
+  }
+  success &= writer->Write("\n],\"displayTimeUnit\":\"ms\"}\n");
+  return success;
+}
+
+ScopedTrace::ScopedTrace(const char* name)
+    : name_(name),
+      enabled_(enabled.load(std::memory_order_relaxed)) {
+  if (enabled_) {
+    start_us_ = NowMicros();
+  }
+}
+
+ScopedTrace::ScopedTrace(const char* name, const string& detail)
+    : name_(name),
+      enabled_(enabled.load(std::memory_order_relaxed)) {
+  if (enabled_) {
+    detail_ = detail;
+    start_us_ = NowMicros();
+  }
+}
+
+ScopedTrace::~ScopedTrace() {
+  if (!enabled_) {
+    return;
+  }
+  const uint64_t end_us = NowMicros();
+  std::lock_guard<std::mutex> guard(events_lock);
+  events.push_back(
+      {name_, std::move(detail_), start_us_, end_us - start_us_,
+       CurrentThreadId()});
+}
+
+}  // namespace trace
+}  // namespace aidl
+}  // namespace android
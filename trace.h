@@ -0,0 +1,63 @@
+/*
+ * Copyright (C) 2015, The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef AIDL_TRACE_H_
+#define AIDL_TRACE_H_
+
+#include <cstdint>
+#include <string>
+
+#include <base/macros.h>
+
+#include "io_delegate.h"
+
+namespace android {
+namespace aidl {
+namespace trace {
+
+// Start recording trace events.  Until this is called, ScopedTrace does
+// nothing beyond checking a flag.
+void Enable();
+bool IsEnabled();
+
+// Write every event recorded so far to |file_path| in the Chrome
+// trace-event JSON format, which both chrome://tracing and Perfetto load.
+bool WriteTrace(const std::string& file_path, const IoDelegate& io_delegate);
+
+// Records a complete event covering the lifetime of this object, tagged
+// with the calling thread.  |name| must be a string literal.  |detail|, if
+// given (usually a file or class name), is attached to the event as an
+// argument.
+class ScopedTrace {
+ public:
+  explicit ScopedTrace(const char* name);
+  ScopedTrace(const char* name, const std::string& detail);
+  ~ScopedTrace();
+
+ private:
+  const char* name_;
+  std::string detail_;
+  bool enabled_;
+  uint64_t start_us_ = 0;
+
+  DISALLOW_COPY_AND_ASSIGN(ScopedTrace);
+};
+
+}  // namespace trace
+}  // namespace aidl
+}  // namespace android
+
+#endif  // AIDL_TRACE_H_
@@ -0,0 +1,82 @@
+/*
+ * Copyright (C) 2015, The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include "tests/fake_io_delegate.h"
+#include "trace.h"
+
+using android::aidl::test::FakeIoDelegate;
+using std::string;
+
+namespace android {
+namespace aidl {
+namespace trace {
+
+// Events are recorded process wide, so the trace may hold events from
+// other tests too.
+TEST(TraceTest, WritesEventsAsJson) {
+  Enable();
+  ASSERT_TRUE(IsEnabled());
+  {
+    ScopedTrace outer("trace_test_outer");
+    ScopedTrace inner("trace_test_inner", "p/IFoo.aidl");
+  }
+
+  FakeIoDelegate io_delegate;
+  ASSERT_TRUE(WriteTrace("out/trace.json", io_delegate));
+  string trace;
+  ASSERT_TRUE(io_delegate.GetWrittenContents("out/trace.json", &trace));
+  EXPECT_EQ(0u, trace.find("{\"traceEvents\":["));
+  EXPECT_NE(string::npos, trace.find(
+      "{\"name\":\"trace_test_outer\",\"cat\":\"aidl\",\"ph\":\"X\","
+      "\"pid\":1,\"tid\":"));
+  EXPECT_NE(string::npos, trace.find(
+      ",\"args\":{\"detail\":\"p/IFoo.aidl\"}}"));
+  // The inner event ends first, so it is recorded first.
+  EXPECT_LT(trace.find("trace_test_inner"), trace.find("trace_test_outer"));
+  const string end = "\n],\"displayTimeUnit\":\"ms\"}\n";
+  ASSERT_GE(trace.size(), end.size());
+  EXPECT_EQ(end, trace.substr(trace.size() - end.size()));
+}
+
+TEST(TraceTest, EscapesDetails) {
+  Enable();
+  {
+    ScopedTrace event("trace_test_escapes",
+                      "a \"quoted\\path\"\nwith\ttabs\x01\x1f");
+  }
+
+  FakeIoDelegate io_delegate;
+  ASSERT_TRUE(WriteTrace("out/trace.json", io_delegate));
+  string trace;
+  ASSERT_TRUE(io_delegate.GetWrittenContents("out/trace.json", &trace));
+  EXPECT_NE(string::npos, trace.find(
+      "\"detail\":\"a \\\"quoted\\\\path\\\"\\nwith\\ttabs\\u0001\\u001f\""));
+  // Nothing in the file is a raw control character but the line breaks
+  // between events.
+  for (char c : trace) {
+    if (c != '\n') {
+      EXPECT_GE(static_cast<unsigned char>(c), 0x20);
+    }
+  }
+}
+
+}  // namespace trace
+}  // namespace aidl
+}  // namespace android
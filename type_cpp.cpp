@@ -17,6 +17,7 @@
 #include "type_cpp.h"
 
 #include "logging.h"
+#include "stats.h"
 
 using std::string;
 using std::unique_ptr;
@@ -45,6 +46,7 @@ Type::Type(const string& aidl_type,
       cpp_type_(cpp_type),
       parcel_read_method_(read_method),
       parcel_write_method_(write_method) {
+  stats::Increment(stats::CPP_TYPES_CREATED);
 }
 
 bool Type::CanBeArray() const { return false; }
@@ -90,13 +92,14 @@ bool TypeNamespace::AddBinderType(const AidlInterface* b,
   return true;
 }
 
-bool TypeNamespace::AddContainerType(const string& type_name) {
+bool TypeNamespace::AddContainerType(const AidlType& type) {
   // TODO Support container types b/24470786
   LOG(ERROR) << "Passing container is unimplemented in C++ generation.";
   return true;
 }
 
 const Type* TypeNamespace::Find(const string& type_name) const {
+  stats::Increment(stats::TYPE_LOOKUPS);
   Type* ret = nullptr;
   for (const unique_ptr<Type>& type : types_) {
     if (type->AidlType() == type_name) {
@@ -68,9 +68,12 @@ class TypeNamespace : public ::android::aidl::TypeNamespace {
                          const std::string& filename) override;
   bool AddBinderType(const AidlInterface* b,
                      const std::string& filename) override;
-  bool AddContainerType(const std::string& type_name) override;
+  bool AddContainerType(const AidlType& type) override;
 
   const Type* Find(const std::string& type_name) const;
+  const Type* Find(const AidlType& type) const {
+    return Find(type.GetName());
+  }
 
   const Type* VoidType() const { return void_type_; }
 
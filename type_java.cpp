@@ -22,9 +22,9 @@
 
 #include "aidl_language.h"
 #include "logging.h"
+#include "stats.h"
 
 using android::base::Split;
-using android::base::Join;
 using android::base::Trim;
 
 namespace android {
@@ -50,6 +50,7 @@ Type::Type(const JavaTypeNamespace* types, const string& name, int kind,
       m_canWriteToParcel(canWriteToParcel),
       m_canBeOut(canBeOut) {
   m_qualifiedName = name;
+  stats::Increment(stats::JAVA_TYPES_CREATED);
 }
 
 Type::Type(const JavaTypeNamespace* types, const string& package,
@@ -68,6 +69,7 @@ Type::Type(const JavaTypeNamespace* types, const string& package,
     m_qualifiedName += '.';
   }
   m_qualifiedName += name;
+  stats::Increment(stats::JAVA_TYPES_CREATED);
 }
 
 Type::~Type() {}
@@ -85,6 +87,19 @@ string Type::HumanReadableKind() const {
 
 bool Type::CanBeArray() const { return false; }
 
+MarshalledSize Type::GetMarshalledSize() const {
+  return MarshalledSize::AtLeast(4);
+}
+
+MarshalledSize Type::GetArrayMarshalledSize() const {
+  // A null array is written as a length of -1.
+  return MarshalledSize::AtLeast(4);
+}
+
+bool Type::IsCollection() const { return false; }
+
+const Type* Type::UnboxedType() const { return nullptr; }
+
 string Type::ImportType() const { return m_qualifiedName; }
 
 string Type::CreatorName() const { return ""; }
@@ -181,6 +196,18 @@ void BasicType::CreateFromParcel(StatementBlock* addTo, Variable* v,
 
 bool BasicType::CanBeArray() const { return true; }
 
+MarshalledSize BasicType::GetMarshalledSize() const {
+  // Parcel pads everything to four bytes, so only the 64 bit types are
+  // bigger than that.
+  if (m_marshallParcel == "writeLong" || m_marshallParcel == "writeDouble") {
+    return MarshalledSize::Fixed(8);
+  }
+  if (m_marshallParcel == "XXX") {
+    return MarshalledSize::Fixed(0);  // void
+  }
+  return MarshalledSize::Fixed(4);
+}
+
 void BasicType::WriteArrayToParcel(StatementBlock* addTo, Variable* v,
                                    Variable* parcel, int flags) const {
   addTo->Add(new MethodCall(parcel, m_writeArrayParcel, 1, v));
@@ -217,6 +244,10 @@ void BooleanType::CreateFromParcel(StatementBlock* addTo, Variable* v,
 
 bool BooleanType::CanBeArray() const { return true; }
 
+MarshalledSize BooleanType::GetMarshalledSize() const {
+  return MarshalledSize::Fixed(4);
+}
+
 void BooleanType::WriteArrayToParcel(StatementBlock* addTo, Variable* v,
                                      Variable* parcel, int flags) const {
   addTo->Add(new MethodCall(parcel, "writeBooleanArray", 1, v));
@@ -250,6 +281,10 @@ void CharType::CreateFromParcel(StatementBlock* addTo, Variable* v,
 
 bool CharType::CanBeArray() const { return true; }
 
+MarshalledSize CharType::GetMarshalledSize() const {
+  return MarshalledSize::Fixed(4);
+}
+
 void CharType::WriteArrayToParcel(StatementBlock* addTo, Variable* v,
                                   Variable* parcel, int flags) const {
   addTo->Add(new MethodCall(parcel, "writeCharArray", 1, v));
@@ -390,6 +425,12 @@ void RuntimeExceptionType::CreateFromParcel(StatementBlock* addTo, Variable* v,
 IBinderType::IBinderType(const JavaTypeNamespace* types)
     : Type(types, "android.os", "IBinder", BUILT_IN, true, false) {}
 
+// Binders are written as a flat_binder_object, even when null.  That is
+// 24 bytes with a 64 bit kernel.
+MarshalledSize IBinderType::GetMarshalledSize() const {
+  return MarshalledSize::Fixed(24);
+}
+
 void IBinderType::WriteToParcel(StatementBlock* addTo, Variable* v,
                                 Variable* parcel, int flags) const {
   addTo->Add(new MethodCall(parcel, "writeStrongBinder", 1, v));
@@ -496,6 +537,8 @@ void ParcelableInterfaceType::CreateFromParcel(StatementBlock* addTo,
 MapType::MapType(const JavaTypeNamespace* types)
     : Type(types, "java.util", "Map", BUILT_IN, true, true) {}
 
+bool MapType::IsCollection() const { return true; }
+
 void MapType::WriteToParcel(StatementBlock* addTo, Variable* v,
                             Variable* parcel, int flags) const {
   addTo->Add(new MethodCall(parcel, "writeMap", 1, v));
@@ -532,6 +575,8 @@ ListType::ListType(const JavaTypeNamespace* types)
 
 string ListType::InstantiableName() const { return "java.util.ArrayList"; }
 
+bool ListType::IsCollection() const { return true; }
+
 void ListType::WriteToParcel(StatementBlock* addTo, Variable* v,
                              Variable* parcel, int flags) const {
   addTo->Add(new MethodCall(parcel, "writeList", 1, v));
@@ -653,6 +698,10 @@ InterfaceType::InterfaceType(const JavaTypeNamespace* types,
 
 bool InterfaceType::OneWay() const { return m_oneway; }
 
+MarshalledSize InterfaceType::GetMarshalledSize() const {
+  return m_types->IBinderType()->GetMarshalledSize();
+}
+
 void InterfaceType::WriteToParcel(StatementBlock* addTo, Variable* v,
                                   Variable* parcel, int flags) const {
   // parcel.writeStrongBinder(v != null ? v.asBinder() : null);
@@ -673,6 +722,15 @@ void InterfaceType::CreateFromParcel(StatementBlock* addTo, Variable* v,
 
 // ================================================================
 
+BoxedType::BoxedType(const JavaTypeNamespace* types, const string& name,
+                     const Type* primitive)
+    : Type(types, "java.lang", name, BUILT_IN, false, false),
+      m_primitive(primitive) {}
+
+const Type* BoxedType::UnboxedType() const { return m_primitive; }
+
+// ================================================================
+
 GenericType::GenericType(const JavaTypeNamespace* types, const string& package,
                          const string& name, const vector<const Type*>& args)
     : Type(types, package, name, BUILT_IN, true, true) {
@@ -702,6 +760,8 @@ string GenericType::GenericArguments() const { return m_genericArguments; }
 
 string GenericType::ImportType() const { return m_importName; }
 
+bool GenericType::IsCollection() const { return true; }
+
 void GenericType::WriteToParcel(StatementBlock* addTo, Variable* v,
                                 Variable* parcel, int flags) const {
   fprintf(stderr, "implement GenericType::WriteToParcel\n");
@@ -776,6 +836,301 @@ void GenericListType::ReadFromParcel(StatementBlock* addTo, Variable* v,
 
 // ================================================================
 
+// Collections marshalled without Parcel.writeValue() size what they allocate
+// from the size the other side sent, but allocate no more than this up
+// front, however many elements the size claims.
+static const char kMaxPreallocatedElements[] = "65536";
+
+// A boxed primitive |v| in a collection may be null, so it is marshalled as
+// a marker, 0 for null and 1 otherwise, followed by the primitive.  That is
+// no bigger than the type tag Parcel.writeValue() would write instead.
+static void WriteBoxedToParcel(StatementBlock* addTo, Variable* v,
+                               const Type* primitive, Variable* parcel,
+                               int flags) {
+  // if (v == null) {
+  //   parcel.writeInt(0);
+  // } else {
+  //   parcel.writeInt(1);
+  //   parcel.writeInt(v);
+  // }
+  IfStatement* ifNull = new IfStatement;
+  ifNull->expression = new Comparison(v, "==", NULL_VALUE);
+  ifNull->statements->Add(
+      new MethodCall(parcel, "writeInt", 1, new LiteralExpression("0")));
+  IfStatement* ifNotNull = new IfStatement;
+  ifNotNull->statements->Add(
+      new MethodCall(parcel, "writeInt", 1, new LiteralExpression("1")));
+  primitive->WriteToParcel(ifNotNull->statements, v, parcel, flags);
+  ifNull->elseif = ifNotNull;
+  addTo->Add(ifNull);
+}
+
+static void CreateBoxedFromParcel(StatementBlock* addTo, Variable* v,
+                                  const Type* primitive, Variable* parcel) {
+  // if ((0!=parcel.readInt())) {
+  //   v = parcel.readInt();
+  // } else {
+  //   v = null;
+  // }
+  IfStatement* ifNotNull = new IfStatement;
+  ifNotNull->expression = new Comparison(new LiteralExpression("0"), "!=",
+                                         new MethodCall(parcel, "readInt"));
+  primitive->CreateFromParcel(ifNotNull->statements, v, parcel, nullptr);
+  IfStatement* ifNull = new IfStatement;
+  ifNull->statements->Add(new Assignment(v, NULL_VALUE));
+  ifNotNull->elseif = ifNull;
+  addTo->Add(ifNotNull);
+}
+
+// The capacity for a collection the other side says has |size| elements.
+static Expression* PreallocatedCapacity(Variable* size,
+                                        const JavaTypeNamespace* types) {
+  return new MethodCall(
+      new Type(types, "java.lang.Math", Type::BUILT_IN, false, false), "min", 2,
+      size, new LiteralExpression(kMaxPreallocatedElements));
+}
+
+// ================================================================
+
+PrimitiveListType::PrimitiveListType(const JavaTypeNamespace* types,
+                                     const string& package, const string& name,
+                                     const vector<const Type*>& args)
+    : GenericListType(types, package, name, args),
+      m_boxed(args[0]),
+      m_primitive(args[0]->UnboxedType()) {}
+
+void PrimitiveListType::WriteToParcel(StatementBlock* addTo, Variable* v,
+                                      Variable* parcel, int flags) const {
+  // if (v == null) {
+  //   parcel.writeInt(-1);
+  // } else {
+  //   parcel.writeInt(v.size());
+  //   for (java.lang.Integer _item : v) {
+  //     ...
+  //   }
+  // }
+  IfStatement* ifNull = new IfStatement;
+  ifNull->expression = new Comparison(v, "==", NULL_VALUE);
+  ifNull->statements->Add(
+      new MethodCall(parcel, "writeInt", 1, new LiteralExpression("-1")));
+  IfStatement* ifNotNull = new IfStatement;
+  ifNotNull->statements->Add(
+      new MethodCall(parcel, "writeInt", 1, new MethodCall(v, "size")));
+  ForEachStatement* loop = new ForEachStatement;
+  loop->variable = new Variable(m_boxed, "_item");
+  loop->collection = v;
+  WriteBoxedToParcel(loop->statements, loop->variable, m_primitive, parcel,
+                     flags);
+  ifNotNull->statements->Add(loop);
+  ifNull->elseif = ifNotNull;
+  addTo->Add(ifNull);
+}
+
+void PrimitiveListType::CreateFromParcel(StatementBlock* addTo, Variable* v,
+                                         Variable* parcel, Variable**) const {
+  // {
+  //   int _size = parcel.readInt();
+  //   if (_size < 0) {
+  //     v = null;
+  //   } else {
+  //     v = new java.util.ArrayList<java.lang.Integer>(
+  //         java.lang.Math.min(_size, 65536));
+  //     ...
+  //   }
+  // }
+  StatementBlock* block = new StatementBlock;
+  Variable* size = new Variable(m_types->IntType(), "_size");
+  block->Add(new VariableDeclaration(size, new MethodCall(parcel, "readInt")));
+  IfStatement* ifNull = new IfStatement;
+  ifNull->expression = new Comparison(size, "<", new LiteralExpression("0"));
+  ifNull->statements->Add(new Assignment(v, NULL_VALUE));
+  IfStatement* ifNotNull = new IfStatement;
+  ifNotNull->statements->Add(new Assignment(v, new NewExpression(this, 1,
+      PreallocatedCapacity(size, m_types))));
+  ReadElements(ifNotNull->statements, v, size, parcel);
+  ifNull->elseif = ifNotNull;
+  block->Add(ifNull);
+  addTo->Add(block);
+}
+
+void PrimitiveListType::ReadFromParcel(StatementBlock* addTo, Variable* v,
+                                       Variable* parcel, Variable**) const {
+  // {
+  //   int _size = parcel.readInt();
+  //   v.clear();
+  //   ...
+  // }
+  StatementBlock* block = new StatementBlock;
+  Variable* size = new Variable(m_types->IntType(), "_size");
+  block->Add(new VariableDeclaration(size, new MethodCall(parcel, "readInt")));
+  block->Add(new MethodCall(v, "clear"));
+  ReadElements(block, v, size, parcel);
+  addTo->Add(block);
+}
+
+void PrimitiveListType::ReadElements(StatementBlock* addTo, Variable* v,
+                                     Variable* size, Variable* parcel) const {
+  // while (v.size() < _size) {
+  //   java.lang.Integer _item;
+  //   ...
+  //   v.add(_item);
+  // }
+  WhileStatement* loop = new WhileStatement;
+  loop->expression = new Comparison(new MethodCall(v, "size"), "<", size);
+  Variable* item = new Variable(m_boxed, "_item");
+  loop->statements->Add(new VariableDeclaration(item));
+  CreateBoxedFromParcel(loop->statements, item, m_primitive, parcel);
+  loop->statements->Add(new MethodCall(v, "add", 1, item));
+  addTo->Add(loop);
+}
+
+// ================================================================
+
+// Boxed primitive keys and values are marshalled as the primitives.
+static void WriteEntryPartToParcel(StatementBlock* addTo, Variable* v,
+                                   Variable* parcel, int flags) {
+  const Type* unboxed = v->type->UnboxedType();
+  if (unboxed != nullptr) {
+    WriteBoxedToParcel(addTo, v, unboxed, parcel, flags);
+  } else {
+    v->type->WriteToParcel(addTo, v, parcel, flags);
+  }
+}
+
+static void CreateEntryPartFromParcel(StatementBlock* addTo, Variable* v,
+                                      Variable* parcel) {
+  const Type* unboxed = v->type->UnboxedType();
+  if (unboxed != nullptr) {
+    CreateBoxedFromParcel(addTo, v, unboxed, parcel);
+  } else {
+    v->type->CreateFromParcel(addTo, v, parcel, nullptr);
+  }
+}
+
+GenericMapType::GenericMapType(const JavaTypeNamespace* types,
+                               const string& package, const string& name,
+                               const vector<const Type*>& args)
+    : GenericType(types, package, name, args),
+      m_key(args[0]),
+      m_value(args[1]) {}
+
+string GenericMapType::InstantiableName() const {
+  return "java.util.HashMap" + GenericArguments();
+}
+
+void GenericMapType::WriteToParcel(StatementBlock* addTo, Variable* v,
+                                   Variable* parcel, int flags) const {
+  // if (v == null) {
+  //   parcel.writeInt(-1);
+  // } else {
+  //   parcel.writeInt(v.size());
+  //   for (java.util.Map.Entry<K,V> _entry : v.entrySet()) {
+  //     K _key = _entry.getKey();
+  //     V _value = _entry.getValue();
+  //     ...
+  //   }
+  // }
+  IfStatement* ifNull = new IfStatement;
+  ifNull->expression = new Comparison(v, "==", NULL_VALUE);
+  ifNull->statements->Add(
+      new MethodCall(parcel, "writeInt", 1, new LiteralExpression("-1")));
+  IfStatement* ifNotNull = new IfStatement;
+  ifNotNull->statements->Add(
+      new MethodCall(parcel, "writeInt", 1, new MethodCall(v, "size")));
+  ForEachStatement* loop = new ForEachStatement;
+  loop->variable = new Variable(
+      new Type(m_types, "java.util.Map.Entry" + GenericArguments(),
+               BUILT_IN, false, false),
+      "_entry");
+  loop->collection = new MethodCall(v, "entrySet");
+  Variable* key = new Variable(m_key, "_key");
+  Variable* value = new Variable(m_value, "_value");
+  loop->statements->Add(new VariableDeclaration(
+      key, new MethodCall(loop->variable, "getKey")));
+  loop->statements->Add(new VariableDeclaration(
+      value, new MethodCall(loop->variable, "getValue")));
+  WriteEntryPartToParcel(loop->statements, key, parcel, flags);
+  WriteEntryPartToParcel(loop->statements, value, parcel, flags);
+  ifNotNull->statements->Add(loop);
+  ifNull->elseif = ifNotNull;
+  addTo->Add(ifNull);
+}
+
+void GenericMapType::CreateFromParcel(StatementBlock* addTo, Variable* v,
+                                      Variable* parcel, Variable**) const {
+  // {
+  //   int _size = parcel.readInt();
+  //   if (_size < 0) {
+  //     v = null;
+  //   } else {
+  //     v = new java.util.HashMap<K,V>(
+  //         java.lang.Math.min(_size, 65536) * 4 / 3 + 1);
+  //     ...
+  //   }
+  // }
+  StatementBlock* block = new StatementBlock;
+  Variable* size = new Variable(m_types->IntType(), "_size");
+  block->Add(new VariableDeclaration(size, new MethodCall(parcel, "readInt")));
+  IfStatement* ifNull = new IfStatement;
+  ifNull->expression = new Comparison(size, "<", new LiteralExpression("0"));
+  ifNull->statements->Add(new Assignment(v, NULL_VALUE));
+  IfStatement* ifNotNull = new IfStatement;
+  // Big enough to hold the preallocated entries at HashMap's default load
+  // factor.  The capacity is at most 87382, so this can't overflow.
+  ifNotNull->statements->Add(new Assignment(v, new NewExpression(this, 1,
+      new Comparison(new Comparison(new Comparison(
+                         PreallocatedCapacity(size, m_types), "*",
+                         new LiteralExpression("4")),
+                     "/", new LiteralExpression("3")),
+                     "+", new LiteralExpression("1")))));
+  ReadEntries(ifNotNull->statements, v, size, parcel);
+  ifNull->elseif = ifNotNull;
+  block->Add(ifNull);
+  addTo->Add(block);
+}
+
+void GenericMapType::ReadFromParcel(StatementBlock* addTo, Variable* v,
+                                    Variable* parcel, Variable**) const {
+  // {
+  //   int _size = parcel.readInt();
+  //   v.clear();
+  //   ...
+  // }
+  StatementBlock* block = new StatementBlock;
+  Variable* size = new Variable(m_types->IntType(), "_size");
+  block->Add(new VariableDeclaration(size, new MethodCall(parcel, "readInt")));
+  block->Add(new MethodCall(v, "clear"));
+  ReadEntries(block, v, size, parcel);
+  addTo->Add(block);
+}
+
+void GenericMapType::ReadEntries(StatementBlock* addTo, Variable* v,
+                                 Variable* size, Variable* parcel) const {
+  // while (_size > 0) {
+  //   K _key;
+  //   _key = parcel.readK();
+  //   V _value;
+  //   _value = parcel.readV();
+  //   v.put(_key, _value);
+  //   _size--;
+  // }
+  // Counted rather than checked against v.size(), which a repeated key
+  // would not grow.
+  WhileStatement* loop = new WhileStatement;
+  loop->expression = new Comparison(size, ">", new LiteralExpression("0"));
+  Variable* key = new Variable(m_key, "_key");
+  Variable* value = new Variable(m_value, "_value");
+  loop->statements->Add(new VariableDeclaration(key));
+  CreateEntryPartFromParcel(loop->statements, key, parcel);
+  loop->statements->Add(new VariableDeclaration(value));
+  CreateEntryPartFromParcel(loop->statements, value, parcel);
+  loop->statements->Add(new MethodCall(v, "put", 2, key, value));
+  loop->statements->Add(new LiteralExpression("_size--"));
+  addTo->Add(loop);
+}
+
+// ================================================================
+
 ClassLoaderType::ClassLoaderType(const JavaTypeNamespace* types)
     : Type(types, "java.lang", "ClassLoader", BUILT_IN, false, false) {}
 
@@ -820,6 +1175,12 @@ JavaTypeNamespace::JavaTypeNamespace() {
 
   Add(new Type(this, "java.lang", "Object", Type::BUILT_IN, false, false));
 
+  Add(new BoxedType(this, "Boolean", m_bool_type));
+  Add(new BoxedType(this, "Integer", m_int_type));
+  Add(new BoxedType(this, "Long", Find("long")));
+  Add(new BoxedType(this, "Float", Find("float")));
+  Add(new BoxedType(this, "Double", Find("double")));
+
   Add(new CharSequenceType(this));
 
   Add(new MapType(this));
@@ -871,6 +1232,27 @@ JavaTypeNamespace::JavaTypeNamespace() {
   m_containers.emplace_back("java.util", "Map", 2);
 }
 
+JavaTypeNamespace::JavaTypeNamespace(const JavaTypeNamespace* base)
+    : m_base(base) {
+  if (!base->IsFrozen()) {
+    LOG(FATAL) << "Layering a type namespace over a mutable one.";
+  }
+  m_bool_type = base->m_bool_type;
+  m_int_type = base->m_int_type;
+  m_string_type = base->m_string_type;
+  m_text_utils_type = base->m_text_utils_type;
+  m_remote_exception_type = base->m_remote_exception_type;
+  m_runtime_exception_type = base->m_runtime_exception_type;
+  m_ibinder_type = base->m_ibinder_type;
+  m_iinterface_type = base->m_iinterface_type;
+  m_binder_native_type = base->m_binder_native_type;
+  m_binder_proxy_type = base->m_binder_proxy_type;
+  m_parcel_type = base->m_parcel_type;
+  m_parcelable_interface_type = base->m_parcelable_interface_type;
+  m_context_type = base->m_context_type;
+  m_classloader_type = base->m_classloader_type;
+}
+
 JavaTypeNamespace::~JavaTypeNamespace() {
   int N = m_types.size();
   for (int i = 0; i < N; i++) {
@@ -879,9 +1261,18 @@ JavaTypeNamespace::~JavaTypeNamespace() {
 }
 
 bool JavaTypeNamespace::Add(const Type* type) {
+  if (m_frozen) {
+    fprintf(stderr, "%s:%d attempt to add %s to a frozen type namespace\n",
+            type->DeclFile().c_str(), type->DeclLine(),
+            type->QualifiedName().c_str());
+    return false;
+  }
+
   const Type* existing = Find(type->QualifiedName());
   if (!existing) {
     m_types.push_back(type);
+    m_types_by_qualified_name.emplace(type->QualifiedName(), type);
+    m_types_by_name.emplace(type->Name(), type);
     return true;
   }
 
@@ -906,6 +1297,7 @@ bool JavaTypeNamespace::Add(const Type* type) {
 }
 
 const Type* JavaTypeNamespace::Find(const string& unstripped_name) const {
+  stats::Increment(stats::TYPE_LOOKUPS);
   const ContainerClass* g = nullptr;
   vector<const Type*> template_arg_types;
   if (!CanonicalizeContainerClass(unstripped_name, &g, &template_arg_types)) {
@@ -913,21 +1305,17 @@ const Type* JavaTypeNamespace::Find(const string& unstripped_name) const {
     return nullptr;
   }
 
-  string name = Trim(unstripped_name);
   if (g != nullptr) {
-    vector<string> template_args;
-    for (const Type* type : template_arg_types) {
-      template_args.push_back(type->QualifiedName());
-     }
-    name = g->canonical_name + "<" + Join(template_args, ',') + ">";
-   }
+    return FindContainerType(g, template_arg_types);
+  }
+
+  string name = Trim(unstripped_name);
 
   // Always prefer a exact match if possible.
   // This works for primitives and class names qualified with a package.
-  for (const Type* type : m_types) {
-    if (type->QualifiedName() == name) {
-      return type;
-    }
+  const Type* type = FindByQualifiedName(name);
+  if (type) {
+    return type;
   }
 
   // We allow authors to drop packages when refering to a class name.
@@ -935,13 +1323,59 @@ const Type* JavaTypeNamespace::Find(const string& unstripped_name) const {
   // when referencing an inner class.  that could be changed, and this
   // would be the place to do it, but I don't think the complexity in
   // scoping rules is worth it.
-  for (const Type* type : m_types) {
-    if (type->Name() == name) {
+  return FindByName(name);
+}
+
+const Type* JavaTypeNamespace::Find(const AidlType& aidl_type) const {
+  if (!aidl_type.IsGeneric()) {
+    return Find(aidl_type.GetName());
+  }
+
+  stats::Increment(stats::TYPE_LOOKUPS);
+  const ContainerClass* g = nullptr;
+  vector<const Type*> template_arg_types;
+  if (!ContainerClassOf(aidl_type, &g, &template_arg_types)) {
+    LOG(ERROR) << "Error canonicalizing type '" << aidl_type.GetName() << "'";
+    return nullptr;
+  }
+  return FindContainerType(g, template_arg_types);
+}
+
+const Type* JavaTypeNamespace::FindContainerType(
+    const ContainerClass* container_class,
+    const vector<const Type*>& arg_types) const {
+  if (m_base) {
+    const Type* type = m_base->FindContainerType(container_class, arg_types);
+    if (type) {
       return type;
     }
   }
+  auto it = m_container_types.find(std::make_pair(container_class, arg_types));
+  return (it == m_container_types.end()) ? nullptr : it->second;
+}
 
-  return nullptr;
+const Type* JavaTypeNamespace::FindByQualifiedName(const string& name) const {
+  if (m_base) {
+    const Type* type = m_base->FindByQualifiedName(name);
+    if (type) {
+      return type;
+    }
+  }
+  auto it = m_types_by_qualified_name.find(name);
+  return (it == m_types_by_qualified_name.end()) ? nullptr : it->second;
+}
+
+// Lower layers are searched first, which keeps the first-added type winning
+// when several packages declare the same class name.
+const Type* JavaTypeNamespace::FindByName(const string& name) const {
+  if (m_base) {
+    const Type* type = m_base->FindByName(name);
+    if (type) {
+      return type;
+    }
+  }
+  auto it = m_types_by_name.find(name);
+  return (it == m_types_by_name.end()) ? nullptr : it->second;
 }
 
 const Type* JavaTypeNamespace::Find(const char* package,
@@ -983,30 +1417,50 @@ bool JavaTypeNamespace::AddBinderType(const AidlInterface* b,
   return success;
 }
 
-bool JavaTypeNamespace::AddContainerType(const string& type_name) {
-  if (Find(type_name) != nullptr) {
-    return true;  // Don't add duplicates of the same templated type.
+bool JavaTypeNamespace::AddContainerType(const AidlType& type) {
+  if (!type.IsGeneric()) {
+    // Not a container type.  No error.
+    return true;
   }
 
   const ContainerClass* g = nullptr;
   vector<const Type*> template_arg_types;
-  if (!CanonicalizeContainerClass(type_name, &g, &template_arg_types)) {
-    LOG(ERROR) << "Error canonicalizing type '" << type_name << "'";
+  if (!ContainerClassOf(type, &g, &template_arg_types)) {
+    LOG(ERROR) << "Error canonicalizing type '" << type.GetName() << "'";
     return false;
   }
 
-  if (g == nullptr) {
-    // We parsed the type correctly, but it wasn't a container type.  No error.
-    return true;
+  if (FindContainerType(g, template_arg_types) != nullptr) {
+    return true;  // Don't add duplicates of the same templated type.
   }
 
   // construct an instance of a container type, add it to our name set so they
   // always get the same object, and return it.
   Type* result = nullptr;
   if (g->canonical_name == "java.util.List" &&
-      template_arg_types.size() == 1u) {
+      template_arg_types.size() == 1u &&
+      template_arg_types[0]->UnboxedType() != nullptr) {
+    result = new PrimitiveListType(this, g->package, g->class_name,
+                                   template_arg_types);
+  } else if (g->canonical_name == "java.util.List" &&
+             template_arg_types.size() == 1u) {
     result = new GenericListType(this, g->package, g->class_name,
                                  template_arg_types);
+  } else if (g->canonical_name == "java.util.Map" &&
+             template_arg_types.size() == 2u) {
+    for (const Type* arg : template_arg_types) {
+      // Raw collections need a class loader to read, and primitives can't
+      // be type arguments.
+      if (arg->UnboxedType() == nullptr &&
+          (!arg->CanWriteToParcel() || arg->IsCollection() ||
+           (arg->Kind() == Type::BUILT_IN && arg->Package().empty()))) {
+        LOG(ERROR) << "Can't marshal " << arg->QualifiedName()
+                   << " as a key or value of " << type.GetName();
+        return false;
+      }
+    }
+    result = new GenericMapType(this, g->package, g->class_name,
+                                template_arg_types);
   } else {
     LOG(ERROR) << "Don't know how to create a container of type "
                << g->canonical_name << " with " << template_arg_types.size()
@@ -1014,18 +1468,36 @@ bool JavaTypeNamespace::AddContainerType(const string& type_name) {
     return false;
   }
 
-  Add(result);
+  if (!Add(result)) {
+    return false;
+  }
+  m_container_types[std::make_pair(g, template_arg_types)] = result;
   return true;
 }
 
+bool JavaTypeNamespace::CanBeLazy(const AidlType& type) const {
+  // Only parcelables can be left in the Parcel and read on first use.
+  const Type* t = Find(type);
+  return t != nullptr && t->Kind() == Type::USERDATA;
+}
+
 const ValidatableType* JavaTypeNamespace::GetValidatableType(
     const string& name) const {
   return Find(name);
 }
 
+const ValidatableType* JavaTypeNamespace::GetValidatableTypeOf(
+    const AidlType& type) const {
+  return Find(type);
+}
+
 const JavaTypeNamespace::ContainerClass* JavaTypeNamespace::FindContainerClass(
     const string& name,
     size_t nargs) const {
+  if (m_base) {
+    return m_base->FindContainerClass(name, nargs);
+  }
+
   // first check fully qualified class names (with packages).
   for (const ContainerClass& container : m_containers) {
     if (container.canonical_name == name && nargs == container.args) {
@@ -1043,6 +1515,34 @@ const JavaTypeNamespace::ContainerClass* JavaTypeNamespace::FindContainerClass(
   return nullptr;
 }
 
+bool JavaTypeNamespace::ContainerClassOf(
+    const AidlType& type,
+    const ContainerClass** container_class,
+    vector<const Type*>* arg_types) const {
+  const vector<string>& template_args = type.GetTypeParameters();
+  const ContainerClass* g =
+      FindContainerClass(type.GetBaseName(), template_args.size());
+  if (g == nullptr) {
+    LOG(ERROR) << "Failed to find templated container '"
+               << type.GetBaseName() << "'";
+    return false;
+  }
+
+  arg_types->clear();
+  for (const string& template_arg : template_args) {
+    const Type* template_arg_type = Find(template_arg);
+    if (template_arg_type == nullptr) {
+      LOG(ERROR) << "Failed to find formal type of '"
+                 << template_arg << "'";
+      return false;
+    }
+    arg_types->push_back(template_arg_type);
+  }
+
+  *container_class = g;
+  return true;
+}
+
 bool JavaTypeNamespace::CanonicalizeContainerClass(
     const string& raw_name,
     const ContainerClass** container_class,
@@ -1096,6 +1596,9 @@ bool JavaTypeNamespace::CanonicalizeContainerClass(
 }
 
 void JavaTypeNamespace::Dump() const {
+  if (m_base) {
+    m_base->Dump();
+  }
   int n = m_types.size();
   for (int i = 0; i < n; i++) {
     const Type* t = m_types[i];
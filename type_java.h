@@ -17,7 +17,10 @@
 #ifndef AIDL_TYPE_JAVA_H_
 #define AIDL_TYPE_JAVA_H_
 
+#include <map>
 #include <string>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 
 #include "ast_java.h"
@@ -32,6 +35,33 @@ class JavaTypeNamespace;
 using std::string;
 using std::vector;
 
+// Bounds on the number of bytes a value takes up in a Parcel.  Values that
+// can be arbitrarily large, like strings and arrays, have no upper bound.
+struct MarshalledSize {
+  size_t min = 0;
+  size_t max = 0;
+  bool bounded = true;
+
+  static MarshalledSize Fixed(size_t bytes) {
+    MarshalledSize size;
+    size.min = size.max = bytes;
+    return size;
+  }
+  static MarshalledSize AtLeast(size_t bytes) {
+    MarshalledSize size;
+    size.min = size.max = bytes;
+    size.bounded = false;
+    return size;
+  }
+
+  MarshalledSize& operator+=(const MarshalledSize& other) {
+    min += other.min;
+    max += other.max;
+    bounded &= other.bounded;
+    return *this;
+  }
+};
+
 class Type : public ValidatableType {
  public:
   // kinds
@@ -77,6 +107,18 @@ class Type : public ValidatableType {
   virtual void ReadArrayFromParcel(StatementBlock* addTo, Variable* v,
                                    Variable* parcel, Variable** cl) const;
 
+  // Bounds on the bytes WriteToParcel adds to a Parcel.  By default a value
+  // is a null marker followed by something opaque, and only the marker is
+  // counted.
+  virtual MarshalledSize GetMarshalledSize() const;
+  // Arrays of any type are a length followed by the elements.
+  MarshalledSize GetArrayMarshalledSize() const;
+  // Whether values are lists or maps of other values.
+  virtual bool IsCollection() const;
+  // The primitive type that this type boxes, if it is one of the boxes
+  // in java.lang, or nullptr.
+  virtual const Type* UnboxedType() const;
+
  protected:
   void SetQualifiedName(const string& qualified);
   Expression* BuildWriteToParcelFlags(int flags) const;
@@ -118,6 +160,8 @@ class BasicType : public Type {
   void ReadArrayFromParcel(StatementBlock* addTo, Variable* v, Variable* parcel,
                            Variable** cl) const override;
 
+  MarshalledSize GetMarshalledSize() const override;
+
  private:
   string m_marshallParcel;
   string m_unmarshallParcel;
@@ -143,6 +187,8 @@ class BooleanType : public Type {
                              Variable* parcel, Variable** cl) const override;
   void ReadArrayFromParcel(StatementBlock* addTo, Variable* v, Variable* parcel,
                            Variable** cl) const override;
+
+  MarshalledSize GetMarshalledSize() const override;
 };
 
 class CharType : public Type {
@@ -162,6 +208,8 @@ class CharType : public Type {
                              Variable* parcel, Variable** cl) const override;
   void ReadArrayFromParcel(StatementBlock* addTo, Variable* v, Variable* parcel,
                            Variable** cl) const override;
+
+  MarshalledSize GetMarshalledSize() const override;
 };
 
 class StringType : public Type {
@@ -232,6 +280,8 @@ class IBinderType : public Type {
                              Variable* parcel, Variable** cl) const override;
   void ReadArrayFromParcel(StatementBlock* addTo, Variable* v, Variable* parcel,
                            Variable** cl) const override;
+
+  MarshalledSize GetMarshalledSize() const override;
 };
 
 class IInterfaceType : public Type {
@@ -294,6 +344,8 @@ class MapType : public Type {
                         Variable** cl) const override;
   void ReadFromParcel(StatementBlock* addTo, Variable* v, Variable* parcel,
                       Variable** cl) const override;
+
+  bool IsCollection() const override;
 };
 
 class ListType : public Type {
@@ -308,6 +360,8 @@ class ListType : public Type {
                         Variable** cl) const override;
   void ReadFromParcel(StatementBlock* addTo, Variable* v, Variable* parcel,
                       Variable** cl) const override;
+
+  bool IsCollection() const override;
 };
 
 class UserDataType : public Type {
@@ -348,10 +402,25 @@ class InterfaceType : public Type {
   void CreateFromParcel(StatementBlock* addTo, Variable* v, Variable* parcel,
                         Variable** cl) const override;
 
+  MarshalledSize GetMarshalledSize() const override;
+
  private:
   bool m_oneway;
 };
 
+// java.lang.Integer and the other boxes of primitive types.  They can't be
+// marshalled on their own, only as the elements of a List.
+class BoxedType : public Type {
+ public:
+  BoxedType(const JavaTypeNamespace* types, const string& name,
+            const Type* primitive);
+
+  const Type* UnboxedType() const override;
+
+ private:
+  const Type* m_primitive;
+};
+
 class GenericType : public Type {
  public:
   GenericType(const JavaTypeNamespace* types, const string& package,
@@ -369,6 +438,8 @@ class GenericType : public Type {
   void ReadFromParcel(StatementBlock* addTo, Variable* v, Variable* parcel,
                       Variable** cl) const override;
 
+  bool IsCollection() const override;
+
  private:
   string m_genericArguments;
   string m_importName;
@@ -399,24 +470,87 @@ class GenericListType : public GenericType {
   string m_creator;
 };
 
+// A List of boxed primitives, marshalled as a length, or -1 for null,
+// followed by the primitives themselves, each behind a marker for null
+// elements.
+class PrimitiveListType : public GenericListType {
+ public:
+  PrimitiveListType(const JavaTypeNamespace* types, const string& package,
+                    const string& name, const vector<const Type*>& args);
+
+  void WriteToParcel(StatementBlock* addTo, Variable* v, Variable* parcel,
+                     int flags) const override;
+  void CreateFromParcel(StatementBlock* addTo, Variable* v, Variable* parcel,
+                        Variable** cl) const override;
+  void ReadFromParcel(StatementBlock* addTo, Variable* v, Variable* parcel,
+                      Variable** cl) const override;
+
+ private:
+  void ReadElements(StatementBlock* addTo, Variable* v, Variable* size,
+                    Variable* parcel) const;
+
+  const Type* m_boxed;
+  const Type* m_primitive;
+};
+
+// A Map with declared key and value types, marshalled as a size, or -1 for
+// null, followed by each key and its value.  Boxed primitives are
+// marshalled as the primitives, each behind a marker for null.  Unlike a
+// raw Map, nothing is written or looked up per entry to find out the types.
+class GenericMapType : public GenericType {
+ public:
+  GenericMapType(const JavaTypeNamespace* types, const string& package,
+                 const string& name, const vector<const Type*>& args);
+
+  string InstantiableName() const override;
+
+  void WriteToParcel(StatementBlock* addTo, Variable* v, Variable* parcel,
+                     int flags) const override;
+  void CreateFromParcel(StatementBlock* addTo, Variable* v, Variable* parcel,
+                        Variable** cl) const override;
+  void ReadFromParcel(StatementBlock* addTo, Variable* v, Variable* parcel,
+                      Variable** cl) const override;
+
+ private:
+  void ReadEntries(StatementBlock* addTo, Variable* v, Variable* size,
+                   Variable* parcel) const;
+
+  const Type* m_key;
+  const Type* m_value;
+};
+
 class JavaTypeNamespace : public TypeNamespace {
  public:
   JavaTypeNamespace();
+  // Creates an empty layer over |base|, which must be frozen and must
+  // outlive this namespace.  Lookups fall through to |base| and new types
+  // are recorded only in this layer, so it is cheap to create one per
+  // compile and discard it afterwards.
+  explicit JavaTypeNamespace(const JavaTypeNamespace* base);
   virtual ~JavaTypeNamespace();
 
   bool AddParcelableType(const AidlParcelable* p,
                          const string& filename) override;
   bool AddBinderType(const AidlInterface* b,
                      const string& filename) override;
-  bool AddContainerType(const string& type_name) override;
+  bool AddContainerType(const AidlType& type) override;
+  bool CanBeLazy(const AidlType& type) const override;
 
   // Search for a type by exact match with |name|.
   const Type* Find(const string& name) const;
+  // Search for a type from the parse tree, using its type parameters
+  // directly rather than parsing its name.
+  const Type* Find(const AidlType& type) const;
   // helper alias for Find(name);
   const Type* Find(const char* package, const char* name) const;
 
   void Dump() const;
 
+  // Refuse to add any more types, so that this namespace may be shared
+  // as the base of other namespaces.
+  void Freeze() { m_frozen = true; }
+  bool IsFrozen() const { return m_frozen; }
+
   const Type* BoolType() const { return m_bool_type; }
   const Type* IntType() const { return m_int_type; }
   const Type* StringType() const { return m_string_type; }
@@ -436,6 +570,8 @@ class JavaTypeNamespace : public TypeNamespace {
 
  protected:
   const ValidatableType* GetValidatableType(const string& name) const override;
+  const ValidatableType* GetValidatableTypeOf(
+      const AidlType& type) const override;
 
  private:
   class ContainerClass final {
@@ -451,16 +587,34 @@ class JavaTypeNamespace : public TypeNamespace {
   };
 
   bool Add(const Type* type);
+  const Type* FindByQualifiedName(const string& name) const;
+  const Type* FindByName(const string& name) const;
 
   // args is the number of template types (what is this called?)
   const ContainerClass* FindContainerClass(const string& name,
                                            size_t nargs) const;
+  bool ContainerClassOf(const AidlType& type,
+                        const ContainerClass** container_class,
+                        vector<const Type*>* arg_types) const;
+  const Type* FindContainerType(const ContainerClass* container_class,
+                                const vector<const Type*>& arg_types) const;
   bool CanonicalizeContainerClass(const string& raw_name,
                                   const ContainerClass** container_class,
                                   vector<const Type*>* arg_types) const;
 
+  const JavaTypeNamespace* m_base{nullptr};
+  bool m_frozen{false};
+  // Only the types added to this layer; those of |m_base| are not copied.
   vector<const Type*> m_types;
+  // Indexes over |m_types|.  When several types share a name the first one
+  // added keeps the slot, matching the order a scan of |m_types| would give.
+  std::unordered_map<string, const Type*> m_types_by_qualified_name;
+  std::unordered_map<string, const Type*> m_types_by_name;
   vector<ContainerClass> m_containers;
+  // Instantiations of |m_containers| added to this layer, keyed by the
+  // container and its type arguments.
+  std::map<std::pair<const ContainerClass*, vector<const Type*>>,
+           const Type*> m_container_types;
 
   const Type* m_bool_type{nullptr};
   const Type* m_int_type{nullptr};
@@ -36,6 +36,19 @@ AidlParcelable* MakeFakeUserDataType(const std::string& package,
   return parcl;
 }
 
+// Returns List<|parameter|> as the parser would build it.
+unique_ptr<AidlType> MakeListType(const std::string& parameter) {
+  return unique_ptr<AidlType>(new AidlType(
+      "List", new std::vector<std::string>{parameter}, 0, ""));
+}
+
+// Returns Map<|key|, |value|> as the parser would build it.
+unique_ptr<AidlType> MakeMapType(const std::string& key,
+                                 const std::string& value) {
+  return unique_ptr<AidlType>(new AidlType(
+      "Map", new std::vector<std::string>{key, value}, 0, ""));
+}
+
 }  // namespace
 
 class JavaTypeNamespaceTest : public ::testing::Test {
@@ -60,9 +73,79 @@ TEST_F(JavaTypeNamespaceTest, ContainerTypeCreation) {
   EXPECT_NE(types_.Find("Foo"), nullptr);
   EXPECT_EQ(types_.Find("List<Foo>"), nullptr);
   // But after we add the list explicitly...
-  EXPECT_TRUE(types_.AddContainerType("List<Foo>"));
+  EXPECT_TRUE(types_.AddContainerType(*MakeListType("Foo")));
   // This should work.
   EXPECT_NE(types_.Find("List<Foo>"), nullptr);
+  // However the type is spelled.
+  EXPECT_EQ(types_.Find("List<Foo>"), types_.Find(*MakeListType("Foo")));
+  EXPECT_EQ(types_.Find("List<Foo>"),
+            types_.Find("java.util.List<a.goog.Foo>"));
+  EXPECT_EQ(types_.Find("List<Foo>"), types_.Find(*MakeListType("a.goog.Foo")));
+}
+
+TEST_F(JavaTypeNamespaceTest, TypedMapCreation) {
+  EXPECT_TRUE(types_.AddContainerType(*MakeMapType("String", "Integer")));
+  const Type* map = types_.Find("Map<String,Integer>");
+  ASSERT_NE(map, nullptr);
+  EXPECT_EQ("java.util.Map<java.lang.String,java.lang.Integer>",
+            map->QualifiedName());
+  EXPECT_EQ("java.util.HashMap<java.lang.String,java.lang.Integer>",
+            map->InstantiableName());
+  // Keys and values must be marshallable on their own, or boxed
+  // primitives.
+  EXPECT_FALSE(types_.AddContainerType(*MakeMapType("String", "int")));
+  EXPECT_FALSE(types_.AddContainerType(*MakeMapType("String", "List")));
+  EXPECT_FALSE(types_.AddContainerType(*MakeMapType("Object", "String")));
+}
+
+TEST_F(JavaTypeNamespaceTest, FrozenNamespaceRejectsNewTypes) {
+  EXPECT_TRUE(types_.AddParcelableType(MakeFakeUserDataType("a.goog", "Foo"),
+                                       __FILE__));
+  EXPECT_TRUE(types_.AddContainerType(*MakeListType("Foo")));
+  types_.Freeze();
+  EXPECT_TRUE(types_.IsFrozen());
+  EXPECT_FALSE(types_.AddParcelableType(MakeFakeUserDataType("a.goog", "Bar"),
+                                        __FILE__));
+  EXPECT_EQ(types_.Find("Bar"), nullptr);
+  // Asking for a container that already exists is not an addition.
+  EXPECT_TRUE(types_.AddContainerType(*MakeListType("Foo")));
+  EXPECT_FALSE(types_.AddContainerType(*MakeListType("String")));
+  EXPECT_EQ(types_.Find("List<String>"), nullptr);
+}
+
+TEST_F(JavaTypeNamespaceTest, OverlayAddsTypesWithoutChangingBase) {
+  EXPECT_TRUE(types_.AddParcelableType(MakeFakeUserDataType("a.goog", "Foo"),
+                                       __FILE__));
+  types_.Freeze();
+
+  JavaTypeNamespace overlay(&types_);
+  // Everything in the base is visible through the overlay, as the same
+  // objects.
+  EXPECT_EQ(types_.Find("int"), overlay.Find("int"));
+  EXPECT_EQ(types_.Find("a.goog.Foo"), overlay.Find("Foo"));
+  EXPECT_EQ(types_.StringType(), overlay.StringType());
+  EXPECT_EQ(types_.ParcelType(), overlay.ParcelType());
+
+  // New types and container instantiations only land in the overlay.
+  EXPECT_TRUE(overlay.AddParcelableType(MakeFakeUserDataType("a.goog", "Bar"),
+                                        __FILE__));
+  EXPECT_TRUE(overlay.AddContainerType(*MakeListType("Foo")));
+  EXPECT_NE(overlay.Find("Bar"), nullptr);
+  EXPECT_NE(overlay.Find("List<Foo>"), nullptr);
+  EXPECT_EQ(types_.Find("Bar"), nullptr);
+  EXPECT_EQ(types_.Find("List<Foo>"), nullptr);
+
+  // Redefinitions of base types are still caught.
+  EXPECT_FALSE(overlay.AddParcelableType(MakeFakeUserDataType("", "int"),
+                                         __FILE__));
+
+  // A second overlay starts from the base alone.
+  JavaTypeNamespace other(&types_);
+  EXPECT_EQ(other.Find("Bar"), nullptr);
+  EXPECT_TRUE(other.AddParcelableType(MakeFakeUserDataType("b.goog", "Bar"),
+                                      __FILE__));
+  EXPECT_NE(other.Find("b.goog.Bar"), nullptr);
+  EXPECT_EQ(overlay.Find("b.goog.Bar"), nullptr);
 }
 
 }  // namespace java
@@ -58,13 +58,22 @@ bool TypeNamespace::HasType(const string& type_name) const {
   return GetValidatableType(type_name) != nullptr;
 }
 
+const ValidatableType* TypeNamespace::GetValidatableTypeOf(
+    const AidlType& type) const {
+  return GetValidatableType(type.GetName());
+}
+
+bool TypeNamespace::CanBeLazy(const AidlType& type) const {
+  return false;
+}
+
 bool TypeNamespace::IsValidReturnType(const AidlType& raw_type,
                                       const string& filename) const {
   const string error_prefix = StringPrintf(
       "In file %s line %d return type %s:\n    ",
       filename.c_str(), raw_type.GetLine(), raw_type.ToString().c_str());
 
-  const ValidatableType* return_type = GetValidatableType(raw_type.GetName());
+  const ValidatableType* return_type = GetValidatableTypeOf(raw_type);
   if (return_type == nullptr) {
     cerr << error_prefix << "unknown return type" << endl;
     return false;
@@ -91,7 +100,7 @@ bool TypeNamespace::IsValidArg(const AidlArgument& a,
       filename.c_str(), a.GetLine(), a.GetName().c_str(), arg_index);
 
   // check the arg type
-  const ValidatableType* t = GetValidatableType(a.GetType().GetName());
+  const ValidatableType* t = GetValidatableTypeOf(a.GetType());
   if (t == nullptr) {
     cerr << error_prefix << "unknown type " << a.GetType().GetName().c_str() << endl;
     return false;
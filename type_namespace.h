@@ -50,7 +50,7 @@ class TypeNamespace {
   // We dynamically create container types as we discover them in the parse
   // tree.  Returns false iff this is an invalid type.  Silently discards
   // duplicates and non-container types.
-  virtual bool AddContainerType(const std::string& type_name) = 0;
+  virtual bool AddContainerType(const AidlType& type) = 0;
 
   // Returns true iff this has a type for |type_name|.
   virtual bool HasType(const std::string& type_name) const;
@@ -64,12 +64,20 @@ class TypeNamespace {
                           int arg_index,
                           const std::string& filename) const;
 
+  // Returns true iff arguments of type |type| can be annotated @Lazy and
+  // unmarshalled only when the implementation asks for them.
+  virtual bool CanBeLazy(const AidlType& type) const;
+
  protected:
   TypeNamespace() = default;
   virtual ~TypeNamespace() = default;
 
   virtual const ValidatableType* GetValidatableType(
       const std::string& name) const = 0;
+  // Looks up a type from the parse tree.  Namespaces that support generic
+  // types can use its type parameters rather than parse its name again.
+  virtual const ValidatableType* GetValidatableTypeOf(
+      const AidlType& type) const;
 
  private:
   DISALLOW_COPY_AND_ASSIGN(TypeNamespace);